@@ -0,0 +1,1561 @@
+//***************************************************************************************
+// ParticleSimBench.cpp
+//
+// 无需GPU的粒子模拟性能测试
+// Headless particle simulation benchmark.
+//***************************************************************************************
+
+#include <ParticleSimCPU.h>
+#include <ParticleKernels.h>
+#include <ParticleSystem.h>
+#include <ParticlePacking.h>
+#include <ParticleSort.h>
+#include <ParticleCull.h>
+#include <ParticleEmitterGrid.h>
+#include <ParticleStepClock.h>
+#include <ParticleStateHash.h>
+#include <ParticleRandom.h>
+#include <JobSystem.h>
+#include <ReadbackRing.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    struct EffectPreset
+    {
+        const char* name;
+        ParticleEffectType type;
+        uint32_t maxParticles;
+        Float3 emitPos;
+        Float3 accel;
+        float emitInterval;
+        float aliveTime;
+    };
+
+    // 与GameApp::InitResource中的设置保持一致
+    const EffectPreset s_Presets[] = {
+        { "Fire",      ParticleEffectType::Fire,      10000,  { 0.0f, -1.0f, 0.0f }, { 0.0f, 7.8f, 0.0f },  0.005f,  1.0f },
+        { "Boom",      ParticleEffectType::Boom,      200000, { 0.0f, -1.0f, 0.0f }, { 1.0f, 1.0f, 1.0f },  0.25f,   2.5f },
+        { "Fountain",  ParticleEffectType::Fountain,  10000,  { 0.0f, 0.0f, 0.0f },  { 0.0f, -9.8f, 0.0f }, 0.0015f, 3.0f },
+        { "Smoke",     ParticleEffectType::Smoke,     1000,   { 0.0f, -1.0f, 0.0f }, { 1.0f, 1.0f, 1.0f },  0.01f,   5.0f },
+        { "FireSmoke", ParticleEffectType::FireSmoke, 1000,   { 0.0f, -1.0f, 0.0f }, { 0.0f, 7.8f, 0.0f },  0.005f,  1.0f },
+    };
+
+    void InitFromPreset(ParticleSimCPU& sim, const EffectPreset& preset)
+    {
+        sim.Init(preset.type, preset.maxParticles);
+        sim.SetEmitPos(preset.emitPos);
+        sim.SetEmitDir({ 0.0f, 1.0f, 0.0f });
+        sim.SetAcceleration(preset.accel);
+        sim.SetEmitInterval(preset.emitInterval);
+        sim.SetAliveTime(preset.aliveTime);
+    }
+
+    // 以固定帧间隔推进每个特效，统计每秒更新的粒子数
+    int RunSimulation(int frames, float dt)
+    {
+        std::printf("%-10s %10s %12s %14s\n", "effect", "particles", "ms/frame", "particles/s");
+        for (const EffectPreset& preset : s_Presets)
+        {
+            ParticleSimCPU sim;
+            InitFromPreset(sim, preset);
+
+            uint64_t processed = 0;
+            float gameTime = 0.0f;
+            auto start = Clock::now();
+            for (int i = 0; i < frames; ++i)
+            {
+                processed += sim.GetVertexCount();
+                gameTime += dt;
+                sim.Update(dt, gameTime);
+                if (preset.type == ParticleEffectType::FireSmoke)
+                {
+                    auto counts = sim.CountParticles();
+                    sim.SetParticleCount(counts.first, counts.second);
+                }
+            }
+            double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+            std::printf("%-10s %10u %12.4f %14.3e\n", preset.name, sim.GetVertexCount(),
+                seconds * 1000.0 / frames, processed / seconds);
+        }
+        return 0;
+    }
+
+    // 用随机粒子填满存储，Boom中混有壳与粒子
+    void FillRandomParticles(ParticleStorage& storage, uint32_t count, const EffectPreset& preset)
+    {
+        std::mt19937 randEngine(1234);
+        std::uniform_real_distribution<float> randF(-1.0f, 1.0f);
+        std::uniform_real_distribution<float> randAge(0.0f, preset.aliveTime);
+        storage.Reserve(count);
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            ParticleVertex p{};
+            p.initialPos = { randF(randEngine), randF(randEngine), randF(randEngine) };
+            p.initialVel = { 4.0f * randF(randEngine), 4.0f * randF(randEngine), 4.0f * randF(randEngine) };
+            p.accel = { 25.0f * randF(randEngine), 25.0f * randF(randEngine), 25.0f * randF(randEngine) };
+            p.size = { 2.5f, 2.5f };
+            p.age = randAge(randEngine);
+            p.type = (preset.type == ParticleEffectType::Boom && i % 17 == 0) ? PT_SHELL : PT_PARTICLE;
+            storage.Append(p);
+        }
+    }
+
+    template<class Func>
+    double MeasureParticlesPerSecond(uint32_t count, Func&& func)
+    {
+        // 至少重复到约两亿次粒子计算
+        int repeats = std::max(1, static_cast<int>(200000000ull / count));
+        auto start = Clock::now();
+        for (int r = 0; r < repeats; ++r)
+            func();
+        double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        return static_cast<double>(count) * repeats / seconds;
+    }
+
+    // 比较标量与SIMD轨迹内核的吞吐量
+    int RunKernels()
+    {
+        std::printf("SIMD width: %d\n", GetParticleSimdWidth());
+        std::printf("%-10s %10s %14s %14s %8s %10s\n", "effect", "particles", "scalar p/s", "simd p/s", "speedup", "max diff");
+        for (const EffectPreset& preset : s_Presets)
+        {
+            if (preset.type != ParticleEffectType::Fire && preset.type != ParticleEffectType::Boom)
+                continue;
+
+            const uint32_t count = preset.maxParticles;
+            ParticleStorage storage;
+            FillRandomParticles(storage, count, preset);
+
+            ParticleSimParams params;
+            params.accel = preset.accel;
+            params.emitInterval = preset.emitInterval;
+            params.aliveTime = preset.aliveTime;
+            ParticleAppearanceTable table = GetParticleAppearance(preset.type, params);
+
+            ParticleEvalBuffer scalarBuffer, simdBuffer;
+            scalarBuffer.Reserve(count);
+            simdBuffer.Reserve(count);
+            ParticleEvalOutput scalarOut = scalarBuffer.GetOutput();
+            ParticleEvalOutput simdOut = simdBuffer.GetOutput();
+
+            double scalarRate = MeasureParticlesPerSecond(count, [&]() {
+                EvaluateParticlesScalar(storage, 0, count, table, scalarOut);
+            });
+            double simdRate = MeasureParticlesPerSecond(count, [&]() {
+                EvaluateParticles(storage, 0, count, table, simdOut);
+            });
+
+            float maxDiff = 0.0f;
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                maxDiff = std::max(maxDiff, std::abs(scalarBuffer.GetPosX()[i] - simdBuffer.GetPosX()[i]));
+                maxDiff = std::max(maxDiff, std::abs(scalarBuffer.GetOpacity()[i] - simdBuffer.GetOpacity()[i]));
+                maxDiff = std::max(maxDiff, std::abs(scalarBuffer.GetHalfWidth()[i] - simdBuffer.GetHalfWidth()[i]));
+            }
+
+            std::printf("%-10s %10u %14.3e %14.3e %7.2fx %10.2e\n", preset.name, count,
+                scalarRate, simdRate, simdRate / scalarRate, maxDiff);
+        }
+        return 0;
+    }
+
+    // 在不同帧率下运行喷泉一段时间(短于其存活时间)，比较实际与期望的发射数目
+    int RunEmission(float seconds)
+    {
+        const EffectPreset& preset = s_Presets[2];
+        const float frameRates[] = { 30.0f, 60.0f, 144.0f };
+        std::printf("%s, interval %gs, %gs: expected %u particles\n", preset.name, preset.emitInterval, seconds,
+            static_cast<uint32_t>(seconds / preset.emitInterval));
+        std::printf("%6s %12s %12s\n", "fps", "per-frame", "accumulated");
+        for (float fps : frameRates)
+        {
+            uint32_t counts[2];
+            for (int mode = 0; mode < 2; ++mode)
+            {
+                ParticleSimCPU sim;
+                InitFromPreset(sim, preset);
+                sim.SetEmissionMode(mode ? EmissionMode::Accumulated : EmissionMode::PerFrame);
+                const float dt = 1.0f / fps;
+                const int frames = static_cast<int>(std::lround(seconds * fps));
+                for (int i = 0; i < frames; ++i)
+                    sim.Update(dt, dt * (i + 1));
+                counts[mode] = sim.GetParticleCount();
+            }
+            std::printf("%6.0f %12u %12u\n", fps, counts[0], counts[1]);
+        }
+        return 0;
+    }
+
+    // 在不同帧率下运行FireSmoke，比较子发射器产生的烟雾总数与期望值
+    // 直接统计子发射器产生的总数，与烟雾的寿命无关；偏离期望超过二项分布的4倍标准差时返回非零
+    int RunSubEmitter(float seconds)
+    {
+        EffectPreset preset = s_Presets[4];
+        preset.maxParticles = 20000;
+        preset.emitInterval = 0.0005f;
+        const float frameRates[] = { 30.0f, 60.0f, 144.0f };
+
+        // 去掉预算限制，只观察触发的频率
+        SubEmitterDesc smoke;
+        smoke.trigger = ParticleEventType::AgeThreshold;
+        smoke.ageFraction = 0.8f;
+        smoke.chance = 1.0f / 30.0f;
+        const double crossed = std::max(seconds - smoke.ageFraction * preset.aliveTime, 0.0f) / preset.emitInterval;
+        const double expected = crossed * smoke.chance;
+        const double tolerance = 4.0 * std::sqrt(expected * (1.0 - smoke.chance)) + 1.0;
+        std::printf("%s, %gs: expected %.0f +- %.0f smoke particles\n", preset.name, seconds, expected, tolerance);
+        std::printf("%6s %12s %12s\n", "fps", "compact", "pool");
+        bool inRange = true;
+        for (float fps : frameRates)
+        {
+            uint64_t counts[2];
+            for (int mode = 0; mode < 2; ++mode)
+            {
+                ParticleSimCPU sim;
+                InitFromPreset(sim, preset);
+                sim.SetEmissionMode(EmissionMode::Accumulated);
+                sim.SetStorageMode(mode ? ParticleStorageMode::Pool : ParticleStorageMode::Compact);
+                sim.ClearSubEmitters();
+                sim.AddSubEmitter(smoke);
+                const float dt = 1.0f / fps;
+                const int frames = static_cast<int>(std::lround(seconds * fps));
+                for (int i = 0; i < frames; ++i)
+                    sim.Update(dt, dt * (i + 1));
+                counts[mode] = sim.GetSubEmitterSpawnTotal(0);
+                inRange = inRange && std::abs(static_cast<double>(counts[mode]) - expected) <= tolerance;
+            }
+            std::printf("%6.0f %12llu %12llu\n", fps, static_cast<unsigned long long>(counts[0]),
+                static_cast<unsigned long long>(counts[1]));
+        }
+        if (!inRange)
+            std::printf("smoke count outside the expected range\n");
+        return inRange ? 0 : 1;
+    }
+
+    // 在接近满容量的稳态下比较两种存储方式的更新与求值耗时
+    int RunStorage(uint32_t capacity)
+    {
+        const float dt = 1.0f / 60.0f;
+        const int warmupFrames = 240;
+        const int frames = 120;
+        std::printf("%u particles at steady state\n", capacity);
+        std::printf("%-10s %-10s %10s %12s %12s %10s\n", "effect", "storage", "particles", "update ms", "evaluate ms", "max diff");
+        for (const EffectPreset& preset : s_Presets)
+        {
+            if (preset.type != ParticleEffectType::Fire && preset.type != ParticleEffectType::Fountain &&
+                preset.type != ParticleEffectType::Smoke)
+                continue;
+
+            ParticleEvalBuffer buffers[2];
+            uint32_t counts[2] = {};
+            for (int mode = 0; mode < 2; ++mode)
+            {
+                ParticleSimCPU sim;
+                InitFromPreset(sim, preset);
+                sim.Init(preset.type, capacity);
+                sim.SetEmissionMode(EmissionMode::Accumulated);
+                sim.SetEmitInterval(preset.aliveTime / (0.9f * capacity));
+                sim.SetStorageMode(mode ? ParticleStorageMode::BirthRing : ParticleStorageMode::Compact);
+
+                float gameTime = 0.0f;
+                for (int i = 0; i < warmupFrames; ++i)
+                    sim.Update(dt, gameTime += dt);
+
+                auto start = Clock::now();
+                for (int i = 0; i < frames; ++i)
+                    sim.Update(dt, gameTime += dt);
+                double updateMs = std::chrono::duration<double>(Clock::now() - start).count() * 1000.0 / frames;
+
+                start = Clock::now();
+                for (int i = 0; i < frames; ++i)
+                    sim.Evaluate(buffers[mode]);
+                double evaluateMs = std::chrono::duration<double>(Clock::now() - start).count() * 1000.0 / frames;
+
+                // 两种方式在寿命边界上可能相差一个粒子，从最新的粒子开始对齐比较
+                counts[mode] = sim.GetParticleCount();
+                float maxDiff = 0.0f;
+                if (mode == 1)
+                {
+                    uint32_t common = std::min(counts[0], counts[1]);
+                    for (uint32_t k = 1; k <= common; ++k)
+                    {
+                        float y0 = buffers[0].GetPosY()[counts[0] - k];
+                        float y1 = buffers[1].GetPosY()[counts[1] - k];
+                        maxDiff = std::max(maxDiff, std::abs(y0 - y1));
+                    }
+                }
+                std::printf("%-10s %-10s %10u %12.4f %12.4f %10.2e\n", preset.name, mode ? "BirthRing" : "Compact",
+                    sim.GetParticleCount(), updateMs, evaluateMs, maxDiff);
+            }
+        }
+        return 0;
+    }
+
+    // FireSmoke/Boom：先按原设置比较两种存储方式的粒子数，再填满长寿命的粒子比较每帧更新耗时
+    // 稳态下每帧只有少量粒子到期，Pool只处理这些粒子
+    int RunPool(uint32_t capacity, int frames)
+    {
+        const float dt = 1.0f / 60.0f;
+        std::printf("%-10s %-8s %12s %12s %10s %12s\n", "effect", "storage", "preset count", "filled count", "dying/f", "update ms");
+        for (const EffectPreset& preset : s_Presets)
+        {
+            if (preset.type != ParticleEffectType::FireSmoke && preset.type != ParticleEffectType::Boom)
+                continue;
+
+            EffectPreset filled = preset;
+            filled.maxParticles = capacity;
+            filled.aliveTime = 10.0f;
+            ParticleStorage storage;
+            FillRandomParticles(storage, capacity, filled);
+            std::vector<ParticleVertex> vertices(capacity);
+            storage.Export(vertices.data(), 0, capacity);
+
+            for (int mode = 0; mode < 2; ++mode)
+            {
+                const ParticleStorageMode storageMode = mode ? ParticleStorageMode::Pool : ParticleStorageMode::Compact;
+                auto step = [&](ParticleSimCPU& sim, float& gameTime) {
+                    sim.Update(dt, gameTime += dt);
+                    if (preset.type == ParticleEffectType::FireSmoke)
+                    {
+                        auto counts = sim.CountParticles();
+                        sim.SetParticleCount(counts.first, counts.second);
+                    }
+                };
+
+                ParticleSimCPU sim;
+                InitFromPreset(sim, preset);
+                sim.SetStorageMode(storageMode);
+                float gameTime = 0.0f;
+                for (int i = 0; i < 600; ++i)
+                    step(sim, gameTime);
+                uint32_t presetCount = sim.GetParticleCount();
+
+                InitFromPreset(sim, filled);
+                sim.SetStorageMode(storageMode);
+                sim.SetVertices(vertices.data(), capacity);
+                gameTime = 0.0f;
+                auto start = Clock::now();
+                for (int i = 0; i < frames; ++i)
+                    step(sim, gameTime);
+                double ms = std::chrono::duration<double>(Clock::now() - start).count() * 1000.0 / frames;
+                uint32_t filledCount = sim.GetParticleCount();
+
+                std::printf("%-10s %-8s %12u %12u %10u %12.4f\n", preset.name, mode ? "Pool" : "Compact",
+                    presetCount, filledCount, (capacity - filledCount) / frames, ms);
+            }
+        }
+        return 0;
+    }
+
+    // 同一帧内大量壳同时爆炸：测量一帧中按请求成批展开16倍粒子的耗时
+    int RunBurst(uint32_t shellCount)
+    {
+        const EffectPreset& preset = s_Presets[1];
+        const float dt = 1.0f / 60.0f;
+        const uint32_t threads = std::max(1u, std::thread::hardware_concurrency());
+
+        std::mt19937 randEngine(1234);
+        std::uniform_real_distribution<float> randF(-1.0f, 1.0f);
+        std::vector<ParticleVertex> shells(shellCount);
+        for (ParticleVertex& p : shells)
+        {
+            p = {};
+            p.initialPos = { randF(randEngine), randF(randEngine), randF(randEngine) };
+            p.accel = { 50.0f * randF(randEngine), 50.0f * randF(randEngine), 50.0f * randF(randEngine) };
+            p.size = { 2.5f, 2.5f };
+            // 下一帧即越过爆炸点
+            p.age = preset.emitInterval;
+            p.type = PT_SHELL;
+        }
+
+        std::printf("%u shells -> %u particles per frame\n", shellCount, shellCount * 16);
+        std::printf("%8s %12s %14s\n", "threads", "ms/frame", "spawned/s");
+        for (uint32_t workers : { 0u, threads - 1 })
+        {
+            JobSystem jobs(workers);
+            ParticleSimCPU sim;
+            InitFromPreset(sim, preset);
+            sim.Init(preset.type, shellCount * 17);
+
+            const int repeats = 20;
+            double seconds = 0.0;
+            uint32_t count = 0;
+            for (int r = 0; r < repeats; ++r)
+            {
+                sim.SetVertices(shells.data(), shellCount);
+                auto start = Clock::now();
+                sim.Update(dt, dt, &jobs);
+                seconds += std::chrono::duration<double>(Clock::now() - start).count();
+                count = sim.GetParticleCount();
+            }
+            std::printf("%8u %12.4f %14.3e\n", workers + 1, seconds * 1000.0 / repeats,
+                static_cast<double>(count - shellCount) * repeats / seconds);
+            if (threads == 1)
+                break;
+        }
+        return 0;
+    }
+
+    // 烟火的发射上限改由模拟延迟的回读提供粒子数，比较不同延迟下的结果与回读开销
+    int RunReadback(int frames)
+    {
+        const EffectPreset& preset = s_Presets[4];
+        const float dt = 1.0f / 60.0f;
+        const uint32_t slotCount = 3;
+        std::printf("%s, %d frames, %u slots\n", preset.name, frames, slotCount);
+        std::printf("%8s %10s %10s %10s %12s %12s\n", "latency", "delivered", "dropped", "avg lag", "fire/smoke", "us/frame");
+        for (uint32_t latency = 0; latency <= slotCount + 1; ++latency)
+        {
+            ParticleSimCPU sim;
+            InitFromPreset(sim, preset);
+
+            std::vector<ParticleVertex> vertices(preset.maxParticles + 1);
+            SimulatedReadbackBackend backend(slotCount, latency, [&](std::vector<uint8_t>& bytes) {
+                uint32_t count = sim.ExportVertices(vertices.data(), static_cast<uint32_t>(vertices.size()));
+                const uint8_t* src = reinterpret_cast<const uint8_t*>(vertices.data());
+                bytes.assign(src, src + count * sizeof(ParticleVertex));
+            });
+            ReadbackRing ring;
+            ring.Init(&backend, slotCount);
+
+            uint64_t lagSum = 0;
+            double seconds = 0.0;
+            float gameTime = 0.0f;
+            for (int i = 0; i < frames; ++i)
+            {
+                sim.Update(dt, gameTime += dt);
+
+                auto start = Clock::now();
+                backend.AdvanceFrame();
+                ring.End(ring.Begin(static_cast<uint64_t>(i)));
+                ring.Poll([&](uint64_t tag, const ReadbackView& view) {
+                    const ParticleVertex* data = static_cast<const ParticleVertex*>(view.data);
+                    uint32_t fire = 0, smoke = 0;
+                    for (uint32_t k = 0; k < view.byteSize / sizeof(ParticleVertex); ++k)
+                    {
+                        fire += data[k].type == PT_PARTICLE;
+                        smoke += data[k].type == PT_SMOKE;
+                    }
+                    sim.SetParticleCount(fire, smoke);
+                    lagSum += static_cast<uint64_t>(i) - tag;
+                });
+                seconds += std::chrono::duration<double>(Clock::now() - start).count();
+            }
+
+            auto counts = sim.CountParticles();
+            uint64_t delivered = ring.GetCompletedCount();
+            std::printf("%8u %10llu %10llu %10.2f %6u/%-5u %12.3f\n", latency,
+                static_cast<unsigned long long>(delivered), static_cast<unsigned long long>(ring.GetDroppedCount()),
+                delivered ? static_cast<double>(lagSum) / delivered : 0.0, counts.first, counts.second,
+                seconds * 1.0e6 / frames);
+        }
+        return 0;
+    }
+
+    // 比较逐个生成与SIMD批量生成计数器随机数的吞吐量
+    int RunRandom()
+    {
+        const uint32_t count = 1 << 16;
+        ParticleRandom random(0x5EEDull);
+        std::vector<float> scalar(count * 3), bulk(count * 3);
+
+        double scalarRate = MeasureParticlesPerSecond(count, [&]() {
+            random.UniformVec3BulkScalar(0, 1, 0, 0, count, scalar.data(), scalar.data() + count, scalar.data() + 2 * count);
+        });
+        double bulkRate = MeasureParticlesPerSecond(count, [&]() {
+            random.UniformVec3Bulk(0, 1, 0, 0, count, bulk.data(), bulk.data() + count, bulk.data() + 2 * count);
+        });
+        bool identical = std::memcmp(scalar.data(), bulk.data(), scalar.size() * sizeof(float)) == 0;
+
+        std::printf("SIMD width: %d\n", GetParticleSimdWidth());
+        std::printf("%14s %14s %8s %10s\n", "scalar vec/s", "bulk vec/s", "speedup", "identical");
+        std::printf("%14.3e %14.3e %7.2fx %10s\n", scalarRate, bulkRate, bulkRate / scalarRate, identical ? "yes" : "no");
+        return identical ? 0 : 1;
+    }
+
+    // 序列化往返：Serialize -> Deserialize后逐粒子与逐字节比较，并确认签名不符、数据截断时被拒绝
+    int RunSerialize(uint32_t count)
+    {
+        const EffectPreset& preset = s_Presets[1];
+        ParticleStorage source;
+        FillRandomParticles(source, count, preset);
+        uint32_t* emitCounts = source.GetEmitCounts();
+        for (uint32_t i = 0; i < count; ++i)
+            emitCounts[i] = i * 2654435761u;
+
+        std::vector<uint8_t> bytes;
+        auto start = Clock::now();
+        source.Serialize(bytes, 0, count);
+        double serializeMs = std::chrono::duration<double>(Clock::now() - start).count() * 1000.0;
+
+        ParticleStorage restored;
+        restored.Reserve(count);
+        start = Clock::now();
+        bool accepted = restored.Deserialize(bytes.data(), bytes.size());
+        double deserializeMs = std::chrono::duration<double>(Clock::now() - start).count() * 1000.0;
+
+        uint32_t mismatches = 0;
+        if (accepted && restored.GetSize() == count)
+        {
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                ParticleVertex a = source.Load(i);
+                ParticleVertex b = restored.Load(i);
+                if (std::memcmp(&a, &b, sizeof(ParticleVertex)) != 0)
+                    ++mismatches;
+            }
+        }
+        std::vector<uint8_t> reserialized;
+        restored.Serialize(reserialized, 0, restored.GetSize());
+        bool bytesEqual = accepted && reserialized == bytes;
+
+        // 部分区间
+        const uint32_t first = count / 3;
+        const uint32_t rangeCount = count - first;
+        std::vector<uint8_t> rangeBytes;
+        source.Serialize(rangeBytes, first, rangeCount);
+        bool rangeOk = restored.Deserialize(rangeBytes.data(), rangeBytes.size()) && restored.GetSize() == rangeCount;
+        for (uint32_t i = 0; rangeOk && i < rangeCount; ++i)
+        {
+            ParticleVertex a = source.Load(first + i);
+            ParticleVertex b = restored.Load(i);
+            rangeOk = std::memcmp(&a, &b, sizeof(ParticleVertex)) == 0;
+        }
+
+        // 篡改签名（紧跟在4字节标识之后）与截断数据都必须被拒绝，且不修改已有粒子
+        restored.Deserialize(bytes.data(), bytes.size());
+        std::vector<uint8_t> badSignature = bytes;
+        badSignature[4] ^= 0x01;
+        bool signatureRejected = !restored.Deserialize(badSignature.data(), badSignature.size());
+        bool truncatedRejected = !restored.Deserialize(bytes.data(), bytes.size() - 1);
+        std::vector<uint8_t> afterReject;
+        restored.Serialize(afterReject, 0, restored.GetSize());
+        bool unchanged = afterReject == bytes;
+
+        double megabytes = bytes.size() / (1024.0 * 1024.0);
+        std::printf("%u particles, %.2f MB (%u bytes/particle)\n", count, megabytes, ParticleStorage::SerializedParticleSize);
+        std::printf("serialize %.3f ms (%.0f MB/s), deserialize %.3f ms (%.0f MB/s)\n",
+            serializeMs, megabytes / (serializeMs / 1000.0), deserializeMs, megabytes / (deserializeMs / 1000.0));
+        std::printf("round trip: %s, %u particle mismatches, bytes %s, range [%u, %u) %s\n",
+            accepted ? "accepted" : "REJECTED", mismatches, bytesEqual ? "identical" : "DIFFER",
+            first, count, rangeOk ? "ok" : "MISMATCH");
+        std::printf("bad signature %s, truncated data %s, storage %s\n",
+            signatureRejected ? "rejected" : "ACCEPTED", truncatedRejected ? "rejected" : "ACCEPTED",
+            unchanged ? "unchanged" : "MODIFIED");
+
+        bool ok = accepted && mismatches == 0 && bytesEqual && rangeOk && signatureRejected && truncatedRejected && unchanged;
+        return ok ? 0 : 1;
+    }
+
+    // 每个特效填满粒子并延长寿命，比较不同线程数下同时更新全部特效的耗时
+    int RunScaling(uint32_t particlesPerEffect, int frames)
+    {
+        const float dt = 1.0f / 60.0f;
+        const uint32_t maxThreads = std::max(1u, std::thread::hardware_concurrency());
+        std::printf("%u effects x %u particles, %d frames\n", static_cast<uint32_t>(std::size(s_Presets)),
+            particlesPerEffect, frames);
+        std::printf("%8s %12s %10s\n", "threads", "ms/frame", "speedup");
+
+        // 1, 2, 4, ...以及硬件线程数
+        std::vector<uint32_t> threadCounts;
+        for (uint32_t threads = 1; threads < maxThreads; threads *= 2)
+            threadCounts.push_back(threads);
+        threadCounts.push_back(maxThreads);
+
+        double baseMs = 0.0;
+        for (uint32_t threads : threadCounts)
+        {
+            std::vector<std::unique_ptr<ParticleSimCPU>> sims;
+            std::vector<ParticleSimCPU*> systems;
+            for (const EffectPreset& preset : s_Presets)
+            {
+                EffectPreset scaled = preset;
+                scaled.maxParticles = particlesPerEffect;
+                // 足够长的寿命使粒子数在测试期间保持不变
+                scaled.aliveTime = 1.0e6f;
+
+                ParticleStorage storage;
+                FillRandomParticles(storage, particlesPerEffect, scaled);
+                std::vector<ParticleVertex> vertices(particlesPerEffect);
+                storage.Export(vertices.data(), 0, particlesPerEffect);
+
+                sims.push_back(std::make_unique<ParticleSimCPU>());
+                InitFromPreset(*sims.back(), scaled);
+                sims.back()->SetVertices(vertices.data(), particlesPerEffect);
+                systems.push_back(sims.back().get());
+            }
+
+            JobSystem jobs(threads - 1);
+            float gameTime = 0.0f;
+            auto start = Clock::now();
+            for (int i = 0; i < frames; ++i)
+            {
+                gameTime += dt;
+                ParticleSimCPU::UpdateSystems(systems.data(), static_cast<uint32_t>(systems.size()), dt, gameTime, jobs);
+            }
+            double ms = std::chrono::duration<double>(Clock::now() - start).count() * 1000.0 / frames;
+            if (threads == 1)
+                baseMs = ms;
+            std::printf("%8u %12.4f %9.2fx\n", threads, ms, baseMs / ms);
+        }
+        return 0;
+    }
+
+    // 填满Boom的粒子池，比较以ParticleVertex与32字节量化格式导出的体积、耗时与误差
+    // 壳与boom.hlsl相同以[-emitInterval, emitInterval]的存活时间延迟发射，并带一帧的绘制滞后，覆盖负的存活时间
+    int RunPacked(uint32_t particles)
+    {
+        EffectPreset preset = s_Presets[1];
+        preset.maxParticles = particles;
+        ParticleStorage storage;
+        FillRandomParticles(storage, particles, preset);
+        std::vector<ParticleVertex> vertices(particles + 1);
+        storage.Export(vertices.data(), 0, particles);
+        std::mt19937 randEngine(5678);
+        std::uniform_real_distribution<float> randF(-1.0f, 1.0f);
+        for (uint32_t i = 0; i < particles; ++i)
+        {
+            if (vertices[i].type == PT_SHELL)
+                vertices[i].age = randF(randEngine) * preset.emitInterval;
+        }
+
+        ParticleSimCPU sim;
+        InitFromPreset(sim, preset);
+        sim.SetStorageMode(ParticleStorageMode::Pool);
+        sim.SetVertices(vertices.data(), particles);
+        sim.SetRenderLag(1.0f / 60.0f);
+        const PackedParticleConstants constants = sim.GetPackedConstants();
+        const float ageStep = constants.ageRange / 65535.0f;
+
+        std::vector<PackedParticle> packed(particles + 1);
+        uint32_t vertexCount = 0, packedCount = 0;
+        double vertexRate = MeasureParticlesPerSecond(particles, [&]() {
+            vertexCount = sim.ExportVertices(vertices.data(), particles + 1);
+        });
+        double packRate = MeasureParticlesPerSecond(particles, [&]() {
+            packedCount = sim.ExportPacked(packed.data(), particles + 1);
+        });
+        ParticleStorage unpacked;
+        unpacked.Reserve(packedCount);
+        unpacked.Resize(packedCount);
+        double unpackRate = MeasureParticlesPerSecond(particles, [&]() {
+            UnpackParticles(packed.data(), packedCount, constants, unpacked, 0);
+        });
+
+        // 与未量化的导出结果逐个比较
+        float velError = 0.0f, accelError = 0.0f, ageError = 0.0f;
+        uint32_t mismatches = vertexCount == packedCount ? 0 : 1;
+        uint32_t negativeAges = 0;
+        for (uint32_t i = 0; i < std::min(vertexCount, packedCount); ++i)
+        {
+            const ParticleVertex& a = vertices[i];
+            const ParticleVertex b = unpacked.Load(i);
+            auto relative = [](const Float3& x, const Float3& y) {
+                Float3 d = x - y;
+                return std::sqrt(Dot(d, d) / std::max(Dot(x, x), 1.0e-12f));
+            };
+            velError = std::max(velError, relative(a.initialVel, b.initialVel));
+            accelError = std::max(accelError, relative(a.accel, b.accel));
+            ageError = std::max(ageError, std::abs(a.age - b.age));
+            negativeAges += a.age < 0.0f;
+            // 存活时间的误差不超过半个量化步长(留出浮点舍入的余量)，超出说明被饱和
+            mismatches += std::memcmp(&a.initialPos, &b.initialPos, sizeof(Float3)) != 0 ||
+                std::abs(a.age - b.age) > 0.51f * ageStep + 1.0e-6f ||
+                a.size.x != b.size.x || a.size.y != b.size.y || a.type != b.type ||
+                std::min(a.emitCount, 255u) != b.emitCount;
+        }
+
+        std::printf("%s pool, %u particles, SIMD width %d\n", preset.name, particles, GetParticleSimdWidth());
+        std::printf("%-12s %10s %12s %14s\n", "format", "bytes", "MB/export", "particles/s");
+        std::printf("%-12s %10u %12.2f %14.3e\n", "vertex", static_cast<uint32_t>(sizeof(ParticleVertex)),
+            vertexCount * sizeof(ParticleVertex) / 1.0e6, vertexRate);
+        std::printf("%-12s %10u %12.2f %14.3e\n", "packed", static_cast<uint32_t>(sizeof(PackedParticle)),
+            packedCount * sizeof(PackedParticle) / 1.0e6, packRate);
+        std::printf("%-12s %10s %12s %14.3e\n", "unpack", "", "", unpackRate);
+        std::printf("saved %.1f%%, age range [%.3f, %.3f] s, %u negative ages\n",
+            100.0 * (1.0 - static_cast<double>(sizeof(PackedParticle)) / sizeof(ParticleVertex)),
+            constants.ageMin, constants.ageMin + constants.ageRange, negativeAges);
+        std::printf("max error: velocity %.2e (rel), accel %.2e (rel), age %.2e s, exact-field mismatches %u\n",
+            velError, accelError, ageError, mismatches);
+        return mismatches == 0 ? 0 : 1;
+    }
+
+    // 从远到近的深度排序：与std::stable_sort比较，并测量包含闭式轨迹求值的整个排序
+    int RunSort()
+    {
+        const uint32_t threads = std::max(1u, std::thread::hardware_concurrency());
+        JobSystem jobs(threads - 1);
+        // 相机位于(0, 2, -10)看向+z
+        ParticleDepthPlane plane;
+        plane.axis = { 0.0f, 0.0f, 1.0f };
+        plane.offset = 10.0f;
+
+        std::printf("%u threads\n", threads);
+        std::printf("%10s %12s %12s %12s %12s %8s %10s\n", "particles", "std ms", "radix 1T ms",
+            "radix NT ms", "+eval ms", "passes", "identical");
+        for (uint32_t count : { 10000u, 200000u, 1000000u })
+        {
+            EffectPreset preset = s_Presets[3];
+            preset.maxParticles = count;
+            preset.aliveTime = 1.0e6f;
+            ParticleStorage storage;
+            FillRandomParticles(storage, count, preset);
+            std::vector<ParticleVertex> vertices(count);
+            storage.Export(vertices.data(), 0, count);
+            ParticleSimCPU sim;
+            InitFromPreset(sim, preset);
+            sim.SetVertices(vertices.data(), count);
+
+            ParticleDepthSorter sorter;
+            sorter.Sort(sim, plane);
+            std::vector<float> depths(sorter.GetDepths(), sorter.GetDepths() + count);
+            const int repeats = std::max(1, static_cast<int>(20000000u / count));
+
+            std::vector<uint32_t> reference(count);
+            auto start = Clock::now();
+            for (int r = 0; r < repeats; ++r)
+            {
+                for (uint32_t i = 0; i < count; ++i)
+                    reference[i] = i;
+                std::stable_sort(reference.begin(), reference.end(), [&](uint32_t a, uint32_t b) {
+                    return depths[a] > depths[b];
+                });
+            }
+            double stdMs = std::chrono::duration<double>(Clock::now() - start).count() * 1000.0 / repeats;
+
+            auto measure = [&](auto&& func) {
+                auto begin = Clock::now();
+                for (int r = 0; r < repeats; ++r)
+                    func();
+                return std::chrono::duration<double>(Clock::now() - begin).count() * 1000.0 / repeats;
+            };
+            double serialMs = measure([&]() { sorter.SortDepths(depths.data(), count); });
+            bool identical = std::equal(reference.begin(), reference.end(), sorter.GetIndices());
+            double parallelMs = measure([&]() { sorter.SortDepths(depths.data(), count, &jobs); });
+            identical = identical && std::equal(reference.begin(), reference.end(), sorter.GetIndices());
+            double evalMs = measure([&]() { sorter.Sort(sim, plane, &jobs); });
+
+            std::printf("%10u %12.3f %12.3f %12.3f %12.3f %8u %10s\n", count, stdMs, serialMs, parallelMs, evalMs,
+                sorter.GetPassCount(), identical ? "yes" : "no");
+            if (!identical)
+                return 1;
+        }
+        return 0;
+    }
+
+    // 相机绕y轴缓慢转动时，比较每帧完整的基数排序与沿用上一帧顺序的连贯排序
+    int RunCoherentSort(uint32_t particles, int frames, float degreesPerFrame)
+    {
+        const float dt = 1.0f / 60.0f;
+        std::printf("%u particles, %d frames, camera turning %g deg/frame\n", particles, frames, degreesPerFrame);
+        std::printf("%-10s %-10s %10s %10s %10s %10s %10s %10s %10s\n", "effect", "storage", "radix ms", "coherent",
+            "speedup", "new/frame", "moved", "shifts/p", "fallbacks");
+
+        // 最后一项暂停模拟，只有相机在动
+        struct Scenario
+        {
+            const EffectPreset& preset;
+            ParticleStorageMode storageMode;
+            bool simulate;
+        };
+        const Scenario scenarios[] = {
+            { s_Presets[3], ParticleStorageMode::Compact, true },
+            { s_Presets[3], ParticleStorageMode::BirthRing, true },
+            { s_Presets[1], ParticleStorageMode::Pool, true },
+            { s_Presets[1], ParticleStorageMode::Pool, false },
+        };
+        for (const Scenario& scenario : scenarios)
+        {
+            EffectPreset preset = scenario.preset;
+            preset.maxParticles = particles;
+            ParticleSimCPU sim;
+            InitFromPreset(sim, preset);
+            sim.SetStorageMode(scenario.storageMode);
+            float gameTime = 0.0f;
+            if (preset.type == ParticleEffectType::Boom)
+            {
+                // 填满粒子池并延长寿命，粒子数保持不变
+                ParticleStorage storage;
+                FillRandomParticles(storage, particles, preset);
+                std::vector<ParticleVertex> vertices(particles);
+                storage.Export(vertices.data(), 0, particles);
+                sim.SetVertices(vertices.data(), particles);
+                sim.SetAliveTime(1.0e6f);
+            }
+            else
+            {
+                // 按累计时间发射，稳定后约有particles个粒子
+                sim.SetEmissionMode(EmissionMode::Accumulated);
+                sim.SetEmitInterval(preset.aliveTime / particles);
+                for (float t = 0.0f; t < preset.aliveTime + 0.5f; t += dt)
+                    sim.Update(dt, gameTime += dt);
+            }
+
+            ParticleDepthSorter radix, coherent;
+            double radixSeconds = 0.0, coherentSeconds = 0.0;
+            uint64_t inserted = 0, moved = 0, shifts = 0, sorted = 0;
+            uint32_t fallbacks = 0;
+            bool identical = true;
+            for (int i = 0; i < frames; ++i)
+            {
+                if (scenario.simulate)
+                    sim.Update(dt, gameTime += dt);
+                const float angle = degreesPerFrame * i * 3.14159265f / 180.0f;
+                ParticleDepthPlane plane;
+                plane.axis = { std::sin(angle), 0.0f, std::cos(angle) };
+                plane.offset = 10.0f;
+
+                auto start = Clock::now();
+                radix.Sort(sim, plane);
+                auto middle = Clock::now();
+                coherent.SortCoherent(sim, plane);
+                auto end = Clock::now();
+                radixSeconds += std::chrono::duration<double>(middle - start).count();
+                coherentSeconds += std::chrono::duration<double>(end - middle).count();
+
+                // 深度相同的粒子之间顺序可以不同，逐个比较深度
+                const float* depths = radix.GetDepths();
+                identical = identical && radix.GetCount() == coherent.GetCount();
+                for (uint32_t k = 0; identical && k < radix.GetCount(); ++k)
+                    identical = depths[radix.GetIndices()[k]] == depths[coherent.GetIndices()[k]];
+
+                // 第一帧没有可沿用的顺序，不计入统计
+                if (i == 0)
+                    continue;
+                const ParticleSortStats& stats = coherent.GetStats();
+                inserted += stats.inserted;
+                moved += stats.moved;
+                shifts += stats.shifts;
+                sorted += coherent.GetCount();
+                fallbacks += stats.fallback;
+            }
+
+            const double frameCount = std::max(1, frames - 1);
+            std::printf("%-10s %-10s %10.3f %10.3f %9.2fx %10.0f %10.0f %10.3f %10u%s\n", preset.name,
+                scenario.storageMode == ParticleStorageMode::Compact ? "Compact" :
+                scenario.storageMode == ParticleStorageMode::BirthRing ? "BirthRing" :
+                scenario.simulate ? "Pool" : "Pool/still",
+                radixSeconds * 1000.0 / frames, coherentSeconds * 1000.0 / frames, radixSeconds / coherentSeconds,
+                inserted / frameCount, moved / frameCount, sorted ? static_cast<double>(shifts) / sorted : 0.0,
+                fallbacks, identical ? "" : "  MISMATCH");
+            if (!identical)
+                return 1;
+        }
+        return 0;
+    }
+
+    // 相机位于eye、绕y轴转动yaw后的行向量视图矩阵，透视投影与Camera相同(D3D左手系)
+    ParticleFrustum MakeCameraFrustum(const Float3& eye, float yawDegrees, ParticleDepthPlane* plane = nullptr)
+    {
+        const float yaw = yawDegrees * 3.14159265f / 180.0f;
+        const float c = std::cos(yaw), s = std::sin(yaw);
+        // 视图矩阵的各列为相机的右、上、前方向
+        const Float3 right = { c, 0.0f, -s };
+        const Float3 up = { 0.0f, 1.0f, 0.0f };
+        const Float3 look = { s, 0.0f, c };
+        const float view[4][4] = {
+            { right.x, up.x, look.x, 0.0f },
+            { right.y, up.y, look.y, 0.0f },
+            { right.z, up.z, look.z, 0.0f },
+            { -Dot(right, eye), -Dot(up, eye), -Dot(look, eye), 1.0f },
+        };
+        const float nearZ = 1.0f, farZ = 1000.0f;
+        const float yScale = 1.0f / std::tan(3.14159265f / 6.0f), xScale = yScale / (16.0f / 9.0f);
+        const float proj[4][4] = {
+            { xScale, 0.0f, 0.0f, 0.0f },
+            { 0.0f, yScale, 0.0f, 0.0f },
+            { 0.0f, 0.0f, farZ / (farZ - nearZ), 1.0f },
+            { 0.0f, 0.0f, -nearZ * farZ / (farZ - nearZ), 0.0f },
+        };
+        float viewProj[4][4] = {};
+        for (int r = 0; r < 4; ++r)
+            for (int k = 0; k < 4; ++k)
+                for (int col = 0; col < 4; ++col)
+                    viewProj[r][col] += view[r][k] * proj[k][col];
+        if (plane)
+        {
+            plane->axis = { view[0][2], view[1][2], view[2][2] };
+            plane->offset = view[3][2];
+        }
+        return ParticleFrustum::FromViewProj(viewProj);
+    }
+
+    // 视锥体剔除：与逐粒子的标量测试比较，并测量剔除后排序与上传的开销
+    int RunCull(uint32_t particles)
+    {
+        // 相机位于(0, 2, -10)
+        auto makeFrustum = [](float yawDegrees, ParticleDepthPlane& plane) {
+            return MakeCameraFrustum({ 0.0f, 2.0f, -10.0f }, yawDegrees, &plane);
+        };
+
+        const uint32_t threads = std::max(1u, std::thread::hardware_concurrency());
+        JobSystem jobs(threads - 1);
+        std::printf("%u particles, %u threads, SIMD width %d\n", particles, threads, GetParticleSimdWidth());
+        std::printf("%-10s %-10s %6s %9s %9s %10s %10s %10s %10s %10s %10s\n", "effect", "storage", "yaw",
+            "visible", "cull ms", "sort all", "cull+sort", "upload all", "upload vis", "total all", "total cull");
+
+        struct Scenario
+        {
+            const EffectPreset& preset;
+            ParticleStorageMode storageMode;
+        };
+        const Scenario scenarios[] = {
+            { s_Presets[3], ParticleStorageMode::Compact },
+            { s_Presets[3], ParticleStorageMode::BirthRing },
+            { s_Presets[1], ParticleStorageMode::Pool },
+        };
+        for (const Scenario& scenario : scenarios)
+        {
+            EffectPreset preset = scenario.preset;
+            preset.maxParticles = particles;
+            ParticleSimCPU sim;
+            InitFromPreset(sim, preset);
+            sim.SetStorageMode(scenario.storageMode);
+            const float dt = 1.0f / 60.0f;
+            float gameTime = 0.0f;
+            if (preset.type == ParticleEffectType::Boom)
+            {
+                ParticleStorage storage;
+                FillRandomParticles(storage, particles, preset);
+                std::vector<ParticleVertex> vertices(particles);
+                storage.Export(vertices.data(), 0, particles);
+                sim.SetVertices(vertices.data(), particles);
+                sim.SetAliveTime(1.0e6f);
+                // 释放一部分槽位，空闲槽位须被跳过
+                for (int i = 0; i < 30; ++i)
+                    sim.Update(dt, gameTime += dt);
+            }
+            else
+            {
+                sim.SetEmissionMode(EmissionMode::Accumulated);
+                sim.SetEmitInterval(preset.aliveTime / particles);
+                for (float t = 0.0f; t < preset.aliveTime + 0.5f; t += dt)
+                    sim.Update(dt, gameTime += dt);
+            }
+
+            ParticleFrustumCuller culler;
+            ParticleDepthSorter sorter;
+            std::vector<ParticleVertex> vertices(sim.GetVertexCount());
+            std::vector<uint32_t> order;
+            for (float yaw : { 0.0f, 60.0f, 180.0f })
+            {
+                ParticleDepthPlane plane;
+                const ParticleFrustum frustum = makeFrustum(yaw, plane);
+                culler.Cull(sim, frustum, &jobs);
+
+                // 标量参考：同样的包围球，逐平面判断
+                const ParticleEvalBuffer& eval = culler.GetEval();
+                const bool pool = scenario.storageMode == ParticleStorageMode::Pool;
+                const uint32_t evaluated = pool ? sim.GetMaxParticles() : sim.GetParticleCount();
+                const uint8_t* types = sim.GetParticles().GetTypes();
+                std::vector<uint32_t> reference;
+                uint32_t rank = 0;
+                for (uint32_t i = 0; i < evaluated; ++i)
+                {
+                    if (pool && types[i] == ParticleSimCPU::PoolFreeSlot)
+                        continue;
+                    const float radius = 1.41421356f * std::max(std::abs(eval.GetHalfWidth()[i]), std::abs(eval.GetHalfHeight()[i]));
+                    bool inside = true;
+                    for (const auto& p : frustum.planes)
+                        inside = inside && p[0] * eval.GetPosX()[i] + p[1] * eval.GetPosY()[i] + p[2] * eval.GetPosZ()[i] + p[3] >= -radius;
+                    if (inside)
+                        reference.push_back(rank);
+                    ++rank;
+                }
+                const uint32_t visible = culler.GetVisibleCount();
+                if (reference.size() != visible || !std::equal(reference.begin(), reference.end(), culler.GetVisible()) ||
+                    culler.GetTestedCount() != sim.GetParticleCount())
+                {
+                    std::printf("%-10s MISMATCH at yaw %g: %u visible, reference %zu\n", preset.name, yaw, visible, reference.size());
+                    return 1;
+                }
+
+                const int repeats = std::max(1, static_cast<int>(20000000u / particles));
+                auto measure = [&](auto&& func) {
+                    auto begin = Clock::now();
+                    for (int r = 0; r < repeats; ++r)
+                        func();
+                    return std::chrono::duration<double>(Clock::now() - begin).count() * 1000.0 / repeats;
+                };
+                const double cullMs = measure([&]() { culler.Cull(sim, frustum, &jobs); });
+                const double sortAllMs = measure([&]() { sorter.Sort(sim, plane, &jobs); });
+                const double sortVisibleMs = measure([&]() { sorter.Sort(culler, plane, &jobs); });
+                const double uploadAllMs = measure([&]() { sim.ExportVertices(vertices.data(), static_cast<uint32_t>(vertices.size())); });
+                // 可见粒子按原顺序上传，排序结果即为其索引缓冲区
+                const double uploadVisibleMs = measure([&]() {
+                    sim.ExportVertices(culler.GetEvalIndices(), visible, vertices.data());
+                    order.assign(sorter.GetIndices(), sorter.GetIndices() + visible);
+                });
+
+                std::printf("%-10s %-10s %6.0f %8.1f%% %9.3f %10.3f %10.3f %10.3f %10.3f %10.3f %10.3f\n", preset.name,
+                    scenario.storageMode == ParticleStorageMode::Compact ? "Compact" :
+                    scenario.storageMode == ParticleStorageMode::BirthRing ? "BirthRing" : "Pool",
+                    yaw, 100.0 * visible / std::max(1u, sim.GetParticleCount()), cullMs, sortAllMs,
+                    cullMs + sortVisibleMs, uploadAllMs, uploadVisibleMs,
+                    sortAllMs + uploadAllMs, cullMs + sortVisibleMs + uploadVisibleMs);
+            }
+        }
+        return 0;
+    }
+
+    // 统计sim中超出bounds的粒子数，actual不为空时写入实际的包围盒
+    // 实际的包围盒：每个粒子以位置为中心、sqrt(2)倍的最大半尺寸为半径
+    uint64_t CountOutside(const ParticleSimCPU& sim, ParticleEvalBuffer& eval, const ParticleBounds& bounds,
+        ParticleBounds* actual = nullptr)
+    {
+        const bool pool = sim.GetStorageMode() == ParticleStorageMode::Pool;
+        sim.Evaluate(eval);
+        const uint32_t evaluated = pool ? sim.GetMaxParticles() : sim.GetParticleCount();
+        const uint8_t* types = sim.GetParticles().GetTypes();
+        uint64_t outside = 0;
+        for (uint32_t k = 0; k < evaluated; ++k)
+        {
+            if (pool && types[k] == ParticleSimCPU::PoolFreeSlot)
+                continue;
+            const float radius = 1.41421356f * std::max(std::abs(eval.GetHalfWidth()[k]), std::abs(eval.GetHalfHeight()[k]));
+            ParticleBounds sphere = ParticleBounds::Point({ eval.GetPosX()[k], eval.GetPosY()[k], eval.GetPosZ()[k] });
+            sphere.Expand(radius);
+            if (actual)
+                actual->Merge(sphere);
+            // 允许浮点舍入的误差
+            const float eps = 1.0e-4f * (1.0f + std::abs(sphere.min.x) + std::abs(sphere.min.y) + std::abs(sphere.min.z));
+            outside += sphere.min.x < bounds.min.x - eps || sphere.min.y < bounds.min.y - eps || sphere.min.z < bounds.min.z - eps ||
+                sphere.max.x > bounds.max.x + eps || sphere.max.y > bounds.max.y + eps || sphere.max.z > bounds.max.z + eps;
+        }
+        return outside;
+    }
+
+    // 解析包围盒：每帧检查全部粒子(含公告板)都在包围盒内，中途移动发射器并改变加速度
+    // 与每帧遍历粒子求出的实际包围盒比较大小与开销
+    int RunBounds(int frames)
+    {
+        const float dt = 1.0f / 60.0f;
+        std::printf("%d frames, emitter moved and acceleration changed at frame %d\n", frames, frames / 3);
+        std::printf("%-10s %-10s %10s %12s %12s %12s %10s\n", "effect", "storage", "particles", "size ratio",
+            "analytic ns", "scan us", "outside");
+
+        struct Scenario
+        {
+            const EffectPreset& preset;
+            ParticleStorageMode storageMode;
+        };
+        const Scenario scenarios[] = {
+            { s_Presets[0], ParticleStorageMode::Compact },
+            { s_Presets[1], ParticleStorageMode::Compact },
+            { s_Presets[1], ParticleStorageMode::Pool },
+            { s_Presets[2], ParticleStorageMode::Compact },
+            { s_Presets[3], ParticleStorageMode::Compact },
+            { s_Presets[4], ParticleStorageMode::Pool },
+        };
+        for (const Scenario& scenario : scenarios)
+        {
+            const EffectPreset& preset = scenario.preset;
+            ParticleSimCPU sim;
+            InitFromPreset(sim, preset);
+            sim.SetStorageMode(scenario.storageMode);
+            const bool pool = scenario.storageMode == ParticleStorageMode::Pool;
+
+            ParticleEvalBuffer eval;
+            float gameTime = 0.0f;
+            uint64_t particles = 0, outside = 0;
+            double sizeRatio = 0.0, analyticSeconds = 0.0, scanSeconds = 0.0;
+            int measured = 0;
+            for (int i = 0; i < frames; ++i)
+            {
+                if (i == frames / 3)
+                {
+                    sim.SetEmitPos(preset.emitPos + Float3{ 5.0f, 0.0f, 0.0f });
+                    sim.SetAcceleration(preset.accel * 1.5f + Float3{ 0.0f, 2.0f, 0.0f });
+                }
+                // Boom的壳只发射一轮，定期重置以持续产生爆炸
+                if (preset.type == ParticleEffectType::Boom && i > 0 && i % 240 == 0)
+                    sim.Reset();
+                sim.Update(dt, gameTime += dt);
+
+                auto start = Clock::now();
+                const ParticleBounds bounds = sim.GetBounds();
+                auto middle = Clock::now();
+
+                ParticleBounds actual;
+                outside += CountOutside(sim, eval, bounds, &actual);
+                auto end = Clock::now();
+                analyticSeconds += std::chrono::duration<double>(middle - start).count();
+                scanSeconds += std::chrono::duration<double>(end - middle).count();
+                particles += sim.GetParticleCount();
+
+                // 实际与解析包围盒对角线长度之比
+                if (!actual.IsEmpty() && !bounds.IsEmpty())
+                {
+                    const Float3 a = actual.max - actual.min, b = bounds.max - bounds.min;
+                    sizeRatio += std::sqrt(Dot(a, a) / Dot(b, b));
+                    ++measured;
+                }
+            }
+            std::printf("%-10s %-10s %10.0f %12.2f %12.0f %12.1f %10llu%s\n", preset.name,
+                pool ? "Pool" : "Compact", static_cast<double>(particles) / frames, measured ? sizeRatio / measured : 0.0,
+                analyticSeconds * 1.0e9 / frames, scanSeconds * 1.0e6 / frames,
+                static_cast<unsigned long long>(outside), outside ? "  NOT CONSERVATIVE" : "");
+            if (outside)
+                return 1;
+        }
+        return 0;
+    }
+
+    // 多发射器：一个系统的发射器表中放count个发射器，与count个各自独立的系统比较
+    // 两者发射的粒子数相同，前者共用一份存储，每帧只做一次发射与更新；另检查发射器表系统的包围盒是否保守
+    int RunEmitters(uint32_t count, int frames)
+    {
+        const float dt = 1.0f / 60.0f;
+        std::printf("%u emitters, %d frames\n", count, frames);
+        std::printf("%-10s %-8s %12s %12s %12s %10s\n", "effect", "tilted", "particles", "separate ms", "table ms", "outside");
+
+        // 发射器排成边长为side的方阵，间隔4
+        const uint32_t side = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<double>(count))));
+        auto emitterPos = [side](const EffectPreset& preset, uint32_t i) {
+            return preset.emitPos + Float3{ 4.0f * static_cast<float>(i % side), 0.0f, 4.0f * static_cast<float>(i / side) };
+        };
+
+        for (const EffectPreset* preset : { &s_Presets[0], &s_Presets[2], &s_Presets[3] })
+        {
+            for (bool tilted : { false, true })
+            {
+                std::vector<ParticleSimCPU> separate(count);
+                for (uint32_t i = 0; i < count; ++i)
+                {
+                    InitFromPreset(separate[i], *preset);
+                    separate[i].SetEmitPos(emitterPos(*preset, i));
+                }
+                // 系统自身的发射器算作第一个
+                ParticleSimCPU table;
+                table.Init(preset->type, preset->maxParticles * count);
+                table.SetEmitPos(preset->emitPos);
+                table.SetEmitDir({ 0.0f, 1.0f, 0.0f });
+                table.SetAcceleration(preset->accel);
+                table.SetEmitInterval(preset->emitInterval);
+                table.SetAliveTime(preset->aliveTime);
+                for (uint32_t i = 1; i < count; ++i)
+                {
+                    ParticleEmitterDesc desc;
+                    desc.pos = emitterPos(*preset, i);
+                    if (tilted)
+                        desc.dir = { std::cos(0.7f * i), 1.0f, std::sin(0.7f * i) };
+                    table.AddEmitter(desc);
+                }
+
+                ParticleEvalBuffer eval;
+                float gameTime = 0.0f;
+                double separateSeconds = 0.0, tableSeconds = 0.0;
+                uint64_t separateParticles = 0, tableParticles = 0, outside = 0;
+                for (int f = 0; f < frames; ++f)
+                {
+                    gameTime += dt;
+                    auto start = Clock::now();
+                    for (ParticleSimCPU& sim : separate)
+                        sim.Update(dt, gameTime);
+                    auto middle = Clock::now();
+                    table.Update(dt, gameTime);
+                    auto end = Clock::now();
+                    separateSeconds += std::chrono::duration<double>(middle - start).count();
+                    tableSeconds += std::chrono::duration<double>(end - middle).count();
+                    for (const ParticleSimCPU& sim : separate)
+                        separateParticles += sim.GetParticleCount();
+                    tableParticles += table.GetParticleCount();
+                    outside += CountOutside(table, eval, table.GetBounds());
+                }
+                // 方向倾斜时独立系统的粒子数不作比较
+                std::printf("%-10s %-8s %12.0f %12.3f %12.3f %10llu%s\n", preset->name, tilted ? "yes" : "no",
+                    static_cast<double>(tableParticles) / frames, separateSeconds * 1000.0 / frames,
+                    tableSeconds * 1000.0 / frames, static_cast<unsigned long long>(outside),
+                    outside ? "  NOT CONSERVATIVE" : (!tilted && separateParticles != tableParticles ? "  COUNT MISMATCH" : ""));
+                if (outside)
+                    return 1;
+            }
+        }
+        return 0;
+    }
+
+    // 按位置启用发射器：side x side个Fire发射器以间隔8排在xz平面上，相机沿+x穿过世界
+    // 与全部发射器都启用比较，世界边长依次翻倍，网格的开销应只与附近的发射器数有关
+    int RunActivation(uint32_t side, int frames)
+    {
+        const float dt = 1.0f / 60.0f;
+        const float spacing = 8.0f;
+        const EffectPreset& preset = s_Presets[0];
+        std::printf("%d frames, activate within 60, deactivate beyond 70\n", frames);
+        std::printf("%10s %10s %12s %12s %10s %10s %12s %12s\n", "emitters", "active", "all ms", "grid ms",
+            "update us", "tested", "all parts", "grid parts");
+
+        for (uint32_t worldSide : { side, side * 2, side * 4 })
+        {
+            const uint32_t count = worldSide * worldSide;
+            ParticleSimCPU all, grid;
+            for (ParticleSimCPU* sim : { &all, &grid })
+            {
+                // 系统自身的发射器放在世界之外
+                sim->Init(preset.type, count * 100);
+                sim->SetEmitPos({ -1.0e4f, 0.0f, 0.0f });
+                sim->SetEmitDir({ 0.0f, 1.0f, 0.0f });
+                sim->SetAcceleration(preset.accel);
+                sim->SetEmitInterval(preset.emitInterval);
+                sim->SetAliveTime(preset.aliveTime);
+                for (uint32_t i = 0; i < count; ++i)
+                {
+                    ParticleEmitterDesc desc;
+                    desc.pos = { spacing * static_cast<float>(i % worldSide), 0.0f, spacing * static_cast<float>(i / worldSide) };
+                    sim->AddEmitter(desc);
+                }
+            }
+            ParticleEmitterGrid index;
+            index.Build(grid, 2.0f * spacing);
+
+            const float worldSize = spacing * static_cast<float>(worldSide);
+            ParticleActivationView view;
+            view.activateDistance = 60.0f;
+            view.deactivateDistance = 70.0f;
+            float gameTime = 0.0f;
+            double allSeconds = 0.0, gridSeconds = 0.0, updateSeconds = 0.0;
+            uint64_t active = 0, tested = 0, allParticles = 0, gridParticles = 0;
+            for (int f = 0; f < frames; ++f)
+            {
+                // 沿世界的中线前进，每帧0.5
+                view.eye = { std::fmod(0.5f * static_cast<float>(f), worldSize), 2.0f, 0.5f * worldSize };
+                const ParticleFrustum frustum = MakeCameraFrustum(view.eye, 90.0f);
+                view.frustum = &frustum;
+                gameTime += dt;
+
+                auto start = Clock::now();
+                all.Update(dt, gameTime);
+                auto middle = Clock::now();
+                index.Update(grid, view, dt);
+                auto updated = Clock::now();
+                grid.Update(dt, gameTime);
+                auto end = Clock::now();
+                allSeconds += std::chrono::duration<double>(middle - start).count();
+                gridSeconds += std::chrono::duration<double>(end - middle).count();
+                updateSeconds += std::chrono::duration<double>(updated - middle).count();
+                active += index.GetStats().active;
+                tested += index.GetStats().emittersTested;
+                allParticles += all.GetParticleCount();
+                gridParticles += grid.GetParticleCount();
+            }
+            std::printf("%10u %10.1f %12.3f %12.3f %10.2f %10.1f %12.0f %12.0f\n", count,
+                static_cast<double>(active) / frames, allSeconds * 1000.0 / frames, gridSeconds * 1000.0 / frames,
+                updateSeconds * 1.0e6 / frames, static_cast<double>(tested) / frames,
+                static_cast<double>(allParticles) / frames, static_cast<double>(gridParticles) / frames);
+        }
+        return 0;
+    }
+
+    // 比较SeekTo与从头逐帧推进到同一时刻的结果与耗时
+    int RunSeek(float seconds)
+    {
+        const float dt = 1.0f / 60.0f;
+        const int frames = static_cast<int>(std::lround(seconds / dt));
+        std::printf("seek to %gs (%d frames)\n", seconds, frames);
+        std::printf("%-10s %10s %10s %12s %12s %12s\n", "effect", "stepped", "seek", "step ms", "seek ms", "max dpos");
+        for (const EffectPreset& preset : s_Presets)
+        {
+            ParticleSimCPU stepped, seek;
+            InitFromPreset(stepped, preset);
+            InitFromPreset(seek, preset);
+
+            auto start = Clock::now();
+            for (int f = 0; f < frames; ++f)
+                stepped.Update(dt, dt * static_cast<float>(f + 1));
+            auto middle = Clock::now();
+            seek.SeekTo(seconds, dt);
+            auto end = Clock::now();
+
+            // 两者顺序相同时逐个比较出生位置
+            std::vector<ParticleVertex> a(stepped.GetVertexCount()), b(seek.GetVertexCount());
+            stepped.ExportVertices(a.data(), static_cast<uint32_t>(a.size()));
+            seek.ExportVertices(b.data(), static_cast<uint32_t>(b.size()));
+            float maxError = 0.0f;
+            for (size_t i = 0; i < std::min(a.size(), b.size()); ++i)
+            {
+                const Float3 d = a[i].initialPos - b[i].initialPos;
+                maxError = std::max(maxError, std::sqrt(Dot(d, d)));
+            }
+            std::printf("%-10s %10u %10u %12.3f %12.3f %12g\n", preset.name, stepped.GetParticleCount(),
+                seek.GetParticleCount(), std::chrono::duration<double>(middle - start).count() * 1000.0,
+                std::chrono::duration<double>(end - middle).count() * 1000.0, maxError);
+        }
+        return 0;
+    }
+
+    // 144Hz绘制、中途卡顿一次时，比较每帧一步与不同的固定步长：模拟开销、单帧最多出生的粒子数与丢弃的时间
+    int RunFixedStep(float seconds)
+    {
+        const float renderDt = 1.0f / 144.0f;
+        const float hitch = 0.5f;
+        const int frames = static_cast<int>(std::lround(seconds / renderDt));
+        const EffectPreset& preset = s_Presets[2];
+        std::printf("%s, accumulated emission, %d frames at 144Hz, one %gs hitch\n", preset.name, frames, hitch);
+        std::printf("%-10s %10s %12s %12s %12s %12s\n", "step", "steps/f", "sim ms/f", "max burst", "dropped s", "lag ms");
+        for (float step : { 0.0f, 1.0f / 60.0f, 1.0f / 30.0f })
+        {
+            ParticleSimCPU sim;
+            InitFromPreset(sim, preset);
+            sim.SetEmissionMode(EmissionMode::Accumulated);
+            ParticleStepClock clock;
+            clock.SetStep(step);
+            clock.SetMaxSteps(4);
+
+            double simSeconds = 0.0, lagSeconds = 0.0;
+            uint64_t steps = 0;
+            uint32_t maxBurst = 0;
+            for (int f = 0; f < frames; ++f)
+            {
+                const float dt = f == frames / 2 ? hitch : renderDt;
+                auto start = Clock::now();
+                const uint32_t frameSteps = clock.Advance(dt);
+                for (uint32_t i = 0; i < frameSteps; ++i)
+                {
+                    sim.Update(clock.GetStepDelta(), clock.GetStepTime(i));
+                    std::pair<uint32_t, uint32_t> counts = sim.CountParticles();
+                    sim.SetParticleCount(counts.first, counts.second);
+                }
+                sim.SetRenderLag(clock.GetRenderLag());
+                auto end = Clock::now();
+                simSeconds += std::chrono::duration<double>(end - start).count();
+                lagSeconds += sim.GetRenderLag();
+                steps += frameSteps;
+                // 本帧出生的粒子：存活时间小于本帧推进的时间
+                const float simulated = static_cast<float>(frameSteps) * clock.GetStepDelta();
+                const float* ages = sim.GetParticles().GetAges();
+                uint32_t born = 0;
+                for (uint32_t i = 0; i < sim.GetParticleCount(); ++i)
+                    born += ages[i] < simulated;
+                maxBurst = std::max(maxBurst, born);
+            }
+            char label[16];
+            std::snprintf(label, sizeof(label), step > 0.0f ? "%.0fHz" : "per-frame", step > 0.0f ? 1.0f / step : 0.0f);
+            std::printf("%-10s %10.2f %12.4f %12u %12.3f %12.3f\n", label, static_cast<double>(steps) / frames,
+                simSeconds * 1000.0 / frames, maxBurst, clock.GetDroppedTime(), lagSeconds * 1000.0 / frames);
+        }
+        return 0;
+    }
+
+    // 以不同的工作线程数运行同一模拟，逐帧比较状态散列与单线程的参考是否逐位相同
+    // 非Boom的特效按累计时间发射约20000个粒子，跨越多个块；Fire另加16个发射器表中的发射器
+    int RunDeterminism(int frames)
+    {
+        const float dt = 1.0f / 60.0f;
+        const uint32_t workerCounts[] = { 0, 1, 3, 7 };
+        std::printf("%d frames, per-frame state hashes against a single-threaded reference\n", frames);
+        std::printf("%-10s %-10s %10s %10s %8s %8s %8s %8s %18s\n", "effect", "storage", "peak", "hash ms",
+            "0 wk", "1 wk", "3 wk", "7 wk", "final hash");
+
+        struct Scenario
+        {
+            const EffectPreset& preset;
+            ParticleStorageMode storageMode;
+        };
+        const Scenario scenarios[] = {
+            { s_Presets[0], ParticleStorageMode::Compact },
+            { s_Presets[0], ParticleStorageMode::BirthRing },
+            { s_Presets[1], ParticleStorageMode::Compact },
+            { s_Presets[1], ParticleStorageMode::Pool },
+            { s_Presets[2], ParticleStorageMode::Compact },
+            { s_Presets[3], ParticleStorageMode::Compact },
+            { s_Presets[4], ParticleStorageMode::Compact },
+            { s_Presets[4], ParticleStorageMode::Pool },
+        };
+        // 返回运行期间的最大粒子数
+        auto run = [&](const Scenario& scenario, JobSystem* jobs, uint64_t seed, ParticleStateChecker& checker, double* hashSeconds) {
+            EffectPreset preset = scenario.preset;
+            ParticleSimCPU sim;
+            if (preset.type != ParticleEffectType::Boom)
+                preset.maxParticles = 40000;
+            InitFromPreset(sim, preset);
+            sim.SetSeed(seed);
+            if (preset.type != ParticleEffectType::Boom)
+            {
+                sim.SetEmissionMode(EmissionMode::Accumulated);
+                sim.SetEmitInterval(preset.aliveTime / 20000.0f);
+            }
+            if (preset.type == ParticleEffectType::Fire && scenario.storageMode == ParticleStorageMode::Compact)
+            {
+                for (uint32_t i = 0; i < 16; ++i)
+                {
+                    ParticleEmitterDesc desc;
+                    desc.pos = { 2.0f * static_cast<float>(i % 4), 0.0f, 2.0f * static_cast<float>(i / 4) };
+                    desc.interval = 0.01f;
+                    sim.AddEmitter(desc);
+                }
+            }
+            sim.SetStorageMode(scenario.storageMode);
+            uint32_t peak = 0;
+            for (int f = 0; f < frames; ++f)
+            {
+                sim.Update(dt, dt * static_cast<float>(f + 1), jobs);
+                std::pair<uint32_t, uint32_t> counts = sim.CountParticles();
+                sim.SetParticleCount(counts.first, counts.second);
+                auto start = Clock::now();
+                const uint64_t hash = sim.ComputeStateHash(jobs);
+                if (hashSeconds)
+                    *hashSeconds += std::chrono::duration<double>(Clock::now() - start).count();
+                checker.Check(sim.GetFrameIndex(), hash);
+                peak = std::max(peak, sim.GetParticleCount());
+            }
+            return peak;
+        };
+
+        bool allMatch = true;
+        for (const Scenario& scenario : scenarios)
+        {
+            ParticleStateChecker reference;
+            double hashSeconds = 0.0;
+            const uint32_t particles = run(scenario, nullptr, 0, reference, &hashSeconds);
+
+            char results[4][16];
+            for (int w = 0; w < 4; ++w)
+            {
+                JobSystem jobs(workerCounts[w]);
+                ParticleStateChecker checker;
+                checker.SetReference(reference.GetLog());
+                run(scenario, &jobs, 0, checker, nullptr);
+                allMatch = allMatch && !checker.HasDiverged();
+                if (checker.HasDiverged())
+                    std::snprintf(results[w], sizeof(results[w]), "f%u", checker.GetFirstDivergentFrame());
+                else
+                    std::snprintf(results[w], sizeof(results[w]), "same");
+            }
+            std::printf("%-10s %-10s %10u %10.3f %8s %8s %8s %8s   %016llx\n", scenario.preset.name,
+                scenario.storageMode == ParticleStorageMode::Compact ? "Compact" :
+                scenario.storageMode == ParticleStorageMode::BirthRing ? "BirthRing" : "Pool",
+                particles, hashSeconds * 1000.0 / frames, results[0], results[1], results[2], results[3],
+                static_cast<unsigned long long>(reference.GetLog().back().hash));
+        }
+
+        // 检查比对本身：换一个种子应在第一帧就不一致
+        ParticleStateChecker reference, reseeded;
+        run(scenarios[0], nullptr, 0, reference, nullptr);
+        reseeded.SetReference(reference.GetLog());
+        run(scenarios[0], nullptr, 1, reseeded, nullptr);
+        std::printf("Fire with another seed: %s\n", reseeded.HasDiverged() ? "diverged" : "NOT DETECTED");
+        if (reseeded.HasDiverged())
+            std::printf("  first divergent frame %u\n", reseeded.GetFirstDivergentFrame());
+        return allMatch && reseeded.HasDiverged() ? 0 : 1;
+    }
+
+    void PrintUsage()
+    {
+        std::printf("usage: ParticleSimBench [sim [frames] [dt] | kernels | emission [seconds] | storage [particles] | pool [particles] [frames] | burst [shells] | subemit [seconds] | readback [frames] | random | serialize [particles] | scale [particles] [frames] | packed [particles] | sort | coherent [particles] [frames] [degrees] | cull [particles] | bounds [frames] | emitters [count] [frames] | activation [side] [frames] | seek [seconds] | fixedstep [seconds] | determinism [frames]]\n");
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const char* mode = argc > 1 ? argv[1] : "sim";
+
+    if (std::strcmp(mode, "sim") == 0)
+    {
+        int frames = 600;
+        float dt = 1.0f / 60.0f;
+        if (argc > 2)
+            frames = std::max(1, std::atoi(argv[2]));
+        if (argc > 3)
+            dt = static_cast<float>(std::atof(argv[3]));
+        return RunSimulation(frames, dt);
+    }
+    if (std::strcmp(mode, "kernels") == 0)
+        return RunKernels();
+    if (std::strcmp(mode, "emission") == 0)
+        return RunEmission(argc > 2 ? static_cast<float>(std::atof(argv[2])) : 2.0f);
+    if (std::strcmp(mode, "storage") == 0)
+        return RunStorage(argc > 2 ? static_cast<uint32_t>(std::max(1, std::atoi(argv[2]))) : 1000000u);
+    if (std::strcmp(mode, "pool") == 0)
+    {
+        uint32_t particles = 1000000;
+        int frames = 120;
+        if (argc > 2)
+            particles = static_cast<uint32_t>(std::max(1, std::atoi(argv[2])));
+        if (argc > 3)
+            frames = std::max(1, std::atoi(argv[3]));
+        return RunPool(particles, frames);
+    }
+    if (std::strcmp(mode, "burst") == 0)
+        return RunBurst(argc > 2 ? static_cast<uint32_t>(std::max(1, std::atoi(argv[2]))) : 10000u);
+    if (std::strcmp(mode, "subemit") == 0)
+        return RunSubEmitter(argc > 2 ? static_cast<float>(std::atof(argv[2])) : 2.5f);
+    if (std::strcmp(mode, "readback") == 0)
+        return RunReadback(argc > 2 ? std::max(1, std::atoi(argv[2])) : 600);
+    if (std::strcmp(mode, "random") == 0)
+        return RunRandom();
+    if (std::strcmp(mode, "serialize") == 0)
+        return RunSerialize(argc > 2 ? static_cast<uint32_t>(std::max(1, std::atoi(argv[2]))) : 1000000u);
+    if (std::strcmp(mode, "packed") == 0)
+        return RunPacked(argc > 2 ? static_cast<uint32_t>(std::max(1, std::atoi(argv[2]))) : 200000u);
+    if (std::strcmp(mode, "sort") == 0)
+        return RunSort();
+    if (std::strcmp(mode, "bounds") == 0)
+        return RunBounds(argc > 2 ? std::max(1, std::atoi(argv[2])) : 900);
+    if (std::strcmp(mode, "emitters") == 0)
+    {
+        uint32_t count = 64;
+        int frames = 300;
+        if (argc > 2)
+            count = static_cast<uint32_t>(std::max(1, std::atoi(argv[2])));
+        if (argc > 3)
+            frames = std::max(1, std::atoi(argv[3]));
+        return RunEmitters(count, frames);
+    }
+    if (std::strcmp(mode, "activation") == 0)
+    {
+        uint32_t side = 32;
+        int frames = 300;
+        if (argc > 2)
+            side = static_cast<uint32_t>(std::max(1, std::atoi(argv[2])));
+        if (argc > 3)
+            frames = std::max(1, std::atoi(argv[3]));
+        return RunActivation(side, frames);
+    }
+    if (std::strcmp(mode, "seek") == 0)
+        return RunSeek(argc > 2 ? static_cast<float>(std::atof(argv[2])) : 60.0f);
+    if (std::strcmp(mode, "fixedstep") == 0)
+        return RunFixedStep(argc > 2 ? static_cast<float>(std::atof(argv[2])) : 10.0f);
+    if (std::strcmp(mode, "determinism") == 0)
+        return RunDeterminism(argc > 2 ? std::max(1, std::atoi(argv[2])) : 300);
+    if (std::strcmp(mode, "cull") == 0)
+        return RunCull(argc > 2 ? static_cast<uint32_t>(std::max(1, std::atoi(argv[2]))) : 200000u);
+    if (std::strcmp(mode, "coherent") == 0)
+    {
+        uint32_t particles = 200000;
+        int frames = 120;
+        float degreesPerFrame = 0.25f;
+        if (argc > 2)
+            particles = static_cast<uint32_t>(std::max(1, std::atoi(argv[2])));
+        if (argc > 3)
+            frames = std::max(1, std::atoi(argv[3]));
+        if (argc > 4)
+            degreesPerFrame = static_cast<float>(std::atof(argv[4]));
+        return RunCoherentSort(particles, frames, degreesPerFrame);
+    }
+    if (std::strcmp(mode, "scale") == 0)
+    {
+        uint32_t particles = 200000;
+        int frames = 120;
+        if (argc > 2)
+            particles = static_cast<uint32_t>(std::max(1, std::atoi(argv[2])));
+        if (argc > 3)
+            frames = std::max(1, std::atoi(argv[3]));
+        return RunScaling(particles, frames);
+    }
+
+    PrintUsage();
+    return 1;
+}
@@ -0,0 +1,150 @@
+#include "JobSystem.h"
+#include <algorithm>
+#include <chrono>
+
+namespace
+{
+    // 标记当前线程属于哪个任务系统的哪个队列
+    thread_local const JobSystem* t_pOwner = nullptr;
+    thread_local uint32_t t_QueueIndex = 0;
+}
+
+JobSystem::JobSystem(uint32_t workerCount)
+{
+    // 最后一个队列供外部线程提交任务
+    for (uint32_t i = 0; i <= workerCount; ++i)
+        m_Queues.push_back(std::make_unique<WorkQueue>());
+
+    m_Workers.reserve(workerCount);
+    for (uint32_t i = 0; i < workerCount; ++i)
+        m_Workers.emplace_back(&JobSystem::WorkerLoop, this, i);
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_SleepMutex);
+        m_Quit = true;
+    }
+    m_WakeUp.notify_all();
+    for (std::thread& worker : m_Workers)
+        worker.join();
+}
+
+uint32_t JobSystem::DefaultWorkerCount()
+{
+    uint32_t hardwareThreads = std::thread::hardware_concurrency();
+    return hardwareThreads > 1 ? hardwareThreads - 1 : 0;
+}
+
+void JobSystem::ParallelFor(uint32_t count, uint32_t grainSize, const RangeFunc& func)
+{
+    if (count == 0)
+        return;
+    grainSize = std::max(grainSize, 1u);
+    uint32_t jobCount = (count + grainSize - 1) / grainSize;
+
+    // 没有工作线程或只有一个任务时直接执行
+    if (m_Workers.empty() || jobCount == 1)
+    {
+        func(0, count);
+        return;
+    }
+
+    std::atomic<uint32_t> pending{ jobCount };
+    uint32_t queueIndex = GetLocalQueue();
+
+    // 第一个任务留给自己，其余的放入本线程的队列供其他线程窃取
+    // 逆序放入，使本线程按顺序从尾部取出
+    for (uint32_t j = jobCount - 1; j > 0; --j)
+    {
+        uint32_t begin = j * grainSize;
+        Push(queueIndex, Job{ &func, begin, std::min(begin + grainSize, count), &pending });
+    }
+
+    func(0, std::min(grainSize, count));
+    pending.fetch_sub(1, std::memory_order_acq_rel);
+
+    // 等待期间帮助执行其他任务(包括嵌套提交的任务)
+    while (pending.load(std::memory_order_acquire) > 0)
+    {
+        if (!TryRunOne(queueIndex))
+            std::this_thread::yield();
+    }
+}
+
+uint32_t JobSystem::GetLocalQueue() const
+{
+    if (t_pOwner == this)
+        return t_QueueIndex;
+    return static_cast<uint32_t>(m_Queues.size() - 1);
+}
+
+void JobSystem::Push(uint32_t queueIndex, const Job& job)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Queues[queueIndex]->mutex);
+        m_Queues[queueIndex]->jobs.push_back(job);
+    }
+    m_QueuedJobs.fetch_add(1, std::memory_order_release);
+    {
+        // 加锁保证正在进入睡眠的线程不会错过通知
+        std::lock_guard<std::mutex> lock(m_SleepMutex);
+    }
+    m_WakeUp.notify_one();
+}
+
+bool JobSystem::TryRunOne(uint32_t queueIndex)
+{
+    Job job{};
+    bool found = false;
+
+    {
+        WorkQueue& local = *m_Queues[queueIndex];
+        std::lock_guard<std::mutex> lock(local.mutex);
+        if (!local.jobs.empty())
+        {
+            job = local.jobs.back();
+            local.jobs.pop_back();
+            found = true;
+        }
+    }
+
+    const uint32_t queueCount = static_cast<uint32_t>(m_Queues.size());
+    for (uint32_t i = 1; i < queueCount && !found; ++i)
+    {
+        WorkQueue& victim = *m_Queues[(queueIndex + i) % queueCount];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.jobs.empty())
+        {
+            job = victim.jobs.front();
+            victim.jobs.pop_front();
+            found = true;
+        }
+    }
+
+    if (!found)
+        return false;
+
+    m_QueuedJobs.fetch_sub(1, std::memory_order_relaxed);
+    (*job.func)(job.begin, job.end);
+    job.pending->fetch_sub(1, std::memory_order_acq_rel);
+    return true;
+}
+
+void JobSystem::WorkerLoop(uint32_t index)
+{
+    t_pOwner = this;
+    t_QueueIndex = index;
+
+    while (!m_Quit.load(std::memory_order_acquire))
+    {
+        if (TryRunOne(index))
+            continue;
+
+        std::unique_lock<std::mutex> lock(m_SleepMutex);
+        m_WakeUp.wait_for(lock, std::chrono::milliseconds(1), [this]() {
+            return m_Quit.load(std::memory_order_acquire) || m_QueuedJobs.load(std::memory_order_acquire) > 0;
+        });
+    }
+}
@@ -0,0 +1,96 @@
+//***************************************************************************************
+// JobSystem.h
+//
+// 工作窃取式任务系统，每个工作线程拥有自己的任务队列，空闲时从其他队列窃取
+// Work-stealing job system: each worker owns a queue and steals from the others
+// when idle.
+//***************************************************************************************
+
+#pragma once
+
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class JobSystem
+{
+public:
+    using RangeFunc = std::function<void(uint32_t begin, uint32_t end)>;
+
+    // workerCount为0时不创建工作线程，所有任务在调用线程上执行
+    explicit JobSystem(uint32_t workerCount = DefaultWorkerCount());
+    ~JobSystem();
+    // 不允许拷贝与移动
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    // 硬件线程数减去调用线程
+    static uint32_t DefaultWorkerCount();
+
+    uint32_t GetWorkerCount() const { return static_cast<uint32_t>(m_Workers.size()); }
+    // 参与执行任务的线程数(包括调用线程)
+    uint32_t GetThreadCount() const { return GetWorkerCount() + 1; }
+
+    // 将[0, count)按grainSize划分为任务并行执行，返回时全部完成
+    // 可在任务内部嵌套调用，等待期间当前线程会继续执行其他任务
+    void ParallelFor(uint32_t count, uint32_t grainSize, const RangeFunc& func);
+
+    // 将[0, count)均分为blockCount块，对每块执行func(block, begin, end)
+    // jobs为空或只有一块时在调用线程上依次执行
+    template<class Func>
+    static void ForEachBlock(JobSystem* jobs, uint32_t blockCount, uint32_t count, Func&& func)
+    {
+        const uint32_t blockSize = (count + blockCount - 1) / blockCount;
+        auto range = [&](uint32_t begin, uint32_t end) {
+            for (uint32_t b = begin; b < end; ++b)
+                func(b, std::min(count, b * blockSize), std::min(count, (b + 1) * blockSize));
+        };
+        if (jobs && blockCount > 1)
+            jobs->ParallelFor(blockCount, 1, range);
+        else
+            range(0, blockCount);
+    }
+
+private:
+    struct Job
+    {
+        const RangeFunc* func;
+        uint32_t begin;
+        uint32_t end;
+        std::atomic<uint32_t>* pending;
+    };
+
+    // 每个队列独占缓存行，避免伪共享
+    struct alignas(64) WorkQueue
+    {
+        std::mutex mutex;
+        std::deque<Job> jobs;
+    };
+
+    // 当前线程对应的队列，外部线程共用最后一个队列
+    uint32_t GetLocalQueue() const;
+    void Push(uint32_t queueIndex, const Job& job);
+    // 先从自己队列的尾部取(后进先出)，再从其他队列的头部窃取(先进先出)
+    bool TryRunOne(uint32_t queueIndex);
+    void WorkerLoop(uint32_t index);
+
+    std::vector<std::unique_ptr<WorkQueue>> m_Queues;
+    std::vector<std::thread> m_Workers;
+
+    std::mutex m_SleepMutex;
+    std::condition_variable m_WakeUp;
+    std::atomic<uint32_t> m_QueuedJobs{ 0 };
+    std::atomic<bool> m_Quit{ false };
+};
+
+#endif
@@ -0,0 +1,154 @@
+#include "ParticleBounds.h"
+#include "ParticleKernels.h"
+#include <cmath>
+
+namespace
+{
+    // f(t) = p + v * t + 0.5 * a * t^2在[0, maxTime]上的最小值(lower)或最大值
+    float SweepAxis(float p, float v, float a, float maxTime, bool lower)
+    {
+        auto pick = [lower](float x, float y) { return lower ? std::min(x, y) : std::max(x, y); };
+        float result = pick(p, p + v * maxTime + 0.5f * a * maxTime * maxTime);
+        // 开口朝向所求的方向时极值可能在顶点处
+        if (lower ? a > 0.0f : a < 0.0f)
+        {
+            float t = -v / a;
+            if (t > 0.0f && t < maxTime)
+                result = pick(result, p + v * t + 0.5f * a * t * t);
+        }
+        return result;
+    }
+
+    // 区间[lo, hi]乘以s
+    void ScaleInterval(float lo, float hi, float s, float& outLo, float& outHi)
+    {
+        outLo = std::min(lo * s, hi * s);
+        outHi = std::max(lo * s, hi * s);
+    }
+
+    bool IsFinite(const ParticleBounds& bounds)
+    {
+        return std::isfinite(bounds.min.x) && std::isfinite(bounds.min.y) && std::isfinite(bounds.min.z) &&
+            std::isfinite(bounds.max.x) && std::isfinite(bounds.max.y) && std::isfinite(bounds.max.z);
+    }
+}
+
+ParticleBounds ScaleBounds(const ParticleBounds& bounds, const Float3& scale)
+{
+    if (bounds.IsEmpty())
+        return bounds;
+    ParticleBounds result;
+    ScaleInterval(bounds.min.x, bounds.max.x, scale.x, result.min.x, result.max.x);
+    ScaleInterval(bounds.min.y, bounds.max.y, scale.y, result.min.y, result.max.y);
+    ScaleInterval(bounds.min.z, bounds.max.z, scale.z, result.min.z, result.max.z);
+    return result;
+}
+
+ParticleBounds ScaleBounds(const ParticleBounds& bounds, float scale)
+{
+    return ScaleBounds(bounds, { scale, scale, scale });
+}
+
+ParticleBounds AnyRotationBounds(const ParticleBounds& bounds)
+{
+    if (bounds.IsEmpty() || bounds.IsInfinite())
+        return bounds;
+    auto farthest = [](float lo, float hi) { return std::max(lo * lo, hi * hi); };
+    const float r = std::sqrt(farthest(bounds.min.x, bounds.max.x) + farthest(bounds.min.y, bounds.max.y) +
+        farthest(bounds.min.z, bounds.max.z));
+    return ParticleBounds::Range({ -r, -r, -r }, { r, r, r });
+}
+
+ParticleBounds SweepTrajectory(const ParticleBounds& origin, const ParticleBounds& velocity,
+    const ParticleBounds& accel, float maxTime)
+{
+    if (origin.IsEmpty() || velocity.IsEmpty() || accel.IsEmpty())
+        return {};
+    if (!(maxTime < FLT_MAX) || origin.IsInfinite() || velocity.IsInfinite() || accel.IsInfinite())
+        return ParticleBounds::Infinite();
+    maxTime = std::max(maxTime, 0.0f);
+
+    // 对t >= 0，各项系数取下界时轨迹处处不高于任一粒子，取上界时处处不低于
+    ParticleBounds result;
+    result.min.x = SweepAxis(origin.min.x, velocity.min.x, accel.min.x, maxTime, true);
+    result.min.y = SweepAxis(origin.min.y, velocity.min.y, accel.min.y, maxTime, true);
+    result.min.z = SweepAxis(origin.min.z, velocity.min.z, accel.min.z, maxTime, true);
+    result.max.x = SweepAxis(origin.max.x, velocity.max.x, accel.max.x, maxTime, false);
+    result.max.y = SweepAxis(origin.max.y, velocity.max.y, accel.max.y, maxTime, false);
+    result.max.z = SweepAxis(origin.max.z, velocity.max.z, accel.max.z, maxTime, false);
+    return IsFinite(result) ? result : ParticleBounds::Infinite();
+}
+
+ParticleBounds SweepSpawnRange(const ParticleSpawnRange& range, const ParticleAppearance& appearance,
+    float lifetime, bool withBillboard)
+{
+    // 与EvaluateParticlePosition相同：t = min(age, maxTime)
+    const ParticleBounds accel = appearance.perParticleAccel ?
+        ScaleBounds(range.accel, appearance.accelScale) : ParticleBounds::Point(appearance.accelScale);
+    ParticleBounds bounds = SweepTrajectory(range.origin, range.velocity, accel, std::min(lifetime, appearance.maxTime));
+    if (!withBillboard || bounds.IsEmpty() || bounds.IsInfinite())
+        return bounds;
+
+    // 半尺寸是尺寸与存活时间的线性函数，最大绝对值在两者范围的端点处
+    const float ageSpan = appearance.sizeAgeSlope != 0.0f ? appearance.sizeAgeSlope * lifetime : 0.0f;
+    float radius = 0.0f;
+    for (float size : { range.minSize, range.maxSize })
+    {
+        const float halfStart = appearance.sizeScale * size + appearance.sizeBias;
+        radius = std::max({ radius, std::abs(halfStart), std::abs(halfStart + ageSpan) });
+    }
+    radius *= 1.41421356f;
+    if (!std::isfinite(radius))
+        return ParticleBounds::Infinite();
+    bounds.Expand(radius);
+    return IsFinite(bounds) ? bounds : ParticleBounds::Infinite();
+}
+
+void ParticleBoundsTracker::Reset()
+{
+    *this = ParticleBoundsTracker();
+}
+
+void ParticleBoundsTracker::Advance(float dt)
+{
+    // 以推进前的时刻判断，旧粒子在到期后的这一帧中才会因超过寿命而消亡
+    if (m_Clock > m_RetiredUntil && m_Frame > m_RetiredUntilFrame)
+        m_Retired = {};
+    m_Clock += dt;
+    ++m_Frame;
+}
+
+void ParticleBoundsTracker::SetBounds(const ParticleSystemBounds& bounds)
+{
+    if (m_HasCurrent && m_Current.bounds != bounds.bounds)
+        AddRetired(m_Current);
+    m_Current = bounds;
+    m_HasCurrent = true;
+}
+
+void ParticleBoundsTracker::SetBounds(const ParticleSystemBounds& bounds, const ParticleSystemBounds& live)
+{
+    // live已覆盖此前的全部粒子，之前保留的范围不再需要
+    m_Retired = {};
+    m_RetiredUntil = 0.0;
+    m_RetiredUntilFrame = 0;
+    AddRetired(live);
+    m_Current = bounds;
+    m_HasCurrent = true;
+}
+
+void ParticleBoundsTracker::AddRetired(const ParticleSystemBounds& bounds)
+{
+    if (bounds.bounds.IsEmpty())
+        return;
+    m_Retired.Merge(bounds.bounds);
+    m_RetiredUntil = std::max(m_RetiredUntil, m_Clock + bounds.maxAge);
+    m_RetiredUntilFrame = std::max(m_RetiredUntilFrame, m_Frame + bounds.trailingFrames);
+}
+
+ParticleBounds ParticleBoundsTracker::GetBounds() const
+{
+    ParticleBounds bounds = m_Current.bounds;
+    bounds.Merge(m_Retired);
+    return bounds;
+}
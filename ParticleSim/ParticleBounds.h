@@ -0,0 +1,146 @@
+//***************************************************************************************
+// ParticleBounds.h
+//
+// 由闭式轨迹与参数范围求出粒子系统的保守包围盒，无需访问粒子
+// Conservative bounding boxes of particle systems derived from the closed-form
+// trajectory and parameter ranges, without touching particles.
+//***************************************************************************************
+
+#pragma once
+
+#ifndef PARTICLE_BOUNDS_H
+#define PARTICLE_BOUNDS_H
+
+#include <cstdint>
+#include <cfloat>
+#include <algorithm>
+#include "ParticleSimTypes.h"
+
+struct ParticleAppearance;
+
+// 轴对齐包围盒，min的某一分量大于max时为空
+struct ParticleBounds
+{
+    Float3 min = { FLT_MAX, FLT_MAX, FLT_MAX };
+    Float3 max = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+    static ParticleBounds Point(const Float3& p) { return { p, p }; }
+    static ParticleBounds Range(const Float3& lo, const Float3& hi) { return { lo, hi }; }
+    static ParticleBounds Infinite() { return { { -FLT_MAX, -FLT_MAX, -FLT_MAX }, { FLT_MAX, FLT_MAX, FLT_MAX } }; }
+
+    bool IsEmpty() const { return min.x > max.x || min.y > max.y || min.z > max.z; }
+    bool IsInfinite() const
+    {
+        return min.x == -FLT_MAX || min.y == -FLT_MAX || min.z == -FLT_MAX ||
+            max.x == FLT_MAX || max.y == FLT_MAX || max.z == FLT_MAX;
+    }
+    Float3 GetCenter() const { return 0.5f * (min + max); }
+    Float3 GetExtents() const { return 0.5f * (max - min); }
+
+    void Merge(const ParticleBounds& other)
+    {
+        min = { std::min(min.x, other.min.x), std::min(min.y, other.min.y), std::min(min.z, other.min.z) };
+        max = { std::max(max.x, other.max.x), std::max(max.y, other.max.y), std::max(max.z, other.max.z) };
+    }
+    // 各方向向外扩展r
+    void Expand(float r)
+    {
+        if (IsEmpty())
+            return;
+        min = min - Float3{ r, r, r };
+        max = max + Float3{ r, r, r };
+    }
+
+    bool operator==(const ParticleBounds& other) const
+    {
+        return min.x == other.min.x && min.y == other.min.y && min.z == other.min.z &&
+            max.x == other.max.x && max.y == other.max.y && max.z == other.max.z;
+    }
+    bool operator!=(const ParticleBounds& other) const { return !(*this == other); }
+};
+
+// 逐分量的区间乘法：scale * [lo, hi]
+ParticleBounds ScaleBounds(const ParticleBounds& bounds, const Float3& scale);
+ParticleBounds ScaleBounds(const ParticleBounds& bounds, float scale);
+
+// 绕原点任意旋转后的范围：以原点为中心、最远顶点的距离为半边长的立方体
+ParticleBounds AnyRotationBounds(const ParticleBounds& bounds);
+
+// origin + velocity * t + 0.5 * accel * t^2在t∈[0, maxTime]上的范围，三者各分量均可取区间内的任意值
+// 逐轴分别取区间下界/上界的抛物线在[0, maxTime]上的极值，maxTime不是有限值时为无穷大的包围盒
+ParticleBounds SweepTrajectory(const ParticleBounds& origin, const ParticleBounds& velocity,
+    const ParticleBounds& accel, float maxTime);
+
+// 一类粒子出生时各项参数的范围
+struct ParticleSpawnRange
+{
+    uint32_t type = PT_PARTICLE;
+    ParticleBounds origin;
+    ParticleBounds velocity = ParticleBounds::Point({});
+    ParticleBounds accel = ParticleBounds::Point({});      // 粒子自身的accel，按外观参数决定是否使用
+    float minSize = 0.0f;
+    float maxSize = 0.0f;
+
+    // 各项均为空的范围，之后逐个合并已存在的粒子
+    static ParticleSpawnRange Empty(uint32_t type)
+    {
+        ParticleSpawnRange range;
+        range.type = type;
+        range.velocity = {};
+        range.accel = {};
+        range.minSize = FLT_MAX;
+        range.maxSize = -FLT_MAX;
+        return range;
+    }
+    void Merge(const ParticleVertex& v)
+    {
+        origin.Merge(ParticleBounds::Point(v.initialPos));
+        velocity.Merge(ParticleBounds::Point(v.initialVel));
+        accel.Merge(ParticleBounds::Point(v.accel));
+        minSize = std::min(minSize, std::min(v.size.x, v.size.y));
+        maxSize = std::max(maxSize, std::max(v.size.x, v.size.y));
+    }
+};
+
+// 按外观参数与寿命求出该类粒子在整个寿命内的包围盒
+// withBillboard为真时加上面向相机的四边形：半尺寸在尺寸范围与寿命的两端取最大绝对值，外接球半径为其sqrt(2)倍
+ParticleBounds SweepSpawnRange(const ParticleSpawnRange& range, const ParticleAppearance& appearance,
+    float lifetime, bool withBillboard);
+
+// 一组参数对应的包围盒及参数改变后现有粒子(含其后代)仍可能存在的时长
+struct ParticleSystemBounds
+{
+    ParticleBounds bounds;
+    float maxAge = 0.0f;                // 粒子及其各级后代全部消亡所需的最长时间
+    uint32_t trailingFrames = 0;        // 按帧计数的后续发射(Boom壳的散开)额外持续的帧数
+};
+
+// 维护系统的包围盒：参数改变时由调用者提供新的结果，此前的粒子全部消亡前另外保留一个覆盖它们的包围盒
+class ParticleBoundsTracker
+{
+public:
+    void Reset();
+    void Advance(float dt);
+
+    // 只影响今后发射的粒子的参数改变时，旧的包围盒仍覆盖此前的粒子，保留至其全部消亡
+    void SetBounds(const ParticleSystemBounds& bounds);
+    // 影响现有粒子轨迹的参数改变时，以覆盖现有粒子及其后代的live替换此前保留的包围盒
+    void SetBounds(const ParticleSystemBounds& bounds, const ParticleSystemBounds& live);
+
+    const ParticleSystemBounds& GetCurrent() const { return m_Current; }
+    // 当前参数与仍有效的旧包围盒的并集
+    ParticleBounds GetBounds() const;
+
+private:
+    void AddRetired(const ParticleSystemBounds& bounds);
+
+    double m_Clock = 0.0;
+    uint64_t m_Frame = 0;
+    bool m_HasCurrent = false;
+    ParticleSystemBounds m_Current;
+    ParticleBounds m_Retired;
+    double m_RetiredUntil = 0.0;
+    uint64_t m_RetiredUntilFrame = 0;
+};
+
+#endif
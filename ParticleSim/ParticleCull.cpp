@@ -0,0 +1,203 @@
+#include "ParticleCull.h"
+#include "ParticleSimCPU.h"
+#include "ParticleSimd.h"
+#include "JobSystem.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+    // 按平面广播后的系数
+    template<class S>
+    struct FrustumPlanes
+    {
+        S a[ParticleFrustum::PlaneCount];
+        S b[ParticleFrustum::PlaneCount];
+        S c[ParticleFrustum::PlaneCount];
+        S d[ParticleFrustum::PlaneCount];
+
+        explicit FrustumPlanes(const ParticleFrustum& frustum)
+        {
+            for (int p = 0; p < ParticleFrustum::PlaneCount; ++p)
+            {
+                a[p] = S::Set1(frustum.planes[p][0]);
+                b[p] = S::Set1(frustum.planes[p][1]);
+                c[p] = S::Set1(frustum.planes[p][2]);
+                d[p] = S::Set1(frustum.planes[p][3]);
+            }
+        }
+    };
+
+    // 测试从i开始的S::Width个粒子，可见的通道在返回值中对应的位为1
+    template<class S>
+    int TestSpheres(const ParticleEvalBuffer& eval, uint32_t i, const FrustumPlanes<S>& planes)
+    {
+        const S zero = S::Set1(0.0f);
+        const S x = S::Load(eval.GetPosX() + i);
+        const S y = S::Load(eval.GetPosY() + i);
+        const S z = S::Load(eval.GetPosZ() + i);
+        const S w = S::Load(eval.GetHalfWidth() + i);
+        const S h = S::Load(eval.GetHalfHeight() + i);
+        // 尺寸随时间递减时半尺寸可能为负，几何着色器展开的四边形大小取其绝对值
+        // 面向相机的四边形外接球半径为sqrt(w^2 + h^2) <= sqrt(2) * max(|w|, |h|)
+        const S negRadius = S::Set1(-1.41421356f) * Max(Max(w, zero - w), Max(h, zero - h));
+        int mask = (1 << S::Width) - 1;
+        for (int p = 0; p < ParticleFrustum::PlaneCount && mask; ++p)
+        {
+            const S dist = planes.a[p] * x + planes.b[p] * y + planes.c[p] * z + planes.d[p];
+            // 位置为NaN时比较失败，同样被剔除
+            mask &= MoveMask(CmpLessEqual(negRadius, dist));
+        }
+        return mask;
+    }
+
+    uint32_t GetBlockCount(uint32_t count, JobSystem* jobs)
+    {
+        const uint32_t threads = jobs ? jobs->GetThreadCount() : 1;
+        return std::max(1u, std::min(threads, count / ParticleFrustumCuller::MinBlockSize));
+    }
+}
+
+ParticleFrustum ParticleFrustum::FromViewProj(const float m[4][4])
+{
+    // 行向量约定下裁剪坐标的各分量为posW与矩阵各列的点积
+    // -w <= x <= w, -w <= y <= w, 0 <= z <= w
+    auto column = [&](int c, float out[4]) {
+        for (int r = 0; r < 4; ++r)
+            out[r] = m[r][c];
+    };
+    float cx[4], cy[4], cz[4], cw[4];
+    column(0, cx);
+    column(1, cy);
+    column(2, cz);
+    column(3, cw);
+
+    ParticleFrustum frustum;
+    for (int k = 0; k < 4; ++k)
+    {
+        frustum.planes[Left][k] = cw[k] + cx[k];
+        frustum.planes[Right][k] = cw[k] - cx[k];
+        frustum.planes[Bottom][k] = cw[k] + cy[k];
+        frustum.planes[Top][k] = cw[k] - cy[k];
+        frustum.planes[Near][k] = cz[k];
+        frustum.planes[Far][k] = cw[k] - cz[k];
+    }
+    // 归一化后点到平面的值才是距离，才能与半径比较
+    for (auto& plane : frustum.planes)
+    {
+        const float length = std::sqrt(plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2]);
+        if (length > 0.0f)
+        {
+            for (float& k : plane)
+                k /= length;
+        }
+    }
+    return frustum;
+}
+
+bool ParticleFrustum::Intersects(const ParticleBounds& bounds) const
+{
+    if (bounds.IsEmpty())
+        return false;
+    if (bounds.IsInfinite())
+        return true;
+    for (const auto& plane : planes)
+    {
+        // 沿平面法线方向最远的顶点仍在外侧时整个包围盒在外侧
+        const float x = plane[0] >= 0.0f ? bounds.max.x : bounds.min.x;
+        const float y = plane[1] >= 0.0f ? bounds.max.y : bounds.min.y;
+        const float z = plane[2] >= 0.0f ? bounds.max.z : bounds.min.z;
+        if (plane[0] * x + plane[1] * y + plane[2] * z + plane[3] < 0.0f)
+            return false;
+    }
+    return true;
+}
+
+void ParticleFrustumCuller::Cull(const ParticleSimCPU& sim, const ParticleFrustum& frustum, JobSystem* jobs)
+{
+    sim.Evaluate(m_Eval);
+
+    // Pool模式下的输出按槽位排列，需跳过空闲槽位并换算为导出顺序中的下标
+    m_Pool = sim.GetStorageMode() == ParticleStorageMode::Pool;
+    const uint32_t evaluated = m_Pool ? sim.GetMaxParticles() : sim.GetParticleCount();
+    const uint8_t* types = sim.GetParticles().GetTypes();
+    const uint32_t blockCount = GetBlockCount(evaluated, jobs);
+    if (m_Blocks.size() < blockCount)
+        m_Blocks.resize(blockCount);
+
+    JobSystem::ForEachBlock(jobs, blockCount, evaluated, [&](uint32_t b, uint32_t begin, uint32_t end) {
+        BlockResult& block = m_Blocks[b];
+        block.evalIndices.clear();
+        block.ranks.clear();
+        block.live = 0;
+
+        auto emit = [&](uint32_t first, int width, int mask) {
+            if (!m_Pool)
+            {
+                for (; mask; mask &= mask - 1)
+                {
+                    int lane = 0;
+                    while (!(mask & (1 << lane)))
+                        ++lane;
+                    block.evalIndices.push_back(first + lane);
+                }
+                return;
+            }
+            for (int lane = 0; lane < width; ++lane)
+            {
+                if (types[first + lane] == ParticleSimCPU::PoolFreeSlot)
+                    continue;
+                if (mask & (1 << lane))
+                {
+                    block.evalIndices.push_back(first + lane);
+                    block.ranks.push_back(block.live);
+                }
+                ++block.live;
+            }
+        };
+
+        const FrustumPlanes<SimdFloat> planes(frustum);
+        uint32_t i = begin;
+        for (; i + SimdFloat::Width <= end; i += SimdFloat::Width)
+            emit(i, SimdFloat::Width, TestSpheres(m_Eval, i, planes));
+        const FrustumPlanes<SimdFloat1> scalarPlanes(frustum);
+        for (; i < end; ++i)
+            emit(i, 1, TestSpheres(m_Eval, i, scalarPlanes));
+        if (!m_Pool)
+            block.live = end - begin;
+    });
+
+    // 按块的顺序拼接
+    uint32_t visible = 0;
+    for (uint32_t b = 0; b < blockCount; ++b)
+        visible += static_cast<uint32_t>(m_Blocks[b].evalIndices.size());
+    if (m_Visible.size() < visible)
+        m_Visible.resize(visible);
+    if (m_Pool && m_EvalIndices.size() < visible)
+        m_EvalIndices.resize(visible);
+
+    uint32_t offset = 0;
+    uint32_t liveBase = 0;
+    for (uint32_t b = 0; b < blockCount; ++b)
+    {
+        const BlockResult& block = m_Blocks[b];
+        const uint32_t count = static_cast<uint32_t>(block.evalIndices.size());
+        if (m_Pool)
+        {
+            for (uint32_t k = 0; k < count; ++k)
+            {
+                m_EvalIndices[offset + k] = block.evalIndices[k];
+                m_Visible[offset + k] = liveBase + block.ranks[k];
+            }
+        }
+        else if (count > 0)
+        {
+            std::memcpy(m_Visible.data() + offset, block.evalIndices.data(), sizeof(uint32_t) * count);
+        }
+        offset += count;
+        liveBase += block.live;
+    }
+    m_VisibleCount = visible;
+    m_TestedCount = liveBase;
+}
@@ -0,0 +1,82 @@
+//***************************************************************************************
+// ParticleCull.h
+//
+// 粒子包围球的SIMD视锥体剔除，输出可见粒子的紧凑下标列表供排序与上传使用
+// SIMD frustum culling of particle bounding spheres, producing a compact visible-index
+// list for sorting and upload.
+//***************************************************************************************
+
+#pragma once
+
+#ifndef PARTICLE_CULL_H
+#define PARTICLE_CULL_H
+
+#include <cstdint>
+#include <vector>
+#include "ParticleSimTypes.h"
+#include "ParticleStorage.h"
+#include "ParticleKernels.h"
+#include "ParticleBounds.h"
+
+class JobSystem;
+class ParticleSimCPU;
+
+// 六个平面(a, b, c, d)，a * x + b * y + c * z + d >= 0为视锥体内侧，(a, b, c)为单位向量
+// 默认的全零平面不剔除任何粒子
+struct ParticleFrustum
+{
+    enum { Left, Right, Bottom, Top, Near, Far, PlaneCount };
+    float planes[PlaneCount][4] = {};
+
+    // 由行向量约定的视图投影矩阵(裁剪空间0 <= z <= w)提取各平面，m[row][col]
+    static ParticleFrustum FromViewProj(const float m[4][4]);
+    // 包围盒与视锥体相交或无法判定时返回true，空的包围盒返回false
+    bool Intersects(const ParticleBounds& bounds) const;
+};
+
+class ParticleFrustumCuller
+{
+public:
+    // 每个任务至少处理的粒子数，较少时不再拆分
+    static constexpr uint32_t MinBlockSize = 16384;
+
+    ParticleFrustumCuller() = default;
+    ~ParticleFrustumCuller() = default;
+    // 不允许拷贝，允许移动
+    ParticleFrustumCuller(const ParticleFrustumCuller&) = delete;
+    ParticleFrustumCuller& operator=(const ParticleFrustumCuller&) = delete;
+    ParticleFrustumCuller(ParticleFrustumCuller&&) = default;
+    ParticleFrustumCuller& operator=(ParticleFrustumCuller&&) = default;
+
+    // 由闭式轨迹求出sim中全部粒子的位置与半尺寸，以位置为球心、sqrt(2) * max(|半宽|, |半高|)为半径
+    // 与frustum逐平面比较，按当前编译目标下最宽的SIMD一次测试多个粒子
+    void Cull(const ParticleSimCPU& sim, const ParticleFrustum& frustum, JobSystem* jobs = nullptr);
+
+    // 可见粒子在ExportVertices导出顺序中的下标，升序排列，可直接作为索引缓冲区
+    const uint32_t* GetVisible() const { return m_Visible.data(); }
+    uint32_t GetVisibleCount() const { return m_VisibleCount; }
+    // 参与测试的粒子数(不含发射器与空闲槽位)
+    uint32_t GetTestedCount() const { return m_TestedCount; }
+
+    // 本次Cull的求值结果，以及可见粒子在其中的位置(与GetVisible一一对应)，供排序复用
+    const ParticleEvalBuffer& GetEval() const { return m_Eval; }
+    const uint32_t* GetEvalIndices() const { return m_Pool ? m_EvalIndices.data() : m_Visible.data(); }
+
+private:
+    uint32_t m_VisibleCount = 0;
+    uint32_t m_TestedCount = 0;
+    bool m_Pool = false;
+    ParticleEvalBuffer m_Eval;
+    AlignedVector<uint32_t> m_Visible;
+    AlignedVector<uint32_t> m_EvalIndices;
+    // 各块先写入自己的列表，再按块的顺序拼接，结果与线程数无关
+    struct BlockResult
+    {
+        std::vector<uint32_t> evalIndices;
+        std::vector<uint32_t> ranks;        // Pool模式下在块内存活粒子中的序号
+        uint32_t live = 0;
+    };
+    std::vector<BlockResult> m_Blocks;
+};
+
+#endif
@@ -0,0 +1,190 @@
+#include "ParticleEmitterGrid.h"
+#include "ParticleSimCPU.h"
+#include "ParticleCull.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+    // 坐标所在的格子，限制在[0, dim)内
+    uint32_t CellCoord(float x, float origin, float cellSize, uint32_t dim)
+    {
+        const float c = std::floor((x - origin) / cellSize);
+        if (!(c > 0.0f))
+            return 0;
+        return c < static_cast<float>(dim - 1) ? static_cast<uint32_t>(c) : dim - 1;
+    }
+
+    float DistanceSq(const Float3& a, const Float3& b)
+    {
+        const Float3 d = a - b;
+        return Dot(d, d);
+    }
+}
+
+void ParticleEmitterGrid::Build(ParticleSimCPU& sim, float cellSize)
+{
+    ParticleEmitterTable& table = sim.GetEmitters();
+    const uint32_t count = table.GetCount();
+    const float* posX = table.GetPosX();
+    const float* posY = table.GetPosY();
+    const float* posZ = table.GetPosZ();
+
+    // 包括停用的发射器
+    Float3 lo = { FLT_MAX, FLT_MAX, FLT_MAX };
+    Float3 hi = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+    bool rotated = false;
+    for (uint32_t e = 0; e < count; ++e)
+    {
+        lo = { std::min(lo.x, posX[e]), std::min(lo.y, posY[e]), std::min(lo.z, posZ[e]) };
+        hi = { std::max(hi.x, posX[e]), std::max(hi.y, posY[e]), std::max(hi.z, posZ[e]) };
+        rotated = rotated || table.GetDirY()[e] != 1.0f;
+    }
+
+    m_Extent = sim.GetEmitterExtent();
+    if (rotated)
+        m_Extent = AnyRotationBounds(m_Extent);
+    if (m_Extent.IsEmpty())
+        m_Extent = ParticleBounds::Point({});
+
+    // 格子过多时逐步放大，使格子数与发射器数同阶
+    m_CellSize = cellSize > 0.0f ? cellSize : 1.0f;
+    m_Origin = count > 0 ? lo : Float3{};
+    const Float3 span = count > 0 ? hi - lo : Float3{};
+    const uint64_t maxCells = static_cast<uint64_t>(std::max(count, 1u)) * MaxCellsPerEmitter;
+    for (;;)
+    {
+        uint64_t cells = 1;
+        const float spans[3] = { span.x, span.y, span.z };
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            const float dim = std::floor(spans[axis] / m_CellSize) + 1.0f;
+            m_Dims[axis] = dim < static_cast<float>(UINT32_MAX) ? static_cast<uint32_t>(dim) : UINT32_MAX;
+            cells *= m_Dims[axis];
+        }
+        if (cells <= maxCells)
+            break;
+        m_CellSize *= 2.0f;
+    }
+
+    // 计数排序
+    const uint32_t cellCount = GetCellCount();
+    m_CellStart.assign(cellCount + 1, 0);
+    std::vector<uint32_t> cellOf(count);
+    for (uint32_t e = 0; e < count; ++e)
+    {
+        const uint32_t x = CellCoord(posX[e], m_Origin.x, m_CellSize, m_Dims[0]);
+        const uint32_t y = CellCoord(posY[e], m_Origin.y, m_CellSize, m_Dims[1]);
+        const uint32_t z = CellCoord(posZ[e], m_Origin.z, m_CellSize, m_Dims[2]);
+        cellOf[e] = (z * m_Dims[1] + y) * m_Dims[0] + x;
+        ++m_CellStart[cellOf[e] + 1];
+    }
+    for (uint32_t c = 0; c < cellCount; ++c)
+        m_CellStart[c + 1] += m_CellStart[c];
+    m_CellEmitters.resize(count);
+    std::vector<uint32_t> cursor(m_CellStart.begin(), m_CellStart.end() - 1);
+    for (uint32_t e = 0; e < count; ++e)
+        m_CellEmitters[cursor[cellOf[e]]++] = e;
+
+    // 发射器数不变时保留启用状态，只是重新划分格子
+    if (m_Active.size() != count)
+    {
+        m_Active.assign(count, 0);
+        m_InactiveSince.assign(count, -std::numeric_limits<double>::infinity());
+        m_ActiveList.clear();
+        for (uint32_t e = 0; e < count; ++e)
+            table.SetEnabled(e, false);
+    }
+}
+
+void ParticleEmitterGrid::Update(ParticleSimCPU& sim, const ParticleActivationView& view, float dt)
+{
+    ParticleEmitterTable& table = sim.GetEmitters();
+    if (table.GetCount() != m_Active.size())
+        Build(sim, m_CellSize);
+    const float* posX = table.GetPosX();
+    const float* posY = table.GetPosY();
+    const float* posZ = table.GetPosZ();
+    m_Stats = {};
+
+    const float deactivateSq = view.deactivateDistance * view.deactivateDistance;
+    const float activateSq = view.activateDistance * view.activateDistance;
+    auto inView = [&](const ParticleBounds& reach) { return !view.frustum || view.frustum->Intersects(reach); };
+
+    // 已启用的发射器
+    for (size_t i = 0; i < m_ActiveList.size();)
+    {
+        const uint32_t e = m_ActiveList[i];
+        const Float3 pos = { posX[e], posY[e], posZ[e] };
+        ++m_Stats.emittersTested;
+        if (DistanceSq(pos, view.eye) <= deactivateSq && inView(GetReach(pos)))
+        {
+            ++i;
+            continue;
+        }
+        // 本帧起不再发射，之后补发的时间从这一刻算起
+        table.SetEnabled(e, false);
+        m_Active[e] = 0;
+        m_InactiveSince[e] = m_Clock;
+        m_ActiveList[i] = m_ActiveList.back();
+        m_ActiveList.pop_back();
+        ++m_Stats.deactivated;
+    }
+
+    // 激活距离内的格子，激活范围与网格不相交时跳过
+    const float r = view.activateDistance;
+    const Float3 gridMax = m_Origin + m_CellSize * Float3{ static_cast<float>(m_Dims[0]), static_cast<float>(m_Dims[1]), static_cast<float>(m_Dims[2]) };
+    const bool overlaps = !m_CellEmitters.empty() && r > 0.0f &&
+        view.eye.x + r >= m_Origin.x && view.eye.y + r >= m_Origin.y && view.eye.z + r >= m_Origin.z &&
+        view.eye.x - r <= gridMax.x && view.eye.y - r <= gridMax.y && view.eye.z - r <= gridMax.z;
+    if (overlaps)
+    {
+        const uint32_t x0 = CellCoord(view.eye.x - r, m_Origin.x, m_CellSize, m_Dims[0]);
+        const uint32_t x1 = CellCoord(view.eye.x + r, m_Origin.x, m_CellSize, m_Dims[0]);
+        const uint32_t y0 = CellCoord(view.eye.y - r, m_Origin.y, m_CellSize, m_Dims[1]);
+        const uint32_t y1 = CellCoord(view.eye.y + r, m_Origin.y, m_CellSize, m_Dims[1]);
+        const uint32_t z0 = CellCoord(view.eye.z - r, m_Origin.z, m_CellSize, m_Dims[2]);
+        const uint32_t z1 = CellCoord(view.eye.z + r, m_Origin.z, m_CellSize, m_Dims[2]);
+        for (uint32_t z = z0; z <= z1; ++z)
+        {
+            for (uint32_t y = y0; y <= y1; ++y)
+            {
+                for (uint32_t x = x0; x <= x1; ++x)
+                {
+                    const uint32_t c = (z * m_Dims[1] + y) * m_Dims[0] + x;
+                    if (m_CellStart[c] == m_CellStart[c + 1])
+                        continue;
+                    ++m_Stats.cellsVisited;
+                    // 格子内全部发射器的范围
+                    const Float3 cellMin = m_Origin + m_CellSize * Float3{ static_cast<float>(x), static_cast<float>(y), static_cast<float>(z) };
+                    const ParticleBounds cellReach = { cellMin + m_Extent.min, cellMin + Float3{ m_CellSize, m_CellSize, m_CellSize } + m_Extent.max };
+                    if (!inView(cellReach))
+                        continue;
+                    for (uint32_t k = m_CellStart[c]; k < m_CellStart[c + 1]; ++k)
+                    {
+                        const uint32_t e = m_CellEmitters[k];
+                        if (m_Active[e])
+                            continue;
+                        const Float3 pos = { posX[e], posY[e], posZ[e] };
+                        ++m_Stats.emittersTested;
+                        if (DistanceSq(pos, view.eye) > activateSq || !inView(GetReach(pos)))
+                            continue;
+                        // 补发的时间由模拟按寿命截断
+                        const double gap = std::min(m_Clock - m_InactiveSince[e], static_cast<double>(FLT_MAX));
+                        table.SetEnabled(e, true);
+                        if (gap > 0.0)
+                            table.FastForward(e, static_cast<float>(gap));
+                        m_Active[e] = 1;
+                        m_ActiveList.push_back(e);
+                        ++m_Stats.activated;
+                    }
+                }
+            }
+        }
+    }
+
+    m_Stats.active = static_cast<uint32_t>(m_ActiveList.size());
+    m_Clock += dt;
+}
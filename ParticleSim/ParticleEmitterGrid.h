@@ -0,0 +1,92 @@
+//***************************************************************************************
+// ParticleEmitterGrid.h
+//
+// 发射器表的均匀网格索引，按相机距离与视锥体只启用附近的发射器，重新启用时补发停用期间的粒子
+// Uniform-grid index over an emitter table that enables only emitters near the camera
+// and inside the frustum, back-filling the particles they missed when re-enabled.
+//***************************************************************************************
+
+#pragma once
+
+#ifndef PARTICLE_EMITTER_GRID_H
+#define PARTICLE_EMITTER_GRID_H
+
+#include <cstdint>
+#include <vector>
+#include "ParticleSimTypes.h"
+#include "ParticleBounds.h"
+
+class ParticleSimCPU;
+struct ParticleFrustum;
+
+// 启用与停用的条件，deactivateDistance大于activateDistance，避免在边界处反复切换
+struct ParticleActivationView
+{
+    Float3 eye = {};
+    float activateDistance = 100.0f;
+    float deactivateDistance = 120.0f;
+    // 为空时只按距离判断，发射器的粒子可能到达的范围与视锥体不相交时停用
+    const ParticleFrustum* frustum = nullptr;
+};
+
+// 最近一次Update的统计
+struct ParticleActivationStats
+{
+    uint32_t cellsVisited = 0;      // 激活距离内非空的格子数
+    uint32_t emittersTested = 0;    // 逐个测试的发射器数(含已启用的)
+    uint32_t activated = 0;
+    uint32_t deactivated = 0;
+    uint32_t active = 0;
+};
+
+class ParticleEmitterGrid
+{
+public:
+    // 网格的格子数不超过发射器数的该倍数，发射器分布稀疏时相应地增大格子
+    static constexpr uint32_t MaxCellsPerEmitter = 4;
+
+    ParticleEmitterGrid() = default;
+    ~ParticleEmitterGrid() = default;
+    // 不允许拷贝，允许移动
+    ParticleEmitterGrid(const ParticleEmitterGrid&) = delete;
+    ParticleEmitterGrid& operator=(const ParticleEmitterGrid&) = delete;
+    ParticleEmitterGrid(ParticleEmitterGrid&&) = default;
+    ParticleEmitterGrid& operator=(ParticleEmitterGrid&&) = default;
+
+    // 将sim发射器表中的全部发射器按位置划分到边长为cellSize的格子中
+    // 发射器数改变时全部停用并视为从未启用过，由之后的Update按条件启用；移动发射器后需重新调用
+    void Build(ParticleSimCPU& sim, float cellSize);
+    // 在sim.Update之前调用，dt与之后的sim.Update相同
+    // 先检查已启用的发射器是否需要停用，再只遍历激活距离内的格子，代价与附近的发射器数成正比而与总数无关
+    // 重新启用的发射器补发停用期间本应发射的粒子，它们沿闭式轨迹出现在此时应在的位置
+    // 发射器数与Build时不同时按原来的格子大小重新Build
+    void Update(ParticleSimCPU& sim, const ParticleActivationView& view, float dt);
+
+    // 当前启用的发射器，顺序不固定
+    const std::vector<uint32_t>& GetActive() const { return m_ActiveList; }
+    bool IsActive(uint32_t emitter) const { return m_Active[emitter] != 0; }
+    const ParticleActivationStats& GetStats() const { return m_Stats; }
+    float GetCellSize() const { return m_CellSize; }
+    uint32_t GetCellCount() const { return m_Dims[0] * m_Dims[1] * m_Dims[2]; }
+
+private:
+    // 发射器的粒子可能到达的范围
+    ParticleBounds GetReach(const Float3& pos) const { return { pos + m_Extent.min, pos + m_Extent.max }; }
+
+    float m_CellSize = 1.0f;
+    Float3 m_Origin = {};
+    uint32_t m_Dims[3] = {};
+    // 按格子排列的发射器序号，第c个格子为[m_CellStart[c], m_CellStart[c + 1])
+    std::vector<uint32_t> m_CellStart;
+    std::vector<uint32_t> m_CellEmitters;
+    // 单个发射器相对其位置的范围，有发射器方向不为+y时取任意旋转后的范围
+    ParticleBounds m_Extent;
+
+    double m_Clock = 0.0;
+    std::vector<uint8_t> m_Active;
+    std::vector<double> m_InactiveSince;    // 停用时的时刻，从未启用过的为负无穷
+    std::vector<uint32_t> m_ActiveList;
+    ParticleActivationStats m_Stats;
+};
+
+#endif
@@ -0,0 +1,161 @@
+#include "ParticleEmitterTable.h"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    Float3 NormalizeDirection(const Float3& dir)
+    {
+        Float3 n = Normalize(dir);
+        return Dot(n, n) > 0.0f ? n : Float3{ 0.0f, 1.0f, 0.0f };
+    }
+}
+
+ParticleEmitterBasis ParticleEmitterBasis::FromDirection(const Float3& dir)
+{
+    // Rodrigues公式：k = y × dir，R = I + [k]× + [k]×^2 / (1 + c)，c = y · dir
+    ParticleEmitterBasis basis;
+    const float c = dir.y;
+    if (c >= 1.0f)
+        return basis;
+    if (c <= -1.0f + 1.0e-6f)
+    {
+        // 绕x轴旋转半周
+        basis.y = { 0.0f, -1.0f, 0.0f };
+        basis.z = { 0.0f, 0.0f, -1.0f };
+        return basis;
+    }
+    const float kx = dir.z, kz = -dir.x;
+    const float s = 1.0f / (1.0f + c);
+    // 各列为R作用于x/y/z轴的结果
+    basis.x = { 1.0f - kz * kz * s, kz, kx * kz * s };
+    basis.y = { dir.x, dir.y, dir.z };
+    basis.z = { kx * kz * s, -kx, 1.0f - kx * kx * s };
+    return basis;
+}
+
+uint32_t ParticleEmitterTable::Add(const ParticleEmitterDesc& desc)
+{
+    const Float3 dir = NormalizeDirection(desc.dir);
+    m_PosX.push_back(desc.pos.x);
+    m_PosY.push_back(desc.pos.y);
+    m_PosZ.push_back(desc.pos.z);
+    m_DirX.push_back(dir.x);
+    m_DirY.push_back(dir.y);
+    m_DirZ.push_back(dir.z);
+    m_Intervals.push_back(desc.interval);
+    m_Enabled.push_back(desc.enabled ? 1 : 0);
+    m_Ages.push_back(0.0f);
+    m_EmitCounts.push_back(0);
+    m_CatchUp.push_back(0.0f);
+    m_EnabledSlots.push_back(UINT32_MAX);
+    if (desc.enabled)
+    {
+        m_EnabledSlots.back() = static_cast<uint32_t>(m_EnabledList.size());
+        m_EnabledList.push_back(GetCount() - 1);
+    }
+    ++m_Version;
+    return GetCount() - 1;
+}
+
+void ParticleEmitterTable::Clear()
+{
+    for (auto* channel : { &m_PosX, &m_PosY, &m_PosZ, &m_DirX, &m_DirY, &m_DirZ, &m_Intervals, &m_Ages, &m_CatchUp })
+        channel->clear();
+    m_Enabled.clear();
+    m_EmitCounts.clear();
+    m_EnabledList.clear();
+    m_EnabledSlots.clear();
+    ++m_Version;
+}
+
+void ParticleEmitterTable::SetPosition(uint32_t index, const Float3& pos)
+{
+    m_PosX[index] = pos.x;
+    m_PosY[index] = pos.y;
+    m_PosZ[index] = pos.z;
+    ++m_Version;
+}
+
+void ParticleEmitterTable::SetDirection(uint32_t index, const Float3& dir)
+{
+    const Float3 n = NormalizeDirection(dir);
+    m_DirX[index] = n.x;
+    m_DirY[index] = n.y;
+    m_DirZ[index] = n.z;
+    ++m_Version;
+}
+
+void ParticleEmitterTable::SetInterval(uint32_t index, float interval)
+{
+    m_Intervals[index] = interval;
+}
+
+void ParticleEmitterTable::SetEnabled(uint32_t index, bool enabled)
+{
+    if ((m_Enabled[index] != 0) == enabled)
+        return;
+    m_Enabled[index] = enabled ? 1 : 0;
+    if (enabled)
+    {
+        m_EnabledSlots[index] = static_cast<uint32_t>(m_EnabledList.size());
+        m_EnabledList.push_back(index);
+    }
+    else
+    {
+        // 以最后一个填补空位
+        const uint32_t slot = m_EnabledSlots[index];
+        m_EnabledList[slot] = m_EnabledList.back();
+        m_EnabledSlots[m_EnabledList[slot]] = slot;
+        m_EnabledList.pop_back();
+        m_EnabledSlots[index] = UINT32_MAX;
+    }
+    ++m_Version;
+}
+
+ParticleEmitterDesc ParticleEmitterTable::Get(uint32_t index) const
+{
+    ParticleEmitterDesc desc;
+    desc.pos = { m_PosX[index], m_PosY[index], m_PosZ[index] };
+    desc.dir = { m_DirX[index], m_DirY[index], m_DirZ[index] };
+    desc.interval = m_Intervals[index];
+    desc.enabled = m_Enabled[index] != 0;
+    return desc;
+}
+
+void ParticleEmitterTable::ResetState()
+{
+    std::fill(m_Ages.begin(), m_Ages.end(), 0.0f);
+    std::fill(m_EmitCounts.begin(), m_EmitCounts.end(), 0u);
+    std::fill(m_CatchUp.begin(), m_CatchUp.end(), 0.0f);
+}
+
+const ParticleBounds& ParticleEmitterTable::GetPositionBounds() const
+{
+    if (m_BoundsVersion != m_Version)
+        UpdateBounds();
+    return m_PositionBounds;
+}
+
+bool ParticleEmitterTable::HasRotation() const
+{
+    if (m_BoundsVersion != m_Version)
+        UpdateBounds();
+    return m_HasRotation;
+}
+
+void ParticleEmitterTable::UpdateBounds() const
+{
+    Float3 lo = { FLT_MAX, FLT_MAX, FLT_MAX };
+    Float3 hi = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+    bool rotated = false;
+    for (uint32_t i : m_EnabledList)
+    {
+        lo = { std::min(lo.x, m_PosX[i]), std::min(lo.y, m_PosY[i]), std::min(lo.z, m_PosZ[i]) };
+        hi = { std::max(hi.x, m_PosX[i]), std::max(hi.y, m_PosY[i]), std::max(hi.z, m_PosZ[i]) };
+        rotated = rotated || m_DirY[i] != 1.0f;
+    }
+    m_PositionBounds = ParticleBounds::Range(lo, hi);
+    m_HasRotation = rotated;
+    m_BoundsVersion = m_Version;
+}
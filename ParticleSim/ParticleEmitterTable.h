@@ -0,0 +1,115 @@
+//***************************************************************************************
+// ParticleEmitterTable.h
+//
+// 按SoA存放的发射器表，一个系统中的大量发射器共用参数与粒子存储，每帧成批发射
+// SoA emitter table letting one system host many emitters that share parameters and
+// particle storage and emit in a single batch per frame.
+//***************************************************************************************
+
+#pragma once
+
+#ifndef PARTICLE_EMITTER_TABLE_H
+#define PARTICLE_EMITTER_TABLE_H
+
+#include <cstdint>
+#include <vector>
+#include "ParticleSimTypes.h"
+#include "ParticleStorage.h"
+#include "ParticleBounds.h"
+
+// dir为发射方向，特效原本沿+y的速度(Smoke为加速度)整体旋转到该方向，零向量视为+y
+// interval不大于0时使用系统的发射间隔
+struct ParticleEmitterDesc
+{
+    Float3 pos = {};
+    Float3 dir = { 0.0f, 1.0f, 0.0f };
+    float interval = 0.0f;
+    bool enabled = true;
+};
+
+// 将+y旋转到单位向量dir的最小旋转，dir为+y时为单位矩阵
+struct ParticleEmitterBasis
+{
+    Float3 x = { 1.0f, 0.0f, 0.0f };
+    Float3 y = { 0.0f, 1.0f, 0.0f };
+    Float3 z = { 0.0f, 0.0f, 1.0f };
+
+    static ParticleEmitterBasis FromDirection(const Float3& dir);
+    Float3 Apply(const Float3& v) const { return v.x * x + v.y * y + v.z * z; }
+};
+
+class ParticleEmitterTable
+{
+public:
+    ParticleEmitterTable() = default;
+    ~ParticleEmitterTable() = default;
+    // 不允许拷贝，允许移动
+    ParticleEmitterTable(const ParticleEmitterTable&) = delete;
+    ParticleEmitterTable& operator=(const ParticleEmitterTable&) = delete;
+    ParticleEmitterTable(ParticleEmitterTable&&) = default;
+    ParticleEmitterTable& operator=(ParticleEmitterTable&&) = default;
+
+    // 返回发射器的序号，序号在Clear之前保持不变
+    uint32_t Add(const ParticleEmitterDesc& desc);
+    void Clear();
+    uint32_t GetCount() const { return static_cast<uint32_t>(m_Enabled.size()); }
+
+    void SetPosition(uint32_t index, const Float3& pos);
+    void SetDirection(uint32_t index, const Float3& dir);
+    void SetInterval(uint32_t index, float interval);
+    // 停用的发射器保留状态，其粒子照常更新
+    void SetEnabled(uint32_t index, bool enabled);
+    ParticleEmitterDesc Get(uint32_t index) const;
+
+    // 下一帧补发此前seconds内本应发射的粒子，各粒子以其应有的存活时间出现，超过寿命的部分不补发
+    // 用于停用一段时间的发射器重新启用，Boom的壳不补发
+    void FastForward(uint32_t index, float seconds) { m_CatchUp[index] += seconds; }
+
+    // 各发射器回到刚添加时的状态
+    void ResetState();
+
+    const float* GetPosX() const { return m_PosX.data(); }
+    const float* GetPosY() const { return m_PosY.data(); }
+    const float* GetPosZ() const { return m_PosZ.data(); }
+    const float* GetDirX() const { return m_DirX.data(); }
+    const float* GetDirY() const { return m_DirY.data(); }
+    const float* GetDirZ() const { return m_DirZ.data(); }
+    const float* GetIntervals() const { return m_Intervals.data(); }
+    const uint8_t* GetEnabled() const { return m_Enabled.data(); }
+    // 启用的发射器序号，顺序随启用与停用的先后而变，遍历的代价只与启用的数目有关
+    const std::vector<uint32_t>& GetEnabledList() const { return m_EnabledList; }
+    // 状态：距上次发射的累计时间、已发射的壳数、待补发的时间
+    float* GetAges() { return m_Ages.data(); }
+    uint32_t* GetEmitCounts() { return m_EmitCounts.data(); }
+    float* GetCatchUp() { return m_CatchUp.data(); }
+    const float* GetAges() const { return m_Ages.data(); }
+    const uint32_t* GetEmitCounts() const { return m_EmitCounts.data(); }
+    const float* GetCatchUp() const { return m_CatchUp.data(); }
+
+    // 每次修改位置、方向或改变启用状态后递增，供使用者判断包围盒是否需要更新
+    uint32_t GetVersion() const { return m_Version; }
+    // 启用的发射器位置的包围盒，版本改变后首次调用时重新计算
+    const ParticleBounds& GetPositionBounds() const;
+    // 启用的发射器中是否有方向不为+y的
+    bool HasRotation() const;
+
+private:
+    void UpdateBounds() const;
+
+    AlignedVector<float> m_PosX, m_PosY, m_PosZ;
+    AlignedVector<float> m_DirX, m_DirY, m_DirZ;
+    AlignedVector<float> m_Intervals;
+    AlignedVector<uint8_t> m_Enabled;
+    AlignedVector<float> m_Ages;
+    AlignedVector<uint32_t> m_EmitCounts;
+    AlignedVector<float> m_CatchUp;
+    std::vector<uint32_t> m_EnabledList;
+    std::vector<uint32_t> m_EnabledSlots;   // 在m_EnabledList中的位置，停用的为UINT32_MAX
+
+    uint32_t m_Version = 0;
+    mutable uint32_t m_BoundsVersion = UINT32_MAX;
+    mutable ParticleBounds m_PositionBounds;
+    mutable bool m_HasRotation = false;
+};
+
+#endif
@@ -0,0 +1,197 @@
+#include "ParticleKernels.h"
+#include "ParticleSimd.h"
+#include <algorithm>
+
+void ParticleEvalBuffer::Reserve(uint32_t capacity)
+{
+    // 与ParticleStorage一样补齐到缓存行
+    constexpr uint32_t floatsPerLine = ParticleCacheLineSize / sizeof(float);
+    uint32_t padded = (capacity + floatsPerLine - 1) / floatsPerLine * floatsPerLine;
+    m_Capacity = capacity;
+    for (AlignedVector<float>& data : m_Data)
+        data.assign(padded, 0.0f);
+}
+
+ParticleEvalOutput ParticleEvalBuffer::GetOutput()
+{
+    return { m_Data[0].data(), m_Data[1].data(), m_Data[2].data(),
+        m_Data[3].data(), m_Data[4].data(), m_Data[5].data() };
+}
+
+namespace
+{
+    struct KernelInput
+    {
+        const float* posX; const float* posY; const float* posZ;
+        const float* velX; const float* velY; const float* velZ;
+        const float* accelX; const float* accelY; const float* accelZ;
+        const float* sizeX; const float* sizeY;
+        const float* age;
+        const uint8_t* type;
+        ParticleAgeMapping ageMapping;
+    };
+
+    template<class V>
+    struct KernelResult
+    {
+        V posX, posY, posZ, opacity, halfWidth, halfHeight;
+    };
+
+    template<class V>
+    KernelResult<V> EvaluateBlock(const KernelInput& in, uint32_t i, const ParticleAppearance& a)
+    {
+        V age = V::Set1(in.ageMapping.offset) + V::Set1(in.ageMapping.sign) * V::Load(in.age + i);
+        V t = Min(age, V::Set1(a.maxTime));
+
+        V ax = V::Set1(a.accelScale.x);
+        V ay = V::Set1(a.accelScale.y);
+        V az = V::Set1(a.accelScale.z);
+        if (a.perParticleAccel)
+        {
+            ax = ax * V::Load(in.accelX + i);
+            ay = ay * V::Load(in.accelY + i);
+            az = az * V::Load(in.accelZ + i);
+        }
+
+        // 恒定加速度等式
+        V halfT2 = V::Set1(0.5f) * t * t;
+        KernelResult<V> r;
+        r.posX = halfT2 * ax + t * V::Load(in.velX + i) + V::Load(in.posX + i);
+        r.posY = halfT2 * ay + t * V::Load(in.velY + i) + V::Load(in.posY + i);
+        r.posZ = halfT2 * az + t * V::Load(in.velZ + i) + V::Load(in.posZ + i);
+
+        // 颜色随着时间褪去，opacityRange为0时不随时间变化
+        V invRange = V::Set1(a.opacityRange > 0.0f ? 1.0f / a.opacityRange : 0.0f);
+        r.opacity = Max(V::Set1(a.opacityBase) - SmoothStep01(t, invRange), V::Set1(a.opacityMin));
+
+        V sizeTerm = V::Set1(a.sizeAgeSlope) * age + V::Set1(a.sizeBias);
+        r.halfWidth = V::Set1(a.sizeScale) * V::Load(in.sizeX + i) + sizeTerm;
+        r.halfHeight = V::Set1(a.sizeScale) * V::Load(in.sizeY + i) + sizeTerm;
+        return r;
+    }
+
+    template<class V>
+    void StoreBlock(const KernelResult<V>& r, const ParticleEvalOutput& out, uint32_t o)
+    {
+        r.posX.Store(out.posX + o);
+        r.posY.Store(out.posY + o);
+        r.posZ.Store(out.posZ + o);
+        r.opacity.Store(out.opacity + o);
+        r.halfWidth.Store(out.halfWidth + o);
+        r.halfHeight.Store(out.halfHeight + o);
+    }
+
+    template<class V>
+    V TypeMask(const uint8_t* types, uint32_t type)
+    {
+        uint32_t bits[V::Width];
+        for (int l = 0; l < V::Width; ++l)
+            bits[l] = types[l] == type ? 0xFFFFFFFFu : 0u;
+        float mask[V::Width];
+        std::memcpy(mask, bits, sizeof(mask));
+        return V::Load(mask);
+    }
+
+    template<class V>
+    void EvaluateRange(const KernelInput& in, uint32_t first, uint32_t count,
+        const ParticleAppearanceTable& table, const ParticleEvalOutput& out)
+    {
+        uint32_t o = 0;
+        for (; o + V::Width <= count; o += V::Width)
+        {
+            uint32_t i = first + o;
+
+            // 块内通常只有一种粒子类型，否则逐类型计算后按掩码合并
+            uint32_t present = 0;
+            for (int l = 0; l < V::Width; ++l)
+                present |= 1u << (in.type[i + l] & 3);
+
+            uint32_t type = 0;
+            while (!(present & (1u << type)))
+                ++type;
+            KernelResult<V> r = EvaluateBlock<V>(in, i, table.types[type]);
+            present &= ~(1u << type);
+
+            while (present)
+            {
+                ++type;
+                if (!(present & (1u << type)))
+                    continue;
+                present &= ~(1u << type);
+
+                KernelResult<V> other = EvaluateBlock<V>(in, i, table.types[type]);
+                V mask = TypeMask<V>(in.type + i, type);
+                r.posX = Select(mask, other.posX, r.posX);
+                r.posY = Select(mask, other.posY, r.posY);
+                r.posZ = Select(mask, other.posZ, r.posZ);
+                r.opacity = Select(mask, other.opacity, r.opacity);
+                r.halfWidth = Select(mask, other.halfWidth, r.halfWidth);
+                r.halfHeight = Select(mask, other.halfHeight, r.halfHeight);
+            }
+            StoreBlock(r, out, o);
+        }
+
+        // 剩余不足一个块的粒子
+        for (; o < count; ++o)
+        {
+            uint32_t i = first + o;
+            StoreBlock(EvaluateBlock<SimdFloat1>(in, i, table.types[in.type[i] & 3]), out, o);
+        }
+    }
+
+    KernelInput MakeInput(const ParticleStorage& storage, const ParticleAgeMapping& ages)
+    {
+        KernelInput in;
+        in.ageMapping = ages;
+        in.posX = storage.GetChannel(ParticleChannel::PosX);
+        in.posY = storage.GetChannel(ParticleChannel::PosY);
+        in.posZ = storage.GetChannel(ParticleChannel::PosZ);
+        in.velX = storage.GetChannel(ParticleChannel::VelX);
+        in.velY = storage.GetChannel(ParticleChannel::VelY);
+        in.velZ = storage.GetChannel(ParticleChannel::VelZ);
+        in.accelX = storage.GetChannel(ParticleChannel::AccelX);
+        in.accelY = storage.GetChannel(ParticleChannel::AccelY);
+        in.accelZ = storage.GetChannel(ParticleChannel::AccelZ);
+        in.sizeX = storage.GetChannel(ParticleChannel::SizeX);
+        in.sizeY = storage.GetChannel(ParticleChannel::SizeY);
+        in.age = storage.GetAges();
+        in.type = storage.GetTypes();
+        return in;
+    }
+}
+
+void EvaluateParticles(const ParticleStorage& storage, uint32_t first, uint32_t count,
+    const ParticleAppearanceTable& appearance, const ParticleEvalOutput& output,
+    const ParticleAgeMapping& ages)
+{
+    EvaluateRange<SimdFloat>(MakeInput(storage, ages), first, count, appearance, output);
+}
+
+void EvaluateParticlesScalar(const ParticleStorage& storage, uint32_t first, uint32_t count,
+    const ParticleAppearanceTable& appearance, const ParticleEvalOutput& output,
+    const ParticleAgeMapping& ages)
+{
+    EvaluateRange<SimdFloat1>(MakeInput(storage, ages), first, count, appearance, output);
+}
+
+Float3 EvaluateParticlePosition(const ParticleVertex& v, float t, const ParticleAppearance& appearance)
+{
+    t = std::min(t, appearance.maxTime);
+    Float3 accel = appearance.perParticleAccel ? appearance.accelScale * v.accel : appearance.accelScale;
+    return 0.5f * t * t * accel + t * v.initialVel + v.initialPos;
+}
+
+void AdvanceAges(float* ages, uint32_t count, float dt)
+{
+    SimdFloat step = SimdFloat::Set1(dt);
+    uint32_t i = 0;
+    for (; i + SimdFloat::Width <= count; i += SimdFloat::Width)
+        (SimdFloat::Load(ages + i) + step).Store(ages + i);
+    for (; i < count; ++i)
+        ages[i] += dt;
+}
+
+int GetParticleSimdWidth()
+{
+    return SimdFloat::Width;
+}
@@ -0,0 +1,102 @@
+//***************************************************************************************
+// ParticleKernels.h
+//
+// 按块计算粒子的闭式轨迹、透明度与公告板尺寸(对应各特效的VS/GS)
+// Block kernels evaluating the closed-form trajectory, opacity and billboard size of
+// particles (the VS/GS math of each effect).
+//***************************************************************************************
+
+#pragma once
+
+#ifndef PARTICLE_KERNELS_H
+#define PARTICLE_KERNELS_H
+
+#include <cfloat>
+#include "ParticleStorage.h"
+
+// 描述一种粒子类型在VS/GS中的外观计算：
+// t = min(age, maxTime)
+// posW = 0.5 * t * t * accel + t * initialVel + initialPos
+//     accel = accelScale * (perParticleAccel ? 粒子accel : 1)
+// opacity = max(opacityBase - smoothstep(0, opacityRange, t), opacityMin)
+// halfSize = sizeScale * size + sizeAgeSlope * age + sizeBias
+struct ParticleAppearance
+{
+    Float3 accelScale = {};
+    bool perParticleAccel = false;
+    float maxTime = FLT_MAX;
+    float opacityBase = 1.0f;
+    float opacityRange = 1.0f;
+    float opacityMin = 0.0f;
+    float sizeScale = 0.5f;
+    float sizeAgeSlope = 0.0f;
+    float sizeBias = 0.0f;
+};
+
+// 按PT_*索引
+struct ParticleAppearanceTable
+{
+    ParticleAppearance types[4];
+};
+
+// Age通道的含义：默认即为存活时间
+// BirthRing模式下存放出生时间，age = now - 存储值
+struct ParticleAgeMapping
+{
+    float sign = 1.0f;
+    float offset = 0.0f;
+
+    static ParticleAgeMapping FromBirthTime(float now) { return { -1.0f, now }; }
+};
+
+// 内核输出，下标i对应输入的第first + i个粒子
+struct ParticleEvalOutput
+{
+    float* posX;
+    float* posY;
+    float* posZ;
+    float* opacity;
+    float* halfWidth;
+    float* halfHeight;
+};
+
+// 持有内核输出所需的对齐数组
+class ParticleEvalBuffer
+{
+public:
+    void Reserve(uint32_t capacity);
+    uint32_t GetCapacity() const { return m_Capacity; }
+
+    ParticleEvalOutput GetOutput();
+
+    const float* GetPosX() const { return m_Data[0].data(); }
+    const float* GetPosY() const { return m_Data[1].data(); }
+    const float* GetPosZ() const { return m_Data[2].data(); }
+    const float* GetOpacity() const { return m_Data[3].data(); }
+    const float* GetHalfWidth() const { return m_Data[4].data(); }
+    const float* GetHalfHeight() const { return m_Data[5].data(); }
+
+private:
+    uint32_t m_Capacity = 0;
+    AlignedVector<float> m_Data[6];
+};
+
+// 使用当前编译目标下最宽的SIMD实现
+void EvaluateParticles(const ParticleStorage& storage, uint32_t first, uint32_t count,
+    const ParticleAppearanceTable& appearance, const ParticleEvalOutput& output,
+    const ParticleAgeMapping& ages = {});
+// 逐粒子的标量参考实现
+void EvaluateParticlesScalar(const ParticleStorage& storage, uint32_t first, uint32_t count,
+    const ParticleAppearanceTable& appearance, const ParticleEvalOutput& output,
+    const ParticleAgeMapping& ages = {});
+
+// 单个粒子在存活时间为t时的位置，与EvaluateParticles的结果一致
+Float3 EvaluateParticlePosition(const ParticleVertex& v, float t, const ParticleAppearance& appearance);
+
+// ages[i] += dt
+void AdvanceAges(float* ages, uint32_t count, float dt);
+
+// 当前使用的SIMD宽度
+int GetParticleSimdWidth();
+
+#endif
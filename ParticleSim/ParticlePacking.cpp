@@ -0,0 +1,310 @@
+#include "ParticlePacking.h"
+#include "ParticleSimd.h"
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+    uint32_t AsUint(float f)
+    {
+        uint32_t u;
+        std::memcpy(&u, &f, sizeof(u));
+        return u;
+    }
+
+    float AsFloat(uint32_t u)
+    {
+        float f;
+        std::memcpy(&f, &u, sizeof(f));
+        return f;
+    }
+
+    // 量化/反量化的比例，标量与SIMD路径使用相同的运算以得到相同的结果
+    float GetAgeScale(const PackedParticleConstants& constants) { return 65535.0f / constants.ageRange; }
+    float GetAgeStep(const PackedParticleConstants& constants) { return constants.ageRange / 65535.0f; }
+
+    uint16_t QuantizeAge(float age, const PackedParticleConstants& constants)
+    {
+        const float q = (age - constants.ageMin) * GetAgeScale(constants);
+        return static_cast<uint16_t>(std::min(std::max(q, 0.0f), 65535.0f) + 0.5f);
+    }
+
+    float DequantizeAge(uint16_t age, const PackedParticleConstants& constants)
+    {
+        return constants.ageMin + static_cast<float>(age) * GetAgeStep(constants);
+    }
+
+#if defined(PARTICLE_SIMD_SSE2)
+
+    // 与FloatToHalf逐位一致，每条32位通道的低16位为结果，高16位为0
+    __m128i FloatToHalf4(__m128 f)
+    {
+        const __m128i halfMax = _mm_set1_epi32((127 + 16) << 23);
+        const __m128i infinity = _mm_set1_epi32(0x7F800000);
+        const __m128i minNormal = _mm_set1_epi32((127 - 14) << 23);
+        const __m128i subnormalMagic = _mm_set1_epi32(126 << 23);
+        const __m128i normalBias = _mm_set1_epi32(static_cast<int>(((15u - 127u) << 23) + 0xFFFu));
+
+        __m128 sign = _mm_and_ps(f, _mm_set1_ps(-0.0f));
+        __m128i absBits = _mm_castps_si128(_mm_xor_ps(f, sign));
+
+        __m128i isNaN = _mm_cmpgt_epi32(absBits, infinity);
+        __m128i isRegular = _mm_cmpgt_epi32(halfMax, absBits);
+        __m128i isSubnormal = _mm_cmpgt_epi32(minNormal, absBits);
+        __m128i infOrNaN = _mm_or_si128(_mm_and_si128(isNaN, _mm_set1_epi32(0x200)), _mm_set1_epi32(0x7C00));
+
+        // 非规格化数借助浮点加法完成移位与舍入
+        __m128 subnormalSum = _mm_add_ps(_mm_castsi128_ps(absBits), _mm_castsi128_ps(subnormalMagic));
+        __m128i subnormal = _mm_sub_epi32(_mm_castps_si128(subnormalSum), subnormalMagic);
+        // 规格化数调整指数偏移，尾数舍入到最近的偶数
+        __m128i mantissaOdd = _mm_and_si128(_mm_srli_epi32(absBits, 13), _mm_set1_epi32(1));
+        __m128i normal = _mm_srli_epi32(_mm_add_epi32(_mm_add_epi32(absBits, normalBias), mantissaOdd), 13);
+
+        __m128i finite = _mm_or_si128(_mm_and_si128(isSubnormal, subnormal), _mm_andnot_si128(isSubnormal, normal));
+        __m128i joined = _mm_or_si128(_mm_and_si128(isRegular, finite), _mm_andnot_si128(isRegular, infOrNaN));
+        return _mm_or_si128(joined, _mm_srli_epi32(_mm_castps_si128(sign), 16));
+    }
+
+    // 每条32位通道的低16位为输入，高16位需为0
+    __m128 HalfToFloat4(__m128i h)
+    {
+        __m128i expMantissa = _mm_and_si128(h, _mm_set1_epi32(0x7FFF));
+        __m128i sign = _mm_slli_epi32(_mm_xor_si128(h, expMantissa), 16);
+        // 乘以2^112调整指数偏移，非规格化数同时被规格化
+        __m128 scaled = _mm_mul_ps(_mm_castsi128_ps(_mm_slli_epi32(expMantissa, 13)),
+            _mm_castsi128_ps(_mm_set1_epi32((254 - 15) << 23)));
+        __m128i wasInfNaN = _mm_cmpgt_epi32(expMantissa, _mm_set1_epi32(0x7BFF));
+        __m128 infNaNExp = _mm_and_ps(_mm_castsi128_ps(wasInfNaN), _mm_castsi128_ps(_mm_set1_epi32(255 << 23)));
+        return _mm_or_ps(scaled, _mm_or_ps(_mm_castsi128_ps(sign), infNaNExp));
+    }
+
+    // 两个半精度值合并为一个32位字，lo在低16位
+    __m128i PackHalves(__m128i lo, __m128i hi)
+    {
+        return _mm_or_si128(_mm_and_si128(lo, _mm_set1_epi32(0xFFFF)), _mm_slli_epi32(hi, 16));
+    }
+
+    __m128i LowHalves(__m128i words) { return _mm_and_si128(words, _mm_set1_epi32(0xFFFF)); }
+    __m128i HighHalves(__m128i words) { return _mm_srli_epi32(words, 16); }
+
+    // 4x4的32位转置，行与列在粒子与字之间互换
+    void Transpose4(__m128i& r0, __m128i& r1, __m128i& r2, __m128i& r3)
+    {
+        __m128i t0 = _mm_unpacklo_epi32(r0, r1);
+        __m128i t1 = _mm_unpacklo_epi32(r2, r3);
+        __m128i t2 = _mm_unpackhi_epi32(r0, r1);
+        __m128i t3 = _mm_unpackhi_epi32(r2, r3);
+        r0 = _mm_unpacklo_epi64(t0, t1);
+        r1 = _mm_unpackhi_epi64(t0, t1);
+        r2 = _mm_unpacklo_epi64(t2, t3);
+        r3 = _mm_unpackhi_epi64(t2, t3);
+    }
+
+#endif
+}
+
+uint16_t FloatToHalf(float value)
+{
+    uint32_t bits = AsUint(value);
+    const uint32_t sign = bits & 0x80000000u;
+    bits ^= sign;
+
+    uint32_t half;
+    if (bits >= (127u + 16u) << 23)
+    {
+        // 上溢为无穷大，NaN保留为静默NaN
+        half = bits > 0x7F800000u ? 0x7E00u : 0x7C00u;
+    }
+    else if (bits < (127u - 14u) << 23)
+    {
+        // 非规格化数借助浮点加法完成移位与舍入
+        half = AsUint(AsFloat(bits) + AsFloat(126u << 23)) - (126u << 23);
+    }
+    else
+    {
+        const uint32_t mantissaOdd = (bits >> 13) & 1;
+        bits += ((15u - 127u) << 23) + 0xFFFu;
+        half = (bits + mantissaOdd) >> 13;
+    }
+    return static_cast<uint16_t>(half | (sign >> 16));
+}
+
+float HalfToFloat(uint16_t value)
+{
+    const uint32_t expMantissa = value & 0x7FFFu;
+    uint32_t bits = AsUint(AsFloat(expMantissa << 13) * AsFloat((254u - 15u) << 23));
+    if (expMantissa > 0x7BFFu)
+        bits |= 255u << 23;
+    return AsFloat(bits | (static_cast<uint32_t>(value & 0x8000u) << 16));
+}
+
+PackedParticle PackParticle(const ParticleVertex& v, const PackedParticleConstants& constants)
+{
+    PackedParticle p;
+    p.initialPos = v.initialPos;
+    p.initialVel[0] = FloatToHalf(v.initialVel.x);
+    p.initialVel[1] = FloatToHalf(v.initialVel.y);
+    p.initialVel[2] = FloatToHalf(v.initialVel.z);
+    p.accel[0] = FloatToHalf(v.accel.x);
+    p.accel[1] = FloatToHalf(v.accel.y);
+    p.accel[2] = FloatToHalf(v.accel.z);
+    p.size[0] = FloatToHalf(v.size.x);
+    p.size[1] = FloatToHalf(v.size.y);
+    p.age = QuantizeAge(v.age, constants);
+    p.type = static_cast<uint8_t>(v.type);
+    p.emitCount = static_cast<uint8_t>(std::min(v.emitCount, 255u));
+    return p;
+}
+
+ParticleVertex UnpackParticle(const PackedParticle& p, const PackedParticleConstants& constants)
+{
+    ParticleVertex v;
+    v.initialPos = p.initialPos;
+    v.initialVel = { HalfToFloat(p.initialVel[0]), HalfToFloat(p.initialVel[1]), HalfToFloat(p.initialVel[2]) };
+    v.accel = { HalfToFloat(p.accel[0]), HalfToFloat(p.accel[1]), HalfToFloat(p.accel[2]) };
+    v.size = { HalfToFloat(p.size[0]), HalfToFloat(p.size[1]) };
+    v.age = DequantizeAge(p.age, constants);
+    v.type = p.type;
+    v.emitCount = p.emitCount;
+    return v;
+}
+
+void PackParticles(const ParticleStorage& storage, uint32_t first, uint32_t count,
+    const PackedParticleConstants& constants, PackedParticle* particles, const ParticleAgeMapping& ages)
+{
+    const float* channels[ParticleStorage::FloatChannelCount];
+    for (uint32_t c = 0; c < ParticleStorage::FloatChannelCount; ++c)
+        channels[c] = storage.GetChannel(static_cast<ParticleChannel>(c)) + first;
+    const uint8_t* types = storage.GetTypes() + first;
+    const uint32_t* emitCounts = storage.GetEmitCounts() + first;
+    const float ageScale = GetAgeScale(constants);
+
+    uint32_t i = 0;
+#if defined(PARTICLE_SIMD_SSE2)
+    // 每次4个粒子：先按字计算出4个粒子的同一个32位字，再转置为4个连续的粒子
+    for (; i + 4 <= count; i += 4)
+    {
+        auto load = [&](ParticleChannel c) { return _mm_loadu_ps(channels[static_cast<size_t>(c)] + i); };
+        auto half = [&](ParticleChannel c) { return FloatToHalf4(load(c)); };
+
+        __m128i w0 = _mm_castps_si128(load(ParticleChannel::PosX));
+        __m128i w1 = _mm_castps_si128(load(ParticleChannel::PosY));
+        __m128i w2 = _mm_castps_si128(load(ParticleChannel::PosZ));
+        __m128i w3 = PackHalves(half(ParticleChannel::VelX), half(ParticleChannel::VelY));
+        __m128i w4 = PackHalves(half(ParticleChannel::VelZ), half(ParticleChannel::AccelX));
+        __m128i w5 = PackHalves(half(ParticleChannel::AccelY), half(ParticleChannel::AccelZ));
+        __m128i w6 = PackHalves(half(ParticleChannel::SizeX), half(ParticleChannel::SizeY));
+
+        __m128 age = _mm_add_ps(_mm_set1_ps(ages.offset), _mm_mul_ps(_mm_set1_ps(ages.sign), load(ParticleChannel::Age)));
+        age = _mm_sub_ps(age, _mm_set1_ps(constants.ageMin));
+        age = _mm_min_ps(_mm_max_ps(_mm_mul_ps(age, _mm_set1_ps(ageScale)), _mm_setzero_ps()), _mm_set1_ps(65535.0f));
+        __m128i quantized = _mm_cvttps_epi32(_mm_add_ps(age, _mm_set1_ps(0.5f)));
+
+        // 类型与饱和到255的发射计数交错为16位，放入第8个字的高16位
+        int typeBytes;
+        std::memcpy(&typeBytes, types + i, sizeof(typeBytes));
+        __m128i counts = _mm_loadu_si128(reinterpret_cast<const __m128i*>(emitCounts + i));
+        __m128i counts8 = _mm_packus_epi16(_mm_packs_epi32(counts, _mm_setzero_si128()), _mm_setzero_si128());
+        __m128i typeCount = _mm_unpacklo_epi8(_mm_cvtsi32_si128(typeBytes), counts8);
+        __m128i w7 = _mm_or_si128(quantized, _mm_unpacklo_epi16(_mm_setzero_si128(), typeCount));
+
+        Transpose4(w0, w1, w2, w3);
+        Transpose4(w4, w5, w6, w7);
+        __m128i* out = reinterpret_cast<__m128i*>(particles + i);
+        _mm_storeu_si128(out + 0, w0);
+        _mm_storeu_si128(out + 1, w4);
+        _mm_storeu_si128(out + 2, w1);
+        _mm_storeu_si128(out + 3, w5);
+        _mm_storeu_si128(out + 4, w2);
+        _mm_storeu_si128(out + 5, w6);
+        _mm_storeu_si128(out + 6, w3);
+        _mm_storeu_si128(out + 7, w7);
+    }
+#endif
+    for (; i < count; ++i)
+    {
+        auto at = [&](ParticleChannel c) { return channels[static_cast<size_t>(c)][i]; };
+        PackedParticle& p = particles[i];
+        p.initialPos = { at(ParticleChannel::PosX), at(ParticleChannel::PosY), at(ParticleChannel::PosZ) };
+        p.initialVel[0] = FloatToHalf(at(ParticleChannel::VelX));
+        p.initialVel[1] = FloatToHalf(at(ParticleChannel::VelY));
+        p.initialVel[2] = FloatToHalf(at(ParticleChannel::VelZ));
+        p.accel[0] = FloatToHalf(at(ParticleChannel::AccelX));
+        p.accel[1] = FloatToHalf(at(ParticleChannel::AccelY));
+        p.accel[2] = FloatToHalf(at(ParticleChannel::AccelZ));
+        p.size[0] = FloatToHalf(at(ParticleChannel::SizeX));
+        p.size[1] = FloatToHalf(at(ParticleChannel::SizeY));
+        p.age = QuantizeAge(ages.offset + ages.sign * at(ParticleChannel::Age), constants);
+        p.type = types[i];
+        p.emitCount = static_cast<uint8_t>(std::min(emitCounts[i], 255u));
+    }
+}
+
+void UnpackParticles(const PackedParticle* particles, uint32_t count,
+    const PackedParticleConstants& constants, ParticleStorage& storage, uint32_t first)
+{
+    float* channels[ParticleStorage::FloatChannelCount];
+    for (uint32_t c = 0; c < ParticleStorage::FloatChannelCount; ++c)
+        channels[c] = storage.GetChannel(static_cast<ParticleChannel>(c)) + first;
+    uint8_t* types = storage.GetTypes() + first;
+    uint32_t* emitCounts = storage.GetEmitCounts() + first;
+    const float ageStep = GetAgeStep(constants);
+
+    uint32_t i = 0;
+#if defined(PARTICLE_SIMD_SSE2)
+    for (; i + 4 <= count; i += 4)
+    {
+        const __m128i* in = reinterpret_cast<const __m128i*>(particles + i);
+        __m128i w0 = _mm_loadu_si128(in + 0);
+        __m128i w4 = _mm_loadu_si128(in + 1);
+        __m128i w1 = _mm_loadu_si128(in + 2);
+        __m128i w5 = _mm_loadu_si128(in + 3);
+        __m128i w2 = _mm_loadu_si128(in + 4);
+        __m128i w6 = _mm_loadu_si128(in + 5);
+        __m128i w3 = _mm_loadu_si128(in + 6);
+        __m128i w7 = _mm_loadu_si128(in + 7);
+        Transpose4(w0, w1, w2, w3);
+        Transpose4(w4, w5, w6, w7);
+
+        auto store = [&](ParticleChannel c, __m128 value) { _mm_storeu_ps(channels[static_cast<size_t>(c)] + i, value); };
+        store(ParticleChannel::PosX, _mm_castsi128_ps(w0));
+        store(ParticleChannel::PosY, _mm_castsi128_ps(w1));
+        store(ParticleChannel::PosZ, _mm_castsi128_ps(w2));
+        store(ParticleChannel::VelX, HalfToFloat4(LowHalves(w3)));
+        store(ParticleChannel::VelY, HalfToFloat4(HighHalves(w3)));
+        store(ParticleChannel::VelZ, HalfToFloat4(LowHalves(w4)));
+        store(ParticleChannel::AccelX, HalfToFloat4(HighHalves(w4)));
+        store(ParticleChannel::AccelY, HalfToFloat4(LowHalves(w5)));
+        store(ParticleChannel::AccelZ, HalfToFloat4(HighHalves(w5)));
+        store(ParticleChannel::SizeX, HalfToFloat4(LowHalves(w6)));
+        store(ParticleChannel::SizeY, HalfToFloat4(HighHalves(w6)));
+        store(ParticleChannel::Age, _mm_add_ps(_mm_set1_ps(constants.ageMin),
+            _mm_mul_ps(_mm_cvtepi32_ps(LowHalves(w7)), _mm_set1_ps(ageStep))));
+
+        __m128i typeCount = HighHalves(w7);
+        __m128i type = _mm_and_si128(typeCount, _mm_set1_epi32(0xFF));
+        int typeBytes = _mm_cvtsi128_si32(_mm_packus_epi16(_mm_packs_epi32(type, type), type));
+        std::memcpy(types + i, &typeBytes, sizeof(typeBytes));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(emitCounts + i), _mm_srli_epi32(typeCount, 8));
+    }
+#endif
+    for (; i < count; ++i)
+    {
+        const PackedParticle& p = particles[i];
+        auto set = [&](ParticleChannel c, float value) { channels[static_cast<size_t>(c)][i] = value; };
+        set(ParticleChannel::PosX, p.initialPos.x);
+        set(ParticleChannel::PosY, p.initialPos.y);
+        set(ParticleChannel::PosZ, p.initialPos.z);
+        set(ParticleChannel::VelX, HalfToFloat(p.initialVel[0]));
+        set(ParticleChannel::VelY, HalfToFloat(p.initialVel[1]));
+        set(ParticleChannel::VelZ, HalfToFloat(p.initialVel[2]));
+        set(ParticleChannel::AccelX, HalfToFloat(p.accel[0]));
+        set(ParticleChannel::AccelY, HalfToFloat(p.accel[1]));
+        set(ParticleChannel::AccelZ, HalfToFloat(p.accel[2]));
+        set(ParticleChannel::SizeX, HalfToFloat(p.size[0]));
+        set(ParticleChannel::SizeY, HalfToFloat(p.size[1]));
+        set(ParticleChannel::Age, DequantizeAge(p.age, constants));
+        types[i] = p.type;
+        emitCounts[i] = p.emitCount;
+    }
+}
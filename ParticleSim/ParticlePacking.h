@@ -0,0 +1,60 @@
+//***************************************************************************************
+// ParticlePacking.h
+//
+// 32字节的量化粒子格式及其与SoA存储之间的SIMD打包/解包
+// Quantized 32-byte particle format and SIMD pack/unpack between it and the SoA
+// storage.
+//***************************************************************************************
+
+#pragma once
+
+#ifndef PARTICLE_PACKING_H
+#define PARTICLE_PACKING_H
+
+#include <cstdint>
+#include "ParticleSimTypes.h"
+#include "ParticleStorage.h"
+#include "ParticleKernels.h"
+
+// 与ParticleVertex(56字节)相比：
+// 位置仍为32位浮点，速度、加速度与尺寸为半精度浮点，存活时间在系统的[ageMin, ageMin + ageRange]内量化为16位
+// 类型与发射计数各占8位，发射计数超过255时饱和
+struct PackedParticle
+{
+    Float3 initialPos;
+    uint16_t initialVel[3];
+    uint16_t accel[3];
+    uint16_t size[2];
+    uint16_t age;           // round((age - ageMin) / ageRange * 65535)，超出范围时饱和
+    uint8_t type;
+    uint8_t emitCount;
+};
+
+static_assert(sizeof(PackedParticle) == 32, "PackedParticle must stay two 16-byte halves");
+
+// 同一系统内所有粒子共享的量化参数，不随粒子存放
+// 存活时间可以为负(Boom延迟发射的壳、绘制滞后时刚出生的粒子)，ageMin不大于0
+struct PackedParticleConstants
+{
+    float ageMin = 0.0f;
+    float ageRange = 1.0f;
+
+    static PackedParticleConstants FromAgeRange(float ageMin, float ageMax) { return { ageMin, ageMax - ageMin }; }
+};
+
+// IEEE半精度浮点转换，舍入到最近的偶数，超出范围时为无穷大
+uint16_t FloatToHalf(float value);
+float HalfToFloat(uint16_t value);
+
+PackedParticle PackParticle(const ParticleVertex& v, const PackedParticleConstants& constants);
+ParticleVertex UnpackParticle(const PackedParticle& p, const PackedParticleConstants& constants);
+
+// 将storage中[first, first + count)的粒子打包到particles，存活时间按ages换算
+void PackParticles(const ParticleStorage& storage, uint32_t first, uint32_t count,
+    const PackedParticleConstants& constants, PackedParticle* particles, const ParticleAgeMapping& ages = {});
+// 将count个打包的粒子写入storage的[first, first + count)，Age通道为存活时间
+// storage的大小需已覆盖该范围
+void UnpackParticles(const PackedParticle* particles, uint32_t count,
+    const PackedParticleConstants& constants, ParticleStorage& storage, uint32_t first);
+
+#endif
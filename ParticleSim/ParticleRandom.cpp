@@ -0,0 +1,223 @@
+#include "ParticleRandom.h"
+#include "ParticleSimd.h"
+
+namespace
+{
+    // Philox4x32-10的常量
+    constexpr uint32_t PhiloxM0 = 0xD2511F53u;
+    constexpr uint32_t PhiloxM1 = 0xCD9E8D57u;
+    constexpr uint32_t PhiloxW0 = 0x9E3779B9u;
+    constexpr uint32_t PhiloxW1 = 0xBB67AE85u;
+    constexpr int PhiloxRounds = 10;
+
+    //
+    // 与SimdFloat*对应宽度的32位无符号整数封装，只提供Philox所需的运算
+    //
+
+    struct SimdUint1
+    {
+        static constexpr int Width = 1;
+        using Float = SimdFloat1;
+        uint32_t v;
+
+        static SimdUint1 Set1(uint32_t x) { return { x }; }
+        static SimdUint1 Load(const uint32_t* p) { return { *p }; }
+        friend SimdUint1 operator+(SimdUint1 a, SimdUint1 b) { return { a.v + b.v }; }
+        friend SimdUint1 operator^(SimdUint1 a, SimdUint1 b) { return { a.v ^ b.v }; }
+        static void MulHiLo(SimdUint1 a, uint32_t m, SimdUint1& hi, SimdUint1& lo)
+        {
+            uint64_t product = static_cast<uint64_t>(a.v) * m;
+            hi.v = static_cast<uint32_t>(product >> 32);
+            lo.v = static_cast<uint32_t>(product);
+        }
+        Float ToSignedUnit() const { return { ParticleRandom::ToSignedUnit(v) }; }
+    };
+
+#if defined(PARTICLE_SIMD_SSE2)
+    struct SimdUint4
+    {
+        static constexpr int Width = 4;
+        using Float = SimdFloat4;
+        __m128i v;
+
+        static SimdUint4 Set1(uint32_t x) { return { _mm_set1_epi32(static_cast<int>(x)) }; }
+        static SimdUint4 Load(const uint32_t* p) { return { _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)) }; }
+        friend SimdUint4 operator+(SimdUint4 a, SimdUint4 b) { return { _mm_add_epi32(a.v, b.v) }; }
+        friend SimdUint4 operator^(SimdUint4 a, SimdUint4 b) { return { _mm_xor_si128(a.v, b.v) }; }
+        static void MulHiLo(SimdUint4 a, uint32_t m, SimdUint4& hi, SimdUint4& lo)
+        {
+            // _mm_mul_epu32只计算偶数通道，奇数通道右移后再算一次
+            const __m128i mv = _mm_set1_epi32(static_cast<int>(m));
+            const __m128i lowMask = _mm_set1_epi64x(0xFFFFFFFFll);
+            __m128i even = _mm_mul_epu32(a.v, mv);
+            __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a.v, 32), mv);
+            hi.v = _mm_or_si128(_mm_srli_epi64(even, 32), _mm_andnot_si128(lowMask, odd));
+            lo.v = _mm_or_si128(_mm_and_si128(even, lowMask), _mm_slli_epi64(odd, 32));
+        }
+        Float ToSignedUnit() const
+        {
+            Float f = { _mm_cvtepi32_ps(_mm_srli_epi32(v, 8)) };
+            return f * Float::Set1(1.0f / 8388608.0f) - Float::Set1(1.0f);
+        }
+    };
+#endif
+
+#if defined(PARTICLE_SIMD_AVX2)
+    struct SimdUint8
+    {
+        static constexpr int Width = 8;
+        using Float = SimdFloat8;
+        __m256i v;
+
+        static SimdUint8 Set1(uint32_t x) { return { _mm256_set1_epi32(static_cast<int>(x)) }; }
+        static SimdUint8 Load(const uint32_t* p) { return { _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)) }; }
+        friend SimdUint8 operator+(SimdUint8 a, SimdUint8 b) { return { _mm256_add_epi32(a.v, b.v) }; }
+        friend SimdUint8 operator^(SimdUint8 a, SimdUint8 b) { return { _mm256_xor_si256(a.v, b.v) }; }
+        static void MulHiLo(SimdUint8 a, uint32_t m, SimdUint8& hi, SimdUint8& lo)
+        {
+            const __m256i mv = _mm256_set1_epi32(static_cast<int>(m));
+            const __m256i lowMask = _mm256_set1_epi64x(0xFFFFFFFFll);
+            __m256i even = _mm256_mul_epu32(a.v, mv);
+            __m256i odd = _mm256_mul_epu32(_mm256_srli_epi64(a.v, 32), mv);
+            hi.v = _mm256_or_si256(_mm256_srli_epi64(even, 32), _mm256_andnot_si256(lowMask, odd));
+            lo.v = _mm256_or_si256(_mm256_and_si256(even, lowMask), _mm256_slli_epi64(odd, 32));
+        }
+        Float ToSignedUnit() const
+        {
+            Float f = { _mm256_cvtepi32_ps(_mm256_srli_epi32(v, 8)) };
+            return f * Float::Set1(1.0f / 8388608.0f) - Float::Set1(1.0f);
+        }
+    };
+#endif
+
+#if defined(PARTICLE_SIMD_AVX2)
+    using SimdUint = SimdUint8;
+#elif defined(PARTICLE_SIMD_SSE2)
+    using SimdUint = SimdUint4;
+#else
+    using SimdUint = SimdUint1;
+#endif
+
+    // 每轮使用的密钥，在所有通道间相同
+    template<class U>
+    struct PhiloxKeySchedule
+    {
+        U k0[PhiloxRounds];
+        U k1[PhiloxRounds];
+
+        explicit PhiloxKeySchedule(const uint32_t key[2])
+        {
+            for (int r = 0; r < PhiloxRounds; ++r)
+            {
+                k0[r] = U::Set1(key[0] + PhiloxW0 * r);
+                k1[r] = U::Set1(key[1] + PhiloxW1 * r);
+            }
+        }
+    };
+
+    // 每条通道处理一个计数器，Blocks组计数器交错计算以隐藏乘法的延迟
+    template<int Blocks, class U>
+    void Philox4x32(U (*c)[4], const PhiloxKeySchedule<U>& keys)
+    {
+        for (int r = 0; r < PhiloxRounds; ++r)
+        {
+            for (int b = 0; b < Blocks; ++b)
+            {
+                U hi0, lo0, hi1, lo1;
+                U::MulHiLo(c[b][0], PhiloxM0, hi0, lo0);
+                U::MulHiLo(c[b][2], PhiloxM1, hi1, lo1);
+                c[b][0] = hi1 ^ c[b][1] ^ keys.k0[r];
+                c[b][1] = lo1;
+                c[b][2] = hi0 ^ c[b][3] ^ keys.k1[r];
+                c[b][3] = lo0;
+            }
+        }
+    }
+
+    template<class U>
+    void UniformVec3Range(const uint32_t key[2], uint32_t id, uint32_t frame, uint32_t stream,
+        uint32_t firstIndex, uint32_t count, float* x, float* y, float* z)
+    {
+        uint32_t o = 0;
+        if (count >= U::Width)
+        {
+            // 密钥的广播只做一次
+            const PhiloxKeySchedule<U> keys(key);
+            uint32_t indices[U::Width];
+            for (int l = 0; l < U::Width; ++l)
+                indices[l] = l;
+            const U lanes = U::Load(indices);
+
+            constexpr int Blocks = 2;
+            for (; o + Blocks * U::Width <= count; o += Blocks * U::Width)
+            {
+                U c[Blocks][4];
+                for (int b = 0; b < Blocks; ++b)
+                {
+                    c[b][0] = U::Set1(id);
+                    c[b][1] = U::Set1(frame);
+                    c[b][2] = U::Set1(stream);
+                    c[b][3] = U::Set1(firstIndex + o + b * U::Width) + lanes;
+                }
+                Philox4x32<Blocks>(c, keys);
+                for (int b = 0; b < Blocks; ++b)
+                {
+                    c[b][0].ToSignedUnit().Store(x + o + b * U::Width);
+                    c[b][1].ToSignedUnit().Store(y + o + b * U::Width);
+                    c[b][2].ToSignedUnit().Store(z + o + b * U::Width);
+                }
+            }
+            for (; o + U::Width <= count; o += U::Width)
+            {
+                U c[1][4] = { { U::Set1(id), U::Set1(frame), U::Set1(stream), U::Set1(firstIndex + o) + lanes } };
+                Philox4x32<1>(c, keys);
+                c[0][0].ToSignedUnit().Store(x + o);
+                c[0][1].ToSignedUnit().Store(y + o);
+                c[0][2].ToSignedUnit().Store(z + o);
+            }
+        }
+
+        const PhiloxKeySchedule<SimdUint1> keys(key);
+        for (; o < count; ++o)
+        {
+            SimdUint1 c[1][4] = { { { id }, { frame }, { stream }, { firstIndex + o } } };
+            Philox4x32<1>(c, keys);
+            x[o] = ParticleRandom::ToSignedUnit(c[0][0].v);
+            y[o] = ParticleRandom::ToSignedUnit(c[0][1].v);
+            z[o] = ParticleRandom::ToSignedUnit(c[0][2].v);
+        }
+    }
+}
+
+void ParticleRandom::SetSeed(uint64_t seed)
+{
+    m_Key[0] = static_cast<uint32_t>(seed);
+    m_Key[1] = static_cast<uint32_t>(seed >> 32);
+}
+
+void ParticleRandom::Generate(uint32_t id, uint32_t frame, uint32_t stream, uint32_t index, uint32_t out[4]) const
+{
+    SimdUint1 c[1][4] = { { { id }, { frame }, { stream }, { index } } };
+    Philox4x32<1>(c, PhiloxKeySchedule<SimdUint1>(m_Key));
+    for (int i = 0; i < 4; ++i)
+        out[i] = c[0][i].v;
+}
+
+Float3 ParticleRandom::UniformVec3(uint32_t id, uint32_t frame, uint32_t stream, uint32_t index) const
+{
+    uint32_t bits[4];
+    Generate(id, frame, stream, index, bits);
+    return { ToSignedUnit(bits[0]), ToSignedUnit(bits[1]), ToSignedUnit(bits[2]) };
+}
+
+void ParticleRandom::UniformVec3Bulk(uint32_t id, uint32_t frame, uint32_t stream, uint32_t firstIndex, uint32_t count,
+    float* x, float* y, float* z) const
+{
+    UniformVec3Range<SimdUint>(m_Key, id, frame, stream, firstIndex, count, x, y, z);
+}
+
+void ParticleRandom::UniformVec3BulkScalar(uint32_t id, uint32_t frame, uint32_t stream, uint32_t firstIndex, uint32_t count,
+    float* x, float* y, float* z) const
+{
+    UniformVec3Range<SimdUint1>(m_Key, id, frame, stream, firstIndex, count, x, y, z);
+}
@@ -0,0 +1,52 @@
+//***************************************************************************************
+// ParticleRandom.h
+//
+// 基于计数器的无状态随机数(Philox4x32-10)，由(种子, 粒子id, 帧号)直接得到随机数
+// Stateless counter-based random numbers (Philox4x32-10): values are a pure function of
+// (seed, particle id, frame).
+//***************************************************************************************
+
+#pragma once
+
+#ifndef PARTICLE_RANDOM_H
+#define PARTICLE_RANDOM_H
+
+#include <cstdint>
+#include "ParticleSimTypes.h"
+
+// 计数器的四个分量：id, frame, stream, index
+// stream区分同一粒子在同一帧中的不同用途，index区分批量生成时的序号
+// 相同的输入总是得到相同的结果，不同线程之间无需共享状态
+class ParticleRandom
+{
+public:
+    explicit ParticleRandom(uint64_t seed = 0) { SetSeed(seed); }
+
+    void SetSeed(uint64_t seed);
+    uint64_t GetSeed() const { return (static_cast<uint64_t>(m_Key[1]) << 32) | m_Key[0]; }
+
+    // 一次Philox4x32-10得到的4个32位随机数
+    void Generate(uint32_t id, uint32_t frame, uint32_t stream, uint32_t index, uint32_t out[4]) const;
+
+    // [-1, 1)内的均匀分布，与GameApp中随机纹理的取值范围相同
+    Float3 UniformVec3(uint32_t id, uint32_t frame, uint32_t stream, uint32_t index = 0) const;
+
+    // 批量生成index为[firstIndex, firstIndex + count)的随机向量，按SoA写入
+    // 使用当前编译目标下最宽的SIMD实现，结果与逐个调用UniformVec3逐位相同
+    void UniformVec3Bulk(uint32_t id, uint32_t frame, uint32_t stream, uint32_t firstIndex, uint32_t count,
+        float* x, float* y, float* z) const;
+    // 逐个计算的参考实现
+    void UniformVec3BulkScalar(uint32_t id, uint32_t frame, uint32_t stream, uint32_t firstIndex, uint32_t count,
+        float* x, float* y, float* z) const;
+
+    // 将32位随机数映射到[-1, 1)，只使用高24位以保证精确
+    static float ToSignedUnit(uint32_t bits)
+    {
+        return static_cast<float>(bits >> 8) * (1.0f / 8388608.0f) - 1.0f;
+    }
+
+private:
+    uint32_t m_Key[2] = {};
+};
+
+#endif
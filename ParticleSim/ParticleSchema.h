@@ -0,0 +1,145 @@
+//***************************************************************************************
+// ParticleSchema.h
+//
+// 粒子顶点属性的唯一声明，SoA存储、AoS转换、输入布局/流输出声明与序列化均由它生成
+// Single declaration of the particle vertex attributes; SoA storage, AoS packing,
+// input/stream-output layouts and serialization are all generated from it.
+//***************************************************************************************
+
+#pragma once
+
+#ifndef PARTICLE_SCHEMA_H
+#define PARTICLE_SCHEMA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include "ParticleSimTypes.h"
+
+// 属性在着色器中的分量类型
+enum class ParticleAttributeFormat : uint8_t
+{
+    Float,
+    Uint,
+};
+
+// 属性在SoA存储中的存放方式，每个分量一个数组
+enum class ParticleAttributeStorage : uint8_t
+{
+    Float,      // 32位浮点通道
+    Byte,       // 8位整数通道，取值需小于256
+    Uint,       // 32位整数通道
+};
+
+struct ParticleAttribute
+{
+    const char* semantic;               // Particle.hlsl中VertexParticle的语义
+    ParticleAttributeFormat format;
+    ParticleAttributeStorage storage;
+    uint32_t componentCount;
+    uint32_t offset;                    // 在ParticleVertex中的字节偏移
+};
+
+// 与Particle.hlsl中的VertexParticle一一对应，顺序即内存顺序
+// 增删属性时只需修改这里与ParticleVertex、HLSL的声明，其余布局会随之生成或在编译期报错
+struct ParticleVertexSchema
+{
+    static constexpr ParticleAttribute Attributes[] = {
+        { "POSITION",   ParticleAttributeFormat::Float, ParticleAttributeStorage::Float, 3, offsetof(ParticleVertex, initialPos) },
+        { "VELOCITY",   ParticleAttributeFormat::Float, ParticleAttributeStorage::Float, 3, offsetof(ParticleVertex, initialVel) },
+        { "ACCEL",      ParticleAttributeFormat::Float, ParticleAttributeStorage::Float, 3, offsetof(ParticleVertex, accel) },
+        { "SIZE",       ParticleAttributeFormat::Float, ParticleAttributeStorage::Float, 2, offsetof(ParticleVertex, size) },
+        { "AGE",        ParticleAttributeFormat::Float, ParticleAttributeStorage::Float, 1, offsetof(ParticleVertex, age) },
+        { "TYPE",       ParticleAttributeFormat::Uint,  ParticleAttributeStorage::Byte,  1, offsetof(ParticleVertex, type) },
+        { "EMIT_COUNT", ParticleAttributeFormat::Uint,  ParticleAttributeStorage::Uint,  1, offsetof(ParticleVertex, emitCount) },
+    };
+    static constexpr uint32_t AttributeCount = static_cast<uint32_t>(sizeof(Attributes) / sizeof(Attributes[0]));
+    static constexpr uint32_t Stride = sizeof(ParticleVertex);
+
+    // 第index个属性的第一个分量在同类存储通道中的下标
+    static constexpr uint32_t GetFirstChannel(uint32_t index)
+    {
+        uint32_t channel = 0;
+        for (uint32_t i = 0; i < index; ++i)
+        {
+            if (Attributes[i].storage == Attributes[index].storage)
+                channel += Attributes[i].componentCount;
+        }
+        return channel;
+    }
+
+    static constexpr uint32_t GetChannelCount(ParticleAttributeStorage storage)
+    {
+        uint32_t count = 0;
+        for (const ParticleAttribute& a : Attributes)
+        {
+            if (a.storage == storage)
+                count += a.componentCount;
+        }
+        return count;
+    }
+
+    static constexpr int FindAttribute(const char* semantic)
+    {
+        for (uint32_t i = 0; i < AttributeCount; ++i)
+        {
+            const char* a = Attributes[i].semantic;
+            const char* b = semantic;
+            while (*a && *a == *b)
+                ++a, ++b;
+            if (*a == *b)
+                return static_cast<int>(i);
+        }
+        return -1;
+    }
+
+    // 属性依次紧密排列且恰好占满ParticleVertex，流输出与输入布局才能按顺序追加
+    static constexpr bool IsTightlyPacked()
+    {
+        uint32_t offset = 0;
+        for (const ParticleAttribute& a : Attributes)
+        {
+            if (a.offset != offset)
+                return false;
+            offset += a.componentCount * 4;
+        }
+        return offset == Stride;
+    }
+
+    // 属性声明的签名，序列化的数据只能由签名相同的程序读取
+    static constexpr uint32_t GetSignature()
+    {
+        uint32_t hash = 2166136261u;
+        auto mix = [&hash](uint32_t value) {
+            hash ^= value;
+            hash *= 16777619u;
+        };
+        for (const ParticleAttribute& a : Attributes)
+        {
+            for (const char* c = a.semantic; *c; ++c)
+                mix(static_cast<uint8_t>(*c));
+            mix(static_cast<uint32_t>(a.format));
+            mix(static_cast<uint32_t>(a.storage));
+            mix(a.componentCount);
+        }
+        return hash;
+    }
+
+    // 对每个属性调用func(std::integral_constant<uint32_t, i>)，在编译期展开
+    template<class Func>
+    static void ForEachAttribute(Func&& func)
+    {
+        ForEachAttribute(func, std::make_integer_sequence<uint32_t, AttributeCount>{});
+    }
+
+private:
+    template<class Func, uint32_t... I>
+    static void ForEachAttribute(Func& func, std::integer_sequence<uint32_t, I...>)
+    {
+        (func(std::integral_constant<uint32_t, I>{}), ...);
+    }
+};
+
+static_assert(ParticleVertexSchema::IsTightlyPacked(), "ParticleVertexSchema must cover ParticleVertex without gaps");
+
+#endif
@@ -0,0 +1,1571 @@
+#include "ParticleSimCPU.h"
+#include "ParticleSystem.h"
+#include "JobSystem.h"
+#include "ParticleStateHash.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+void ParticleSimCPU::Init(ParticleEffectType effectType, uint32_t maxParticles, uint64_t seed)
+{
+    m_EffectType = effectType;
+    m_pKernels = &GetParticleSystemKernels(effectType);
+    m_MaxParticles = maxParticles;
+
+    m_Particles.Reserve(maxParticles);
+    m_Scratch.Reserve(maxParticles);
+    m_Alive.assign(maxParticles, 0);
+    m_Chunks.resize((maxParticles + ChunkSize - 1) / ChunkSize);
+    m_ChunkSpawned.resize(m_Chunks.size());
+    m_ChunkRequests.resize(m_Chunks.size());
+    m_ChunkEvents.resize(m_Chunks.size());
+    m_FreeSlots.reserve(maxParticles);
+    m_PoolTimers.assign(maxParticles, PTM_Expire);
+    m_PoolFiredEvents.assign(maxParticles, 0);
+    m_Wheel.Init(maxParticles);
+
+    m_Random.SetSeed(seed);
+
+    m_SubEmitters.clear();
+    if (effectType == ParticleEffectType::FireSmoke)
+    {
+        // 火焰粒子临近消亡时产生烟雾，取代流输出中按primitiveID % 30选取的方式
+        // 每个火焰粒子只在越过0.8倍寿命时判定一次，烟雾的产生速率与帧率无关
+        SubEmitterDesc smoke;
+        smoke.trigger = ParticleEventType::AgeThreshold;
+        smoke.sourceType = PT_PARTICLE;
+        smoke.spawnType = PT_SMOKE;
+        smoke.ageFraction = 0.8f;
+        smoke.chance = 1.0f / 30.0f;
+        // 着色器没有每帧的上限。默认0.005s的发射间隔下，60Hz时每帧约3.3个火焰粒子越过阈值，
+        // 各以1/30的概率产生烟雾，30Hz时一帧超过4个的概率也只有约1e-6，正常运行时不起作用；
+        // 只在卡顿后大量火焰粒子同一帧越过阈值时，避免在同一处一次产生几十个烟雾
+        smoke.frameBudget = 4;
+        smoke.liveBudget = 101;     // 对应g_SmokeParticleCount <= 100
+        m_SubEmitters.push_back(smoke);
+    }
+
+    Reset();
+}
+
+void ParticleSimCPU::SetEmitPos(const Float3& emitPos)
+{
+    m_Params.emitPos = emitPos;
+    RefreshBounds(false);
+}
+
+void ParticleSimCPU::SetEmitDir(const Float3& emitDir)
+{
+    m_Params.emitDir = emitDir;
+}
+
+void ParticleSimCPU::SetEmitInterval(float t)
+{
+    bool changed = m_Params.emitInterval != t;
+    m_Params.emitInterval = t;
+    if (changed && m_StorageMode == ParticleStorageMode::Pool)
+        RebuildPoolTimers();
+    // 壳的爆炸点随之改变
+    if (changed)
+        RefreshBounds(true);
+}
+
+void ParticleSimCPU::SetAliveTime(float t)
+{
+    bool changed = m_Params.aliveTime != t;
+    m_Params.aliveTime = t;
+    if (changed && m_StorageMode == ParticleStorageMode::Pool)
+        RebuildPoolTimers();
+    if (changed)
+        RefreshBounds(true);
+}
+
+void ParticleSimCPU::SetAcceleration(const Float3& accel)
+{
+    bool changed = m_Params.accel.x != accel.x || m_Params.accel.y != accel.y || m_Params.accel.z != accel.z;
+    m_Params.accel = accel;
+    // 轨迹由闭式求出，现有粒子同样按新的加速度运动
+    if (changed)
+        RefreshBounds(true);
+}
+
+uint32_t ParticleSimCPU::AddEmitter(const ParticleEmitterDesc& desc)
+{
+    if (m_StorageMode == ParticleStorageMode::BirthRing)
+        SetStorageMode(ParticleStorageMode::Compact);
+    return m_EmitterTable.Add(desc);
+}
+
+void ParticleSimCPU::ClearEmitters()
+{
+    m_EmitterTable.Clear();
+}
+
+void ParticleSimCPU::AddSubEmitter(const SubEmitterDesc& desc)
+{
+    if (m_SubEmitters.size() >= MaxSubEmitters)
+        return;
+    m_SubEmitters.push_back(desc);
+    m_SubEmitterTotals[m_SubEmitters.size() - 1] = 0;
+    if (m_StorageMode == ParticleStorageMode::Pool)
+        RebuildPoolTimers();
+    // 现有粒子也会产生新的后代
+    RefreshBounds(true);
+}
+
+void ParticleSimCPU::ClearSubEmitters()
+{
+    m_SubEmitters.clear();
+    std::fill(std::begin(m_SubEmitterTotals), std::end(m_SubEmitterTotals), 0ull);
+    if (m_StorageMode == ParticleStorageMode::Pool)
+        RebuildPoolTimers();
+    RefreshBounds(false);
+}
+
+void ParticleSimCPU::SetParticleCount(uint32_t defaultParticle, uint32_t smokeParticle)
+{
+    m_Params.defaultParticleCount = defaultParticle;
+    m_Params.smokeParticleCount = smokeParticle;
+}
+
+void ParticleSimCPU::Reset()
+{
+    // 与m_pInitVB相同：一个类型为0、存活时间为0的发射器
+    m_Emitter = ParticleVertex{};
+    m_HasEmitter = true;
+    m_Particles.Clear();
+    std::fill(std::begin(m_TypeCounts), std::end(m_TypeCounts), 0u);
+    std::fill(std::begin(m_SubEmitterTotals), std::end(m_SubEmitterTotals), 0ull);
+    m_SurvivorSourceCount = 0;
+    m_Age = 0.0f;
+    m_FrameIndex = 0;
+
+    m_RingHead = 0;
+    m_RingCount = 0;
+    m_Clock = 0.0;
+    m_ClockEpoch = 0.0;
+    if (m_StorageMode == ParticleStorageMode::BirthRing)
+        m_Particles.Resize(m_MaxParticles);
+    else if (m_StorageMode == ParticleStorageMode::Pool)
+        ResetPool();
+    m_EmitterTable.ResetState();
+
+    // 旧的粒子已不存在
+    m_Bounds.Reset();
+    RefreshBounds(false);
+}
+
+void ParticleSimCPU::SetStorageMode(ParticleStorageMode mode)
+{
+    const bool uniformLifetime = m_pKernels->uniformLifetime;
+    if ((mode == ParticleStorageMode::BirthRing && (!uniformLifetime || m_EmitterTable.GetCount() > 0)) ||
+        (mode == ParticleStorageMode::Pool && uniformLifetime))
+        mode = ParticleStorageMode::Compact;
+    if (mode == m_StorageMode)
+        return;
+
+    // 经由顶点数据转换，保留现有粒子
+    std::vector<ParticleVertex> vertices(GetVertexCount());
+    ExportVertices(vertices.data(), static_cast<uint32_t>(vertices.size()));
+    m_StorageMode = mode;
+    SetVertices(vertices.data(), static_cast<uint32_t>(vertices.size()));
+}
+
+uint32_t ParticleSimCPU::GetParticleCount() const
+{
+    switch (m_StorageMode)
+    {
+    case ParticleStorageMode::BirthRing: return m_RingCount;
+    case ParticleStorageMode::Pool: return m_MaxParticles - static_cast<uint32_t>(m_FreeSlots.size());
+    default: return m_Particles.GetSize();
+    }
+}
+
+void ParticleSimCPU::Update(float dt, float gameTime, JobSystem* jobs)
+{
+    m_GameTime = gameTime;
+    m_TimeStep = dt;
+    m_Age += dt;
+    ++m_FrameIndex;
+    m_SurvivorSourceCount = 0;
+    m_Bounds.Advance(dt);
+    m_ExternalParticles = false;
+    // 发射器表在上一帧之后有改动，新的粒子发射之前更新包围盒
+    if (m_EmitterTable.GetVersion() != m_BoundsTableVersion)
+        RefreshBounds(false);
+
+    if (m_StorageMode == ParticleStorageMode::BirthRing)
+    {
+        UpdateBirthRing();
+        return;
+    }
+    if (m_StorageMode == ParticleStorageMode::Pool)
+    {
+        UpdatePool();
+        return;
+    }
+
+    const uint32_t count = m_Particles.GetSize();
+    const uint32_t chunkCount = (count + ChunkSize - 1) / ChunkSize;
+    m_SurvivorSourceCount = count;
+    auto parallelForChunks = [=](auto&& func) {
+        auto range = [&](uint32_t begin, uint32_t end) {
+            for (uint32_t c = begin; c < end; ++c)
+                func(c, c * ChunkSize, std::min(count, (c + 1) * ChunkSize));
+        };
+        if (jobs)
+            jobs->ParallelFor(chunkCount, 1, range);
+        else
+            range(0, chunkCount);
+    };
+
+    // 各块独立更新存活时间、生成存活标记并产生新粒子
+    parallelForChunks([this](uint32_t c, uint32_t begin, uint32_t end) {
+        UpdateChunk(c, begin, end);
+    });
+
+    // 子发射器的事件按块的顺序换算为新粒子，排在该块其余新粒子之后
+    // 预算与随机数按事件的全局顺序分配，结果与线程数无关
+    if (!m_SubEmitters.empty())
+    {
+        BeginEventConsolidation();
+        for (uint32_t c = 0; c < chunkCount; ++c)
+            ConsolidateEvents(m_ChunkEvents[c], m_ChunkSpawned[c]);
+    }
+
+    // 流输出中发射器位于所有粒子之后，它产生的粒子也排在最后
+    UpdateEmitters();
+
+    // 对块的存活数与新粒子数求前缀和，得到各块的写入位置
+    // 按块的顺序排列，结果与线程数无关
+    uint32_t aliveTotal = 0;
+    for (uint32_t c = 0; c < chunkCount; ++c)
+    {
+        m_Chunks[c].aliveOffset = aliveTotal;
+        aliveTotal += m_Chunks[c].aliveCount;
+    }
+    uint32_t spawnTotal = aliveTotal;
+    for (uint32_t c = 0; c < chunkCount; ++c)
+    {
+        m_Chunks[c].spawnOffset = spawnTotal;
+        spawnTotal += static_cast<uint32_t>(m_ChunkSpawned[c].size()) + CountSpawnRequests(m_ChunkRequests[c]);
+    }
+    const uint32_t emitterOffset = spawnTotal;
+    spawnTotal += static_cast<uint32_t>(m_EmitterSpawned.size()) + CountSpawnRequests(m_EmitterRequests);
+    const uint32_t batchOffset = spawnTotal;
+    spawnTotal += m_EmitBatchCount;
+    const uint32_t tableOffset = spawnTotal;
+    spawnTotal += m_TableBatchCount;
+
+    // 按块汇总各类型的增量：减去消亡的粒子，加上容量以内实际写入的新粒子
+    uint32_t room = m_MaxParticles - std::min(aliveTotal, m_MaxParticles);
+    auto addSpawned = [this, &room](const std::vector<ParticleVertex>& spawned) {
+        for (uint32_t k = 0; k < spawned.size() && room > 0; ++k, --room)
+            ++m_TypeCounts[spawned[k].type & 3];
+    };
+    auto addRequests = [this, &room](const std::vector<SpawnRequest>& requests) {
+        for (const SpawnRequest& request : requests)
+        {
+            uint32_t kept = std::min(request.count, room);
+            m_TypeCounts[request.type & 3] += kept;
+            room -= kept;
+        }
+    };
+    for (uint32_t c = 0; c < chunkCount; ++c)
+    {
+        for (int t = 0; t < 4; ++t)
+            m_TypeCounts[t] -= m_Chunks[c].diedCounts[t];
+        addSpawned(m_ChunkSpawned[c]);
+        addRequests(m_ChunkRequests[c]);
+    }
+    addSpawned(m_EmitterSpawned);
+    addRequests(m_EmitterRequests);
+    for (uint32_t batch : { m_EmitBatchCount, m_TableBatchCount })
+    {
+        uint32_t kept = std::min(batch, room);
+        m_TypeCounts[PT_PARTICLE] += kept;
+        room -= kept;
+    }
+
+    // 没有粒子消亡时存活粒子不需要移动，直接在原存储后追加
+    const bool inPlace = aliveTotal == count;
+    ParticleStorage& target = inPlace ? m_Particles : m_Scratch;
+    target.Resize(std::min(spawnTotal, m_MaxParticles));
+
+    parallelForChunks([this, inPlace, &target](uint32_t c, uint32_t begin, uint32_t end) {
+        if (inPlace)
+        {
+            StoreSpawned(m_ChunkSpawned[c], m_Chunks[c].spawnOffset, target);
+            FillSpawnRequests(m_ChunkRequests[c], m_Chunks[c].spawnOffset + static_cast<uint32_t>(m_ChunkSpawned[c].size()), target);
+        }
+        else
+        {
+            ScatterChunk(c, begin, end, target);
+        }
+    });
+    StoreSpawned(m_EmitterSpawned, emitterOffset, target);
+    FillSpawnRequests(m_EmitterRequests, emitterOffset + static_cast<uint32_t>(m_EmitterSpawned.size()), target);
+    if (batchOffset < target.GetSize())
+        m_pKernels->emitBatch(*this, target, batchOffset, 0, std::min(m_EmitBatchCount, target.GetSize() - batchOffset));
+    if (tableOffset < target.GetSize())
+        m_pKernels->emitTable(*this, target, tableOffset, 0, std::min(m_TableBatchCount, target.GetSize() - tableOffset));
+
+    if (!inPlace)
+        std::swap(m_Particles, m_Scratch);
+}
+
+void ParticleSimCPU::UpdateSystems(ParticleSimCPU* const* systems, uint32_t systemCount,
+    float dt, float gameTime, JobSystem& jobs)
+{
+    jobs.ParallelFor(systemCount, 1, [=, &jobs](uint32_t begin, uint32_t end) {
+        for (uint32_t i = begin; i < end; ++i)
+            systems[i]->Update(dt, gameTime, &jobs);
+    });
+}
+
+void ParticleSimCPU::SeekTo(float time, float dt, JobSystem* jobs)
+{
+    Reset();
+    if (!(dt > 0.0f) || !(time > 0.0f))
+        return;
+    const double frameCount = std::floor(static_cast<double>(time) / dt + 0.5);
+    const uint32_t target = frameCount < static_cast<double>(UINT32_MAX) ? static_cast<uint32_t>(frameCount) : UINT32_MAX;
+
+    // 在目标时刻存活的粒子及其祖先都出生于这段窗口内，此前的帧只影响发射器的状态
+    const bool analytic = m_pKernels->uniformLifetime && m_SubEmitters.empty();
+    float window = GetLifetime(PT_PARTICLE);
+    if (!analytic)
+    {
+        const ParticleSystemBounds chain = m_pKernels->bounds(m_Params, m_Emitter.initialPos, &m_EmitterTable, m_SubEmitters, nullptr);
+        window = chain.maxAge + static_cast<float>(chain.trailingFrames) * dt;
+    }
+    const double windowFrames = window < FLT_MAX ? std::ceil(window / dt) + 2.0 : static_cast<double>(target);
+    const uint32_t start = windowFrames < target ? target - static_cast<uint32_t>(windowFrames) : 0;
+
+    SkipFrames(start, dt);
+    if (analytic)
+    {
+        EmitWindow(target - start);
+        return;
+    }
+    for (uint32_t f = start; f < target; ++f)
+        Update(dt, static_cast<float>(static_cast<double>(f + 1) * dt), jobs);
+}
+
+void ParticleSimCPU::Prewarm(float seconds, float dt, JobSystem* jobs)
+{
+    SeekTo(m_Age + seconds, dt, jobs);
+}
+
+void ParticleSimCPU::SkipFrames(uint32_t frames, float dt)
+{
+    const double elapsed = static_cast<double>(frames) * dt;
+    m_TimeStep = dt;
+    m_FrameIndex = frames;
+    m_Age = static_cast<float>(elapsed);
+    m_GameTime = m_Age;
+    // Compact模式不使用时钟；其余模式此时没有粒子，出生时间从新的起点算起
+    if (m_StorageMode != ParticleStorageMode::Compact)
+    {
+        m_Clock = elapsed;
+        m_ClockEpoch = m_Clock;
+        if (m_StorageMode == ParticleStorageMode::Pool)
+            ResetPool();
+    }
+    m_pKernels->skipEmitters(*this, frames);
+}
+
+float ParticleSimCPU::GetSkippedEmitterAge(uint64_t frames, float interval) const
+{
+    const float dt = m_TimeStep;
+    if (m_EmissionMode == EmissionMode::Accumulated)
+    {
+        const double elapsed = static_cast<double>(frames) * dt;
+        return static_cast<float>(interval > 0.0f ? std::fmod(elapsed, static_cast<double>(interval)) : elapsed);
+    }
+
+    // 发射后归零，累加到超过发射间隔的那一帧发射，周期为period帧
+    constexpr uint32_t MaxExactPeriod = 1u << 20;
+    float age = 0.0f;
+    uint32_t period = 0;
+    do
+    {
+        age += dt;
+        ++period;
+    } while (age <= interval && period < MaxExactPeriod);
+    if (period == MaxExactPeriod)
+        return static_cast<float>(static_cast<double>(frames) * dt);
+
+    age = 0.0f;
+    for (uint64_t f = frames % period; f > 0; --f)
+        age += dt;
+    return age;
+}
+
+void ParticleSimCPU::EmitWindow(uint32_t frames)
+{
+    const float dt = m_TimeStep;
+    const float lifetime = GetLifetime(PT_PARTICLE);
+    const bool ring = m_StorageMode == ParticleStorageMode::BirthRing;
+
+    // 经过n帧后的存活时间：出生时为0的粒子(PerFrame模式)与逐帧累加的结果完全相同
+    std::vector<float> elapsed(frames + 1, 0.0f);
+    for (uint32_t n = 1; n <= frames; ++n)
+        elapsed[n] = elapsed[n - 1] + dt;
+    auto ageAfter = [&](float age, uint32_t n) {
+        return age == 0.0f ? elapsed[n] : age + static_cast<float>(n) * dt;
+    };
+
+    // 新粒子按出生先后暂存在m_Scratch，births为各粒子出生的帧，head之前的已消亡
+    m_Scratch.Clear();
+    std::vector<uint32_t> births;
+    uint32_t head = 0;
+    for (uint32_t f = 1; f <= frames; ++f)
+    {
+        ++m_FrameIndex;
+        m_Age += dt;
+        m_GameTime = m_Age;
+        if (ring)
+            m_Clock += dt;
+
+        // 与逐帧推进相同，容量已满时丢弃新粒子
+        const float* ages = m_Scratch.GetAges();
+        while (head < m_Scratch.GetSize() && ageAfter(ages[head], f - births[head]) > lifetime)
+            ++head;
+        UpdateEmitters();
+        uint32_t room = m_MaxParticles - (m_Scratch.GetSize() - head);
+        const uint32_t spawned = std::min(static_cast<uint32_t>(m_EmitterSpawned.size()), room);
+        room -= spawned;
+        const uint32_t batch = std::min(m_EmitBatchCount, room);
+        room -= batch;
+        const uint32_t tabled = std::min(m_TableBatchCount, room);
+        const uint32_t added = spawned + batch + tabled;
+        if (added == 0)
+            continue;
+
+        // 暂存区放不下时丢弃已消亡的部分
+        if (m_Scratch.GetSize() + added > m_Scratch.GetCapacity())
+        {
+            const uint32_t live = m_Scratch.GetSize() - head;
+            m_Particles.Resize(live);
+            m_Particles.CopyRange(0, m_Scratch, head, live);
+            std::swap(m_Particles, m_Scratch);
+            births.erase(births.begin(), births.begin() + head);
+            head = 0;
+        }
+        const uint32_t offset = m_Scratch.GetSize();
+        m_Scratch.Resize(offset + added);
+        StoreSpawned(m_EmitterSpawned, offset, m_Scratch);
+        if (batch > 0)
+            m_pKernels->emitBatch(*this, m_Scratch, offset + spawned, 0, batch);
+        if (tabled > 0)
+            m_pKernels->emitTable(*this, m_Scratch, offset + spawned + batch, 0, tabled);
+        births.resize(offset + added, f);
+    }
+
+    // 换算为最后一帧的存活时间，BirthRing存放出生时间
+    const float now = GetClockNow();
+    m_Particles.Resize(ring ? m_MaxParticles : m_Scratch.GetSize() - head);
+    uint32_t count = 0;
+    for (uint32_t i = head; i < m_Scratch.GetSize(); ++i)
+    {
+        const float age = ageAfter(m_Scratch.GetAges()[i], frames - births[i]);
+        if (births[i] < frames && age > lifetime)
+            continue;
+        m_Particles.CopyFrom(count, m_Scratch, i);
+        m_Particles.GetAges()[count] = ring ? now - age : age;
+        ++count;
+    }
+    m_Scratch.Clear();
+    if (ring)
+    {
+        m_RingHead = 0;
+        m_RingCount = count;
+    }
+    else
+    {
+        m_Particles.Resize(count);
+        RecountTypes();
+    }
+}
+
+uint64_t ParticleSimCPU::ComputeStateHash(JobSystem* jobs) const
+{
+    // 标量状态与发射器
+    ParticleStateHasher header;
+    header.AddValue(m_Random.GetSeed());
+    header.AddValue(m_FrameIndex);
+    header.AddValue(m_Age);
+    header.AddValue(m_Clock);
+    header.AddValue(m_ClockEpoch);
+    header.AddValue(static_cast<uint32_t>(m_StorageMode));
+    header.AddValue(m_TypeCounts);
+    header.AddValue(m_RingHead);
+    header.AddValue(m_RingCount);
+    header.AddValue(static_cast<uint32_t>(m_HasEmitter));
+    if (m_HasEmitter)
+        header.AddValue(m_Emitter);
+
+    // 发射器表的启用顺序决定同一帧内各段的先后
+    const uint32_t emitterCount = m_EmitterTable.GetCount();
+    const std::vector<uint32_t>& enabled = m_EmitterTable.GetEnabledList();
+    header.AddValue(emitterCount);
+    header.Add(enabled.data(), enabled.size() * sizeof(uint32_t));
+    header.Add(m_EmitterTable.GetAges(), emitterCount * sizeof(float));
+    header.Add(m_EmitterTable.GetEmitCounts(), emitterCount * sizeof(uint32_t));
+    header.Add(m_EmitterTable.GetCatchUp(), emitterCount * sizeof(float));
+    // 空闲槽位栈决定之后的粒子写入哪个槽位
+    if (m_StorageMode == ParticleStorageMode::Pool)
+        header.Add(m_FreeSlots.data(), m_FreeSlots.size() * sizeof(uint32_t));
+
+    // 粒子按逻辑顺序分块，BirthRing环绕处与Pool的空闲槽位把块分为若干段，逐段按通道散列
+    const bool pool = m_StorageMode == ParticleStorageMode::Pool;
+    const bool ring = m_StorageMode == ParticleStorageMode::BirthRing;
+    const uint32_t count = pool ? m_MaxParticles : GetParticleCount();
+    const uint32_t chunkCount = (count + ChunkSize - 1) / ChunkSize;
+    std::vector<uint64_t> chunkHashes(chunkCount);
+    auto hashRun = [this](ParticleStateHasher& hasher, uint32_t first, uint32_t runCount) {
+        for (uint32_t c = 0; c < ParticleStorage::FloatChannelCount; ++c)
+            hasher.Add(m_Particles.GetChannel(static_cast<ParticleChannel>(c)) + first, runCount * sizeof(float));
+        hasher.Add(m_Particles.GetTypes() + first, runCount);
+        hasher.Add(m_Particles.GetEmitCounts() + first, runCount * sizeof(uint32_t));
+    };
+    auto hashChunk = [&](uint32_t chunk) {
+        ParticleStateHasher hasher(chunk);
+        const uint32_t begin = chunk * ChunkSize;
+        const uint32_t end = std::min(count, begin + ChunkSize);
+        if (ring)
+        {
+            const uint32_t first = (m_RingHead + begin) % m_MaxParticles;
+            const uint32_t head = std::min(end - begin, m_MaxParticles - first);
+            hashRun(hasher, first, head);
+            hashRun(hasher, 0, end - begin - head);
+        }
+        else if (pool)
+        {
+            const uint8_t* types = m_Particles.GetTypes();
+            uint32_t slot = begin;
+            while (slot < end)
+            {
+                uint32_t runEnd = slot;
+                while (runEnd < end && types[runEnd] != PoolFreeSlot)
+                    ++runEnd;
+                // 空闲槽位只记录位置，其余通道的内容无意义
+                hasher.AddValue(slot);
+                hashRun(hasher, slot, runEnd - slot);
+                slot = runEnd;
+                while (slot < end && types[slot] == PoolFreeSlot)
+                    ++slot;
+            }
+        }
+        else
+        {
+            hashRun(hasher, begin, end - begin);
+        }
+        chunkHashes[chunk] = hasher.Get();
+    };
+    if (jobs)
+    {
+        jobs->ParallelFor(chunkCount, 1, [&](uint32_t begin, uint32_t end) {
+            for (uint32_t c = begin; c < end; ++c)
+                hashChunk(c);
+        });
+    }
+    else
+    {
+        for (uint32_t c = 0; c < chunkCount; ++c)
+            hashChunk(c);
+    }
+
+    uint64_t hash = header.Get();
+    for (uint64_t chunkHash : chunkHashes)
+        hash = ParticleStateHasher::Combine(hash, chunkHash);
+    return hash;
+}
+
+void ParticleSimCPU::SetVertices(const ParticleVertex* vertices, uint32_t count)
+{
+    m_HasEmitter = false;
+    m_Particles.Clear();
+    m_SurvivorSourceCount = 0;
+    std::vector<ParticleVertex> particles;
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        if (vertices[i].type == PT_EMITTER)
+        {
+            m_Emitter = vertices[i];
+            m_HasEmitter = true;
+        }
+        else if (m_StorageMode != ParticleStorageMode::Compact)
+        {
+            particles.push_back(vertices[i]);
+        }
+        else
+        {
+            m_Particles.Append(vertices[i]);
+        }
+    }
+
+    if (m_StorageMode == ParticleStorageMode::BirthRing)
+    {
+        // 环内需按出生先后排列，即存活时间从大到小
+        std::stable_sort(particles.begin(), particles.end(), [](const ParticleVertex& a, const ParticleVertex& b) {
+            return a.age > b.age;
+        });
+        m_Particles.Resize(m_MaxParticles);
+        m_RingHead = 0;
+        m_RingCount = 0;
+        for (const ParticleVertex& p : particles)
+            PushRing(p);
+    }
+    else if (m_StorageMode == ParticleStorageMode::Pool)
+    {
+        ResetPool();
+        for (const ParticleVertex& p : particles)
+            PushPool(p);
+    }
+    else
+    {
+        RecountTypes();
+    }
+
+    // 导入的粒子不一定来自当前参数
+    RefreshBounds(true);
+}
+
+ParticleBounds ParticleSimCPU::GetBounds() const
+{
+    if (GetVertexCount() == 0 && m_EmitterTable.GetPositionBounds().IsEmpty())
+        return {};
+    return m_Bounds.GetBounds();
+}
+
+void ParticleSimCPU::RefreshBounds(bool affectsLive)
+{
+    if (!m_pKernels)
+        return;
+    m_BoundsTableVersion = m_EmitterTable.GetVersion();
+    const ParticleSystemBounds bounds = m_pKernels->bounds(m_Params, m_Emitter.initialPos, &m_EmitterTable, m_SubEmitters, nullptr);
+    if (!affectsLive)
+    {
+        m_Bounds.SetBounds(bounds);
+        return;
+    }
+    if (m_ExternalParticles)
+    {
+        ParticleSystemBounds unknown = bounds;
+        unknown.bounds = ParticleBounds::Infinite();
+        m_Bounds.SetBounds(bounds, unknown);
+        return;
+    }
+
+    // 逐个统计现有粒子出生参数的范围，按当前参数求出它们及其后代的包围盒，只在参数改变时执行
+    ParticleSpawnRange live[4] = {
+        ParticleSpawnRange::Empty(PT_EMITTER), ParticleSpawnRange::Empty(PT_PARTICLE),
+        ParticleSpawnRange::Empty(PT_SHELL), ParticleSpawnRange::Empty(PT_SMOKE),
+    };
+    const uint32_t count = GetParticleCount();
+    const uint8_t* types = m_Particles.GetTypes();
+    for (uint32_t i = 0, visited = 0; visited < count; ++i)
+    {
+        uint32_t index = i;
+        if (m_StorageMode == ParticleStorageMode::BirthRing)
+            index = (m_RingHead + i) % m_MaxParticles;
+        else if (m_StorageMode == ParticleStorageMode::Pool && types[i] == PoolFreeSlot)
+            continue;
+        ++visited;
+        live[types[index] & 3].Merge(m_Particles.Load(index));
+    }
+    m_Bounds.SetBounds(bounds, count > 0 ?
+        m_pKernels->bounds(m_Params, m_Emitter.initialPos, &m_EmitterTable, m_SubEmitters, live) : ParticleSystemBounds());
+}
+
+uint32_t ParticleSimCPU::ExportVertices(ParticleVertex* vertices, uint32_t maxCount) const
+{
+    uint32_t count = std::min(GetParticleCount(), maxCount);
+    const ParticleAgeMapping ages = GetRenderAges();
+    if (m_StorageMode == ParticleStorageMode::Pool)
+    {
+        // 跳过空闲槽位
+        const uint8_t* types = m_Particles.GetTypes();
+        uint32_t written = 0;
+        for (uint32_t slot = 0; slot < m_MaxParticles && written < count; ++slot)
+        {
+            if (types[slot] == PoolFreeSlot)
+                continue;
+            vertices[written] = m_Particles.Load(slot);
+            vertices[written].age = ages.offset - vertices[written].age;
+            ++written;
+        }
+    }
+    else if (m_StorageMode == ParticleStorageMode::BirthRing)
+    {
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            vertices[i] = m_Particles.Load((m_RingHead + i) % m_MaxParticles);
+            vertices[i].age = ages.offset - vertices[i].age;
+        }
+    }
+    else
+    {
+        m_Particles.Export(vertices, 0, count);
+        if (m_RenderLag > 0.0f)
+        {
+            for (uint32_t i = 0; i < count; ++i)
+                vertices[i].age -= m_RenderLag;
+        }
+    }
+    if (m_HasEmitter && count < maxCount)
+        vertices[count++] = m_Emitter;
+    return count;
+}
+
+void ParticleSimCPU::ExportVertices(const uint32_t* indices, uint32_t count, ParticleVertex* vertices) const
+{
+    const ParticleAgeMapping ages = GetRenderAges();
+    if (m_StorageMode == ParticleStorageMode::Compact)
+    {
+        for (uint32_t k = 0; k < count; ++k)
+        {
+            vertices[k] = m_Particles.Load(indices[k]);
+            vertices[k].age += ages.offset;
+        }
+        return;
+    }
+
+    // 其余模式下Age通道为出生时刻
+    const bool ring = m_StorageMode == ParticleStorageMode::BirthRing;
+    for (uint32_t k = 0; k < count; ++k)
+    {
+        vertices[k] = m_Particles.Load(ring ? (m_RingHead + indices[k]) % m_MaxParticles : indices[k]);
+        vertices[k].age = ages.offset - vertices[k].age;
+    }
+}
+
+uint32_t ParticleSimCPU::ExportPacked(PackedParticle* particles, uint32_t maxCount) const
+{
+    const PackedParticleConstants constants = GetPackedConstants();
+    uint32_t count = std::min(GetParticleCount(), maxCount);
+    const ParticleAgeMapping ages = GetRenderAges();
+    if (m_StorageMode == ParticleStorageMode::Pool)
+    {
+        // 连续的存活槽位整段打包，跳过空闲槽位
+        const uint8_t* types = m_Particles.GetTypes();
+        uint32_t written = 0;
+        uint32_t slot = 0;
+        while (slot < m_MaxParticles && written < count)
+        {
+            if (types[slot] == PoolFreeSlot)
+            {
+                ++slot;
+                continue;
+            }
+            uint32_t end = slot + 1;
+            while (end < m_MaxParticles && end - slot < count - written && types[end] != PoolFreeSlot)
+                ++end;
+            PackParticles(m_Particles, slot, end - slot, constants, particles + written, ages);
+            written += end - slot;
+            slot = end;
+        }
+    }
+    else if (m_StorageMode == ParticleStorageMode::BirthRing)
+    {
+        // 环绕处分为两段
+        uint32_t first = std::min(count, m_MaxParticles - m_RingHead);
+        PackParticles(m_Particles, m_RingHead, first, constants, particles, ages);
+        PackParticles(m_Particles, 0, count - first, constants, particles + first, ages);
+    }
+    else
+    {
+        PackParticles(m_Particles, 0, count, constants, particles, ages);
+    }
+    if (m_HasEmitter && count < maxCount)
+        particles[count++] = PackParticle(m_Emitter, constants);
+    return count;
+}
+
+PackedParticleConstants ParticleSimCPU::GetPackedConstants() const
+{
+    float lifetimeMax = m_Params.emitInterval;
+    for (uint32_t type : { PT_PARTICLE, PT_SHELL, PT_SMOKE })
+    {
+        float lifetime = GetLifetime(type);
+        if (lifetime < FLT_MAX)
+            lifetimeMax = std::max(lifetimeMax, lifetime);
+    }
+    // Boom的壳以[-emitInterval, emitInterval]的存活时间延迟发射，绘制滞后时最新的粒子也为负
+    const float ageMin = -(std::max(m_Params.emitInterval, 0.0f) + m_RenderLag);
+    return PackedParticleConstants::FromAgeRange(ageMin, lifetimeMax > 0.0f ? 2.0f * lifetimeMax : 1.0f);
+}
+
+ParticleAppearanceTable ParticleSimCPU::GetAppearance() const
+{
+    return m_pKernels->appearance(m_Params);
+}
+
+void ParticleSimCPU::Evaluate(ParticleEvalBuffer& buffer) const
+{
+    if (buffer.GetCapacity() < m_MaxParticles)
+        buffer.Reserve(m_MaxParticles);
+    const ParticleAgeMapping ages = GetRenderAges();
+    if (m_StorageMode == ParticleStorageMode::Compact)
+    {
+        EvaluateParticles(m_Particles, 0, m_Particles.GetSize(), GetAppearance(), buffer.GetOutput(), ages);
+        return;
+    }
+    if (m_StorageMode == ParticleStorageMode::Pool)
+    {
+        EvaluateParticles(m_Particles, 0, m_MaxParticles, GetAppearance(), buffer.GetOutput(), ages);
+        return;
+    }
+
+    // 存活时间在此时才由出生时间算出，环绕处分为两段
+    const ParticleAppearanceTable appearance = GetAppearance();
+    ParticleEvalOutput output = buffer.GetOutput();
+    uint32_t first = std::min(m_RingCount, m_MaxParticles - m_RingHead);
+    EvaluateParticles(m_Particles, m_RingHead, first, appearance, output, ages);
+    for (float** channel : { &output.posX, &output.posY, &output.posZ, &output.opacity, &output.halfWidth, &output.halfHeight })
+        *channel += first;
+    EvaluateParticles(m_Particles, 0, m_RingCount - first, appearance, output, ages);
+}
+
+std::pair<uint32_t, uint32_t> ParticleSimCPU::CountParticles() const
+{
+    // 环中只有PT_PARTICLE
+    if (m_StorageMode == ParticleStorageMode::BirthRing)
+        return { m_RingCount, 0 };
+    return { m_TypeCounts[PT_PARTICLE], m_TypeCounts[PT_SMOKE] };
+}
+
+void ParticleSimCPU::RecountTypes()
+{
+    std::fill(std::begin(m_TypeCounts), std::end(m_TypeCounts), 0u);
+    const uint8_t* types = m_Particles.GetTypes();
+    const uint32_t count = m_Particles.GetSize();
+    for (uint32_t i = 0; i < count; ++i)
+        ++m_TypeCounts[types[i] & 3];
+}
+
+Float3 ParticleSimCPU::RandVec3(uint32_t id, RandomStream stream, uint32_t index) const
+{
+    return m_Random.UniformVec3(id, m_FrameIndex, stream, index);
+}
+
+Float3 ParticleSimCPU::RandUnitVec3(uint32_t id, RandomStream stream, uint32_t index) const
+{
+    return Normalize(RandVec3(id, stream, index));
+}
+
+void ParticleSimCPU::ScatterChunk(uint32_t chunkIndex, uint32_t begin, uint32_t end, ParticleStorage& target)
+{
+    // 连续存活的一段粒子整段复制
+    uint32_t dst = m_Chunks[chunkIndex].aliveOffset;
+    uint32_t i = begin;
+    while (i < end)
+    {
+        while (i < end && !m_Alive[i])
+            ++i;
+        uint32_t runBegin = i;
+        while (i < end && m_Alive[i])
+            ++i;
+        if (i > runBegin)
+        {
+            target.CopyRange(dst, m_Particles, runBegin, i - runBegin);
+            dst += i - runBegin;
+        }
+    }
+
+    StoreSpawned(m_ChunkSpawned[chunkIndex], m_Chunks[chunkIndex].spawnOffset, target);
+    FillSpawnRequests(m_ChunkRequests[chunkIndex],
+        m_Chunks[chunkIndex].spawnOffset + static_cast<uint32_t>(m_ChunkSpawned[chunkIndex].size()), target);
+}
+
+void ParticleSimCPU::StoreSpawned(const std::vector<ParticleVertex>& spawned, uint32_t offset, ParticleStorage& target)
+{
+    const uint32_t size = target.GetSize();
+    for (uint32_t k = 0; k < spawned.size() && offset + k < size; ++k)
+        target.Store(offset + k, spawned[k]);
+}
+
+uint32_t ParticleSimCPU::CountSpawnRequests(const std::vector<SpawnRequest>& requests)
+{
+    uint32_t count = 0;
+    for (const SpawnRequest& request : requests)
+        count += request.count;
+    return count;
+}
+
+uint32_t ParticleSimCPU::FillSpawnRequests(const std::vector<SpawnRequest>& requests, uint32_t offset, ParticleStorage& target) const
+{
+    const uint32_t size = offset < target.GetSize() ? target.GetSize() - offset : 0;
+    float* posX = target.GetChannel(ParticleChannel::PosX) + offset;
+    float* posY = target.GetChannel(ParticleChannel::PosY) + offset;
+    float* posZ = target.GetChannel(ParticleChannel::PosZ) + offset;
+    float* velX = target.GetChannel(ParticleChannel::VelX) + offset;
+    float* velY = target.GetChannel(ParticleChannel::VelY) + offset;
+    float* velZ = target.GetChannel(ParticleChannel::VelZ) + offset;
+    float* accelX = target.GetChannel(ParticleChannel::AccelX) + offset;
+    float* accelY = target.GetChannel(ParticleChannel::AccelY) + offset;
+    float* accelZ = target.GetChannel(ParticleChannel::AccelZ) + offset;
+    float* ages = target.GetAges() + offset;
+    uint8_t* types = target.GetTypes() + offset;
+
+    // 第一遍按请求生成随机数并写入各请求独有的数据
+    // 壳的存活时间只用到x分量，y、z暂存在速度通道中，随后整段清零
+    const float interval = m_Params.emitInterval;
+    uint32_t written = 0;
+    for (const SpawnRequest& request : requests)
+    {
+        if (written >= size)
+            break;
+        const uint32_t k = written;
+        const uint32_t count = std::min(request.count, size - k);
+        const float accelScale = request.type == PT_SHELL ? ShellSpawn::AccelScale : ShellBurstLife::AccelScale;
+        m_Random.UniformVec3Bulk(request.randomId, m_FrameIndex, RS_Accel, request.firstIndex, count,
+            accelX + k, accelY + k, accelZ + k);
+        if (request.type == PT_SHELL)
+        {
+            m_Random.UniformVec3Bulk(request.randomId, m_FrameIndex, RS_Age, request.firstIndex, count,
+                ages + k, velX + k, velY + k);
+            for (uint32_t j = k; j < k + count; ++j)
+                ages[j] *= interval;
+        }
+        else
+        {
+            std::fill_n(ages + k, count, 0.0f);
+        }
+        for (uint32_t j = k; j < k + count; ++j)
+        {
+            accelX[j] *= accelScale;
+            accelY[j] *= accelScale;
+            accelZ[j] *= accelScale;
+        }
+        std::fill_n(posX + k, count, request.origin.x);
+        std::fill_n(posY + k, count, request.origin.y);
+        std::fill_n(posZ + k, count, request.origin.z);
+        std::fill_n(types + k, count, request.type);
+        written += count;
+    }
+
+    // 所有请求相同的通道逐通道整段写入
+    std::fill_n(velX, written, 0.0f);
+    std::fill_n(velY, written, 0.0f);
+    std::fill_n(velZ, written, 0.0f);
+    std::fill_n(target.GetChannel(ParticleChannel::SizeX) + offset, written, 2.5f);
+    std::fill_n(target.GetChannel(ParticleChannel::SizeY) + offset, written, 2.5f);
+    std::fill_n(target.GetEmitCounts() + offset, written, 0u);
+    return written;
+}
+
+void ParticleSimCPU::UpdateChunk(uint32_t chunkIndex, uint32_t begin, uint32_t end)
+{
+    std::vector<ParticleVertex>& spawned = m_ChunkSpawned[chunkIndex];
+    std::vector<SpawnRequest>& requests = m_ChunkRequests[chunkIndex];
+    spawned.clear();
+    requests.clear();
+
+    // 热数据：每帧只有存活时间变化
+    AdvanceAges(m_Particles.GetAges() + begin, end - begin, m_TimeStep);
+
+    // 各特效的循环在编译期展开，块内不再按特效分支
+    m_pKernels->updateLifetimes(*this, begin, end, requests);
+
+    m_ChunkEvents[chunkIndex].clear();
+    if (!m_SubEmitters.empty())
+        RaiseChunkEvents(chunkIndex, begin, end);
+
+    // 存活数与按类型的消亡数在同一遍中统计
+    const uint8_t* types = m_Particles.GetTypes();
+    uint32_t aliveCount = 0;
+    uint32_t diedCounts[4] = {};
+    for (uint32_t i = begin; i < end; ++i)
+    {
+        aliveCount += m_Alive[i];
+        diedCounts[types[i] & 3] += m_Alive[i] ^ 1;
+    }
+    ChunkCompaction& chunk = m_Chunks[chunkIndex];
+    chunk.aliveCount = aliveCount;
+    std::copy(std::begin(diedCounts), std::end(diedCounts), chunk.diedCounts);
+}
+
+void ParticleSimCPU::UpdateEmitters()
+{
+    m_EmitterSpawned.clear();
+    m_EmitterRequests.clear();
+    m_EmitBatchCount = 0;
+    m_TableBatchCount = 0;
+    if (m_HasEmitter)
+        m_pKernels->updateEmitter(*this);
+    if (m_EmitterTable.GetCount() > 0)
+        m_pKernels->updateEmitterTable(*this);
+}
+
+void ParticleSimCPU::UpdateBirthRing()
+{
+    m_Clock += m_TimeStep;
+    float now = RebaseClock();
+
+    // 出生越早越先过期，只需从环尾开始检查
+    const float* births = m_Particles.GetAges();
+    const float aliveTime = m_Params.aliveTime;
+    while (m_RingCount > 0 && now - births[m_RingHead] > aliveTime)
+    {
+        m_RingHead = m_RingHead + 1 == m_MaxParticles ? 0 : m_RingHead + 1;
+        --m_RingCount;
+    }
+
+    UpdateEmitters();
+    for (const ParticleVertex& p : m_EmitterSpawned)
+        PushRing(p);
+
+    // 批量发射的粒子在环绕处分为两段写入，随后把存活时间换算为出生时间
+    uint32_t remaining = std::min(m_EmitBatchCount, m_MaxParticles - m_RingCount);
+    uint32_t first = 0;
+    while (remaining > 0)
+    {
+        uint32_t offset = (m_RingHead + m_RingCount) % m_MaxParticles;
+        uint32_t count = std::min(remaining, m_MaxParticles - offset);
+        m_pKernels->emitBatch(*this, m_Particles, offset, first, count);
+        float* ages = m_Particles.GetAges() + offset;
+        for (uint32_t k = 0; k < count; ++k)
+            ages[k] = now - ages[k];
+        m_RingCount += count;
+        first += count;
+        remaining -= count;
+    }
+}
+
+float ParticleSimCPU::RebaseClock()
+{
+    // 出生时间相对m_ClockEpoch存放
+    constexpr float RebaseTime = 1024.0f;
+    float now = GetClockNow();
+    if (now <= RebaseTime)
+        return now;
+
+    float* births = m_Particles.GetAges();
+    if (m_StorageMode == ParticleStorageMode::BirthRing)
+    {
+        for (uint32_t i = 0; i < m_RingCount; ++i)
+            births[(m_RingHead + i) % m_MaxParticles] -= now;
+    }
+    else
+    {
+        const uint8_t* types = m_Particles.GetTypes();
+        for (uint32_t slot = 0; slot < m_MaxParticles; ++slot)
+        {
+            if (types[slot] != PoolFreeSlot)
+                births[slot] -= now;
+        }
+    }
+    m_ClockEpoch = m_Clock;
+    return 0.0f;
+}
+
+void ParticleSimCPU::PushRing(const ParticleVertex& v)
+{
+    // 与流输出一样，缓冲区满时丢弃
+    if (m_RingCount >= m_MaxParticles)
+        return;
+    ParticleVertex p = v;
+    p.age = GetClockNow() - v.age;
+    m_Particles.Store((m_RingHead + m_RingCount) % m_MaxParticles, p);
+    ++m_RingCount;
+}
+
+void ParticleSimCPU::ResetPool()
+{
+    m_Particles.Resize(m_MaxParticles);
+    std::fill_n(m_Particles.GetTypes(), m_MaxParticles, PoolFreeSlot);
+
+    // 逆序压栈，先取出低位的槽位
+    m_FreeSlots.resize(m_MaxParticles);
+    for (uint32_t i = 0; i < m_MaxParticles; ++i)
+        m_FreeSlots[i] = m_MaxParticles - 1 - i;
+
+    std::fill(std::begin(m_TypeCounts), std::end(m_TypeCounts), 0u);
+    m_Wheel.Clear(static_cast<uint64_t>(m_Clock * PoolTickRate));
+}
+
+void ParticleSimCPU::UpdatePool()
+{
+    m_Clock += m_TimeStep;
+    const float now = RebaseClock();
+
+    // 只访问到期的槽位，其余粒子不读也不写
+    m_PoolSpawned.clear();
+    m_PoolRequests.clear();
+    m_PoolEvents.clear();
+    m_Wheel.Advance(static_cast<uint64_t>(m_Clock * PoolTickRate), [this, now](uint32_t slot) {
+        HandlePoolTimer(slot, now);
+    });
+
+    // 到期的槽位按时间轮的顺序产生事件，与Compact模式一样统一换算
+    if (!m_SubEmitters.empty())
+    {
+        BeginEventConsolidation();
+        ConsolidateEvents(m_PoolEvents, m_PoolSpawned);
+    }
+
+    UpdateEmitters();
+    for (const ParticleVertex& p : m_PoolSpawned)
+        PushPool(p);
+    for (const ParticleVertex& p : m_EmitterSpawned)
+        PushPool(p);
+
+    // 各级的请求先成批展开到临时存储，再逐个放入空闲槽位
+    for (const std::vector<SpawnRequest>* requests : { &m_PoolRequests, &m_EmitterRequests })
+    {
+        uint32_t count = std::min(CountSpawnRequests(*requests), static_cast<uint32_t>(m_FreeSlots.size()));
+        if (count == 0)
+            continue;
+        m_Scratch.Resize(count);
+        FillSpawnRequests(*requests, 0, m_Scratch);
+        for (uint32_t k = 0; k < count; ++k)
+            PushPool(m_Scratch.Load(k));
+    }
+    if (m_EmitBatchCount > 0)
+    {
+        uint32_t count = std::min(m_EmitBatchCount, static_cast<uint32_t>(m_FreeSlots.size()));
+        m_Scratch.Resize(count);
+        m_pKernels->emitBatch(*this, m_Scratch, 0, 0, count);
+        for (uint32_t k = 0; k < count; ++k)
+            PushPool(m_Scratch.Load(k));
+    }
+    if (m_TableBatchCount > 0)
+    {
+        uint32_t count = std::min(m_TableBatchCount, static_cast<uint32_t>(m_FreeSlots.size()));
+        m_Scratch.Resize(count);
+        m_pKernels->emitTable(*this, m_Scratch, 0, 0, count);
+        for (uint32_t k = 0; k < count; ++k)
+            PushPool(m_Scratch.Load(k));
+    }
+}
+
+void ParticleSimCPU::PushPool(const ParticleVertex& v)
+{
+    if (m_FreeSlots.empty())
+        return;
+    uint32_t slot = m_FreeSlots.back();
+    m_FreeSlots.pop_back();
+
+    ParticleVertex p = v;
+    p.age = GetClockNow() - v.age;
+    m_Particles.Store(slot, p);
+    ++m_TypeCounts[p.type & 3];
+
+    // 与Compact模式相同，只有之后才越过的触发时刻产生事件
+    uint8_t fired = 0;
+    for (uint32_t s = 0; s < m_SubEmitters.size(); ++s)
+    {
+        const SubEmitterDesc& desc = m_SubEmitters[s];
+        if (desc.trigger == ParticleEventType::AgeThreshold && desc.sourceType == p.type &&
+            v.age >= desc.ageFraction * GetLifetime(p.type))
+            fired |= 1u << s;
+    }
+    m_PoolFiredEvents[slot] = fired;
+    SchedulePoolTimer(slot);
+}
+
+void ParticleSimCPU::FreePoolSlot(uint32_t slot)
+{
+    uint8_t& type = m_Particles.GetTypes()[slot];
+    --m_TypeCounts[type & 3];
+    type = PoolFreeSlot;
+    m_FreeSlots.push_back(slot);
+}
+
+uint64_t ParticleSimCPU::GetDeadlineTick(float birth, float duration) const
+{
+    double tick = std::floor((m_ClockEpoch + birth + duration) * PoolTickRate) - 1.0;
+    return tick > 0.0 ? static_cast<uint64_t>(tick) : 0;
+}
+
+void ParticleSimCPU::SchedulePoolTimer(uint32_t slot)
+{
+    const float birth = m_Particles.GetAges()[slot];
+    const uint8_t type = m_Particles.GetTypes()[slot];
+
+    PoolTimer timer = PTM_Expire;
+    float duration = GetLifetime(type);
+    if (type == PT_SHELL)
+    {
+        timer = PTM_ShellBurst;
+        duration = m_Params.emitInterval;
+    }
+    else
+    {
+        // 尚未触发的AgeThreshold子发射器中最早的一个
+        const uint8_t fired = m_PoolFiredEvents[slot];
+        for (uint32_t s = 0; s < m_SubEmitters.size(); ++s)
+        {
+            const SubEmitterDesc& desc = m_SubEmitters[s];
+            if (desc.trigger != ParticleEventType::AgeThreshold || desc.sourceType != type || (fired >> s & 1))
+                continue;
+            float threshold = desc.ageFraction * GetLifetime(type);
+            if (threshold <= duration)
+            {
+                timer = PTM_AgeEvent;
+                duration = threshold;
+            }
+        }
+    }
+    m_PoolTimers[slot] = timer;
+    m_Wheel.Schedule(slot, GetDeadlineTick(birth, duration));
+}
+
+void ParticleSimCPU::HandlePoolTimer(uint32_t slot, float now)
+{
+    const float birth = m_Particles.GetAges()[slot];
+    const float age = now - birth;
+    const uint8_t type = m_Particles.GetTypes()[slot];
+    const uint64_t nextFrame = m_Wheel.GetCurrentTick() + 1;
+    uint32_t& emitCount = m_Particles.GetEmitCounts()[slot];
+
+    switch (m_PoolTimers[slot])
+    {
+    case PTM_Expire:
+    {
+        float lifetime = GetLifetime(type);
+        if (age > lifetime)
+        {
+            RaisePoolDeathEvents(slot, age);
+            FreePoolSlot(slot);
+        }
+        else
+        {
+            m_Wheel.Schedule(slot, GetDeadlineTick(birth, lifetime));
+        }
+        break;
+    }
+    case PTM_AgeEvent:
+    {
+        const float lifetime = GetLifetime(type);
+        if (age > lifetime)
+        {
+            RaisePoolDeathEvents(slot, age);
+            FreePoolSlot(slot);
+            break;
+        }
+
+        // 一帧内可能越过多个触发时刻，之后按剩余最早的一个重新安排
+        uint8_t& fired = m_PoolFiredEvents[slot];
+        for (uint32_t s = 0; s < m_SubEmitters.size(); ++s)
+        {
+            const SubEmitterDesc& desc = m_SubEmitters[s];
+            if (desc.trigger != ParticleEventType::AgeThreshold || desc.sourceType != type || (fired >> s & 1))
+                continue;
+            float threshold = desc.ageFraction * lifetime;
+            if (age >= threshold)
+            {
+                RaiseEvent(m_PoolEvents, s, m_Particles.Load(slot), threshold, age);
+                fired |= 1u << s;
+            }
+        }
+        SchedulePoolTimer(slot);
+        break;
+    }
+    case PTM_ShellBurst:
+    {
+        const float interval = m_Params.emitInterval;
+        if (age <= interval)
+        {
+            m_Wheel.Schedule(slot, GetDeadlineTick(birth, interval));
+            break;
+        }
+
+        // 与ShellBurstLife相同：每帧散开16个粒子，共发射超过128个后移除
+        ParticleVertex shell = m_Particles.Load(slot);
+        Float3 posW = 0.5f * interval * interval * shell.accel * m_Params.accel + interval * shell.initialVel + shell.initialPos;
+        m_PoolRequests.push_back({ posW, slot, 0, 16, PT_PARTICLE });
+        emitCount += 16;
+        if (emitCount > 128)
+        {
+            RaisePoolDeathEvents(slot, age);
+            FreePoolSlot(slot);
+        }
+        else
+        {
+            m_Wheel.Schedule(slot, nextFrame);
+        }
+        break;
+    }
+    }
+}
+
+void ParticleSimCPU::RaisePoolDeathEvents(uint32_t slot, float age)
+{
+    const uint8_t type = m_Particles.GetTypes()[slot];
+    for (uint32_t s = 0; s < m_SubEmitters.size(); ++s)
+    {
+        const SubEmitterDesc& desc = m_SubEmitters[s];
+        if (desc.trigger == ParticleEventType::Death && desc.sourceType == type)
+            RaiseEvent(m_PoolEvents, s, m_Particles.Load(slot), std::min(age, GetLifetime(type)), age);
+    }
+}
+
+void ParticleSimCPU::RebuildPoolTimers()
+{
+    m_Wheel.Clear(m_Wheel.GetCurrentTick());
+    const uint8_t* types = m_Particles.GetTypes();
+    for (uint32_t slot = 0; slot < m_MaxParticles; ++slot)
+    {
+        if (types[slot] != PoolFreeSlot)
+            SchedulePoolTimer(slot);
+    }
+}
+
+void ParticleSimCPU::UpdateEmitterAccumulated(bool paused)
+{
+    ParticleVertex& v = m_Emitter;
+    const float interval = m_Params.emitInterval;
+    v.age += m_TimeStep;
+
+    if (paused)
+    {
+        // 暂停期间不积攒发射量，恢复后不会一次性喷出
+        v.age = std::min(v.age, interval);
+        return;
+    }
+    if (interval <= 0.0f)
+        return;
+
+    // 超出容量的部分即使发射也会被丢弃
+    float due = std::floor(v.age / interval);
+    uint32_t count = due < static_cast<float>(m_MaxParticles) ? static_cast<uint32_t>(due) : m_MaxParticles;
+    m_EmitBatchCount = count;
+    m_EmitBatchAge = v.age;
+    v.age = std::max(v.age - static_cast<float>(count) * interval, 0.0f);
+    if (v.age >= interval)
+        v.age = std::fmod(v.age, interval);
+}
+
+void ParticleSimCPU::CountTableEmission(bool paused)
+{
+    m_TableEmitters.clear();
+    m_TableOffsets.clear();
+    m_TableBatchAges.clear();
+    m_TableBatchSpacings.clear();
+    const float* intervals = m_EmitterTable.GetIntervals();
+    float* ages = m_EmitterTable.GetAges();
+    float* catchUps = m_EmitterTable.GetCatchUp();
+    const bool accumulated = m_EmissionMode == EmissionMode::Accumulated;
+    // 补发的时间超过最长寿命时，更早出生的粒子已经消亡
+    float maxLifetime = 0.0f;
+    for (uint32_t type = PT_PARTICLE; type <= PT_SMOKE; ++type)
+    {
+        float lifetime = GetLifetime(type);
+        if (lifetime < FLT_MAX)
+            maxLifetime = std::max(maxLifetime, lifetime);
+    }
+
+    // 与UpdateEmitter/UpdateEmitterAccumulated中系统自身的发射器相同，只是逐个发射器处理，只记录发射的发射器
+    uint32_t total = 0;
+    for (uint32_t e : m_EmitterTable.GetEnabledList())
+    {
+        const float interval = intervals[e] > 0.0f ? intervals[e] : m_Params.emitInterval;
+        float spacing = interval;
+        float batchAge = 0.0f;
+        float& age = ages[e];
+        age += m_TimeStep;
+        // 有待补发的时间时本帧按Accumulated模式一次发射
+        const bool catchingUp = catchUps[e] > 0.0f;
+        if (catchingUp)
+        {
+            if (!paused)
+                age += std::min(catchUps[e], maxLifetime);
+            catchUps[e] = 0.0f;
+        }
+
+        uint32_t count = 0;
+        if (!accumulated && !catchingUp)
+        {
+            if (age <= interval || paused)
+                continue;
+            count = 1;
+            // 出生时的存活时间为0
+            batchAge = interval;
+            age = 0.0f;
+        }
+        else
+        {
+            if (paused)
+            {
+                age = std::min(age, interval);
+                continue;
+            }
+            // PerFrame模式下实际每隔整数帧发射一次，补发的粒子按该间隔排列
+            if (!accumulated && m_TimeStep > 0.0f)
+                spacing = m_TimeStep * (std::floor(interval / m_TimeStep) + 1.0f);
+            if (spacing <= 0.0f)
+                continue;
+            float due = std::floor(age / spacing);
+            count = due < static_cast<float>(m_MaxParticles) ? static_cast<uint32_t>(due) : m_MaxParticles;
+            batchAge = age;
+            age = std::max(age - static_cast<float>(count) * spacing, 0.0f);
+            if (age >= spacing)
+                age = std::fmod(age, spacing);
+        }
+        // 超出容量的部分即使发射也会被丢弃
+        count = std::min(count, m_MaxParticles - total);
+        if (count == 0)
+            continue;
+        m_TableEmitters.push_back(e);
+        m_TableOffsets.push_back(total);
+        m_TableBatchAges.push_back(batchAge);
+        m_TableBatchSpacings.push_back(spacing);
+        total += count;
+    }
+    m_TableOffsets.push_back(total);
+    m_TableBatchCount = total;
+}
+
+ParticleBounds ParticleSimCPU::GetEmitterExtent() const
+{
+    // 粒子出生于emitPos，壳出生于发射器顶点，两者都移到原点
+    ParticleSimParams params = m_Params;
+    params.emitPos = {};
+    return m_pKernels->bounds(params, {}, nullptr, m_SubEmitters, nullptr).bounds;
+}
+
+float ParticleSimCPU::GetLifetime(uint32_t type) const
+{
+    return m_pKernels->lifetime(type, m_Params);
+}
+
+void ParticleSimCPU::RaiseChunkEvents(uint32_t chunkIndex, uint32_t begin, uint32_t end)
+{
+    std::vector<ParticleEvent>& events = m_ChunkEvents[chunkIndex];
+    const ParticleAppearanceTable appearance = GetAppearance();
+    const float dt = m_TimeStep;
+    const float* ages = m_Particles.GetAges();
+    const uint8_t* types = m_Particles.GetTypes();
+
+    for (uint32_t s = 0; s < m_SubEmitters.size(); ++s)
+    {
+        const SubEmitterDesc& desc = m_SubEmitters[s];
+        const float lifetime = GetLifetime(desc.sourceType);
+        switch (desc.trigger)
+        {
+        case ParticleEventType::AgeThreshold:
+        {
+            // 只在越过触发时刻的那一帧触发，与帧率无关
+            const float threshold = desc.ageFraction * lifetime;
+            for (uint32_t i = begin; i < end; ++i)
+            {
+                if (types[i] == desc.sourceType && m_Alive[i] && ages[i] >= threshold && ages[i] - dt < threshold)
+                    RaiseEvent(events, s, m_Particles.Load(i), threshold, ages[i]);
+            }
+            break;
+        }
+        case ParticleEventType::Death:
+        {
+            for (uint32_t i = begin; i < end; ++i)
+            {
+                if (types[i] == desc.sourceType && !m_Alive[i])
+                    RaiseEvent(events, s, m_Particles.Load(i), std::min(ages[i], lifetime), ages[i]);
+            }
+            break;
+        }
+        case ParticleEventType::Collision:
+        {
+            // 比较本帧前后的高度，只读取y方向的通道
+            const ParticleAppearance& a = appearance.types[desc.sourceType & 3];
+            const float* posY = m_Particles.GetChannel(ParticleChannel::PosY);
+            const float* velY = m_Particles.GetChannel(ParticleChannel::VelY);
+            const float* accelY = m_Particles.GetChannel(ParticleChannel::AccelY);
+            auto height = [&](uint32_t i, float t) {
+                t = std::min(t, a.maxTime);
+                float ay = a.perParticleAccel ? a.accelScale.y * accelY[i] : a.accelScale.y;
+                return 0.5f * t * t * ay + t * velY[i] + posY[i];
+            };
+            for (uint32_t i = begin; i < end; ++i)
+            {
+                if (types[i] != desc.sourceType || !m_Alive[i])
+                    continue;
+                float prevAge = std::max(ages[i] - dt, 0.0f);
+                if (height(i, prevAge) > desc.planeY && height(i, ages[i]) <= desc.planeY)
+                    RaiseEvent(events, s, m_Particles.Load(i), ages[i], ages[i]);
+            }
+            break;
+        }
+        }
+    }
+}
+
+void ParticleSimCPU::RaiseEvent(std::vector<ParticleEvent>& events, uint32_t subEmitter,
+    const ParticleVertex& source, float eventAge, float age)
+{
+    ParticleEvent e;
+    e.source = source;
+    e.age = eventAge;
+    e.elapsed = age - eventAge;
+    e.subEmitter = subEmitter;
+    events.push_back(e);
+}
+
+void ParticleSimCPU::BeginEventConsolidation()
+{
+    std::fill(std::begin(m_SubEmitterSpawned), std::end(m_SubEmitterSpawned), 0u);
+    std::fill(std::begin(m_SubEmittedTypes), std::end(m_SubEmittedTypes), 0u);
+    m_FrameSubEmitted = 0;
+    m_EventOrdinal = 0;
+}
+
+void ParticleSimCPU::ConsolidateEvents(const std::vector<ParticleEvent>& events, std::vector<ParticleVertex>& spawned)
+{
+    if (events.empty())
+        return;
+
+    const ParticleAppearanceTable appearance = GetAppearance();
+    const float aliveTime = m_Params.aliveTime;
+    for (const ParticleEvent& e : events)
+    {
+        const SubEmitterDesc& desc = m_SubEmitters[e.subEmitter];
+        // 以事件的全局序号作为随机数的id，预算耗尽后仍然递增以保持后续事件的随机数不变
+        const uint32_t id = m_EventOrdinal++;
+        uint32_t bits[4];
+        m_Random.Generate(id, m_FrameIndex, RS_SubEmit, 0, bits);
+        if ((ParticleRandom::ToSignedUnit(bits[3]) + 1.0f) * 0.5f >= desc.chance)
+            continue;
+
+        // 依次受子发射器每帧的预算、系统每帧的预算与生成类型的存活总数限制
+        const uint32_t spawnType = desc.spawnType & 3;
+        uint32_t count = std::min(desc.spawnCount, desc.frameBudget - m_SubEmitterSpawned[e.subEmitter]);
+        count = std::min(count, m_SubEmitterBudget - m_FrameSubEmitted);
+        uint32_t live = m_TypeCounts[spawnType] + m_SubEmittedTypes[spawnType];
+        count = live < desc.liveBudget ? std::min(count, desc.liveBudget - live) : 0;
+        if (count == 0)
+            continue;
+
+        const Float3 posW = EvaluateParticlePosition(e.source, e.age, appearance.types[e.source.type & 3]);
+        for (uint32_t k = 0; k < count; ++k)
+        {
+            ParticleVertex p{};
+            p.initialPos = posW;
+            p.type = spawnType;
+            if (spawnType == PT_SMOKE)
+            {
+                // 与fire_smoke.hlsl中火焰粒子产生的烟雾相同
+                Float3 vRandom = RandUnitVec3(id, RS_SubEmit, k + 1);
+                vRandom.x *= 0.5f;
+                vRandom.z *= 0.5f;
+                p.initialVel = vRandom;
+                p.size = { 3.0f, 3.0f };
+                p.age = aliveTime * (vRandom.x + 1.0f) + e.elapsed;
+            }
+            else
+            {
+                // 与Boom中壳散开的粒子相同
+                p.accel = RandVec3(id, RS_SubEmit, k + 1) * ShellBurstLife::AccelScale;
+                p.size = { 2.5f, 2.5f };
+                p.age = e.elapsed;
+            }
+            spawned.push_back(p);
+        }
+        m_SubEmitterSpawned[e.subEmitter] += count;
+        m_SubEmitterTotals[e.subEmitter] += count;
+        m_FrameSubEmitted += count;
+        m_SubEmittedTypes[spawnType] += count;
+    }
+}
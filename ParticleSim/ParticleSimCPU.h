@@ -0,0 +1,388 @@
+//***************************************************************************************
+// ParticleSimCPU.h
+//
+// CPU端粒子模拟，复现各特效SO_GS中发射器/粒子/壳/烟雾的生命周期
+// CPU particle simulation reproducing the emitter/particle/shell/smoke lifecycle of
+// the SO_GS stage in each effect.
+//***************************************************************************************
+
+#pragma once
+
+#ifndef PARTICLE_SIM_CPU_H
+#define PARTICLE_SIM_CPU_H
+
+#include <vector>
+#include <utility>
+#include "ParticleSimTypes.h"
+#include "ParticleStorage.h"
+#include "ParticleKernels.h"
+#include "ParticlePacking.h"
+#include "ParticleRandom.h"
+#include "ParticleBounds.h"
+#include "ParticleEmitterTable.h"
+#include "TimingWheel.h"
+
+class JobSystem;
+struct ParticleSystemKernels;
+
+class ParticleSimCPU
+{
+public:
+    // 并行更新时每个任务处理的粒子数，为缓存行的整数倍
+    static constexpr uint32_t ChunkSize = 4096;
+    static_assert(ChunkSize * sizeof(float) % ParticleCacheLineSize == 0, "Chunks must not share cache lines");
+
+    ParticleSimCPU() = default;
+    ~ParticleSimCPU() = default;
+    // 不允许拷贝，允许移动
+    ParticleSimCPU(const ParticleSimCPU&) = delete;
+    ParticleSimCPU& operator=(const ParticleSimCPU&) = delete;
+    ParticleSimCPU(ParticleSimCPU&&) = default;
+    ParticleSimCPU& operator=(ParticleSimCPU&&) = default;
+
+    // maxParticles与ParticleManager::InitResource中流输出缓冲区的容量含义相同
+    // seed决定该系统全部的随机数，相同的种子与输入总是得到相同的结果
+    void Init(ParticleEffectType effectType, uint32_t maxParticles, uint64_t seed = 0);
+
+    ParticleEffectType GetEffectType() const { return m_EffectType; }
+    uint32_t GetMaxParticles() const { return m_MaxParticles; }
+
+    // 自从该系统被重置以来所经过的时间
+    float GetAge() const { return m_Age; }
+    // 自从该系统被重置以来Update的次数
+    uint32_t GetFrameIndex() const { return m_FrameIndex; }
+
+    void SetEmitPos(const Float3& emitPos);
+    void SetEmitDir(const Float3& emitDir);
+    void SetEmitInterval(float t);
+    void SetAliveTime(float t);
+    void SetAcceleration(const Float3& accel);
+    void SetParticleCount(uint32_t defaultParticle, uint32_t smokeParticle);
+    const ParticleSimParams& GetParams() const { return m_Params; }
+
+    // Accumulated模式下发射频率与帧率无关(Boom的壳按帧发射，不受影响)
+    void SetEmissionMode(EmissionMode mode) { m_EmissionMode = mode; }
+    EmissionMode GetEmissionMode() const { return m_EmissionMode; }
+
+    // BirthRing只对Fire/Fountain/Smoke且发射器表为空时生效，Pool只对FireSmoke/Boom生效，否则保持Compact
+    // 切换时保留现有的粒子
+    void SetStorageMode(ParticleStorageMode mode);
+    ParticleStorageMode GetStorageMode() const { return m_StorageMode; }
+
+    void SetSeed(uint64_t seed) { m_Random.SetSeed(seed); }
+    uint64_t GetSeed() const { return m_Random.GetSeed(); }
+
+    // 回到只有一个发射器的初始状态
+    void Reset();
+    // 推进一帧，等价于一次流输出
+    // 提供jobs时按ChunkSize分块并行更新，可在其他任务中嵌套调用
+    // 块的划分只取决于粒子数，新粒子、压缩与子发射器事件都按块的顺序合并，随机数由计数器得到，
+    // 因此结果与是否提供jobs及其线程数无关，逐位相同(BirthRing/Pool模式在调用线程上更新)
+    void Update(float dt, float gameTime, JobSystem* jobs = nullptr);
+    // 并行更新多个系统(系统 x 分块的嵌套并行)
+    static void UpdateSystems(ParticleSimCPU* const* systems, uint32_t systemCount,
+        float dt, float gameTime, JobSystem& jobs);
+
+    // 时间轴跳转：重置后直接重建自重置起time秒(以dt推进round(time / dt)帧)时的粒子，假设当前参数与发射器一直未变
+    // 发射器的状态由闭式求出。寿命统一且没有子发射器的特效(Fire/Fountain/Smoke)只枚举存活窗口内出生的粒子，
+    // 直接写出其存活时间；其余特效从最长的后代链之前以空的粒子集合逐帧推进这段窗口。代价与time无关
+    // 粒子、顺序与随机数与逐帧推进相同，Accumulated模式下发射器的相位与FireSmoke的暂停为近似，存活时间可能有舍入误差
+    void SeekTo(float time, float dt, JobSystem* jobs = nullptr);
+    // 预热：SeekTo(GetAge() + seconds, dt)，现有的粒子被重建的结果取代
+    void Prewarm(float seconds, float dt, JobSystem* jobs = nullptr);
+
+    // 当前状态的64位散列：粒子(按导出顺序，Pool为全部槽位)、发射器与发射器表的状态、计数器与时钟
+    // 粒子按ChunkSize分块散列后依次合并，结果与jobs无关；两次运行的散列相同即状态逐位相同
+    uint64_t ComputeStateHash(JobSystem* jobs = nullptr) const;
+
+    // 导入/导出与流输出缓冲区相同的顶点数据
+    // 导出时粒子在前，发射器(若存在)在最后，返回写入的顶点数
+    void SetVertices(const ParticleVertex* vertices, uint32_t count);
+    uint32_t ExportVertices(ParticleVertex* vertices, uint32_t maxCount) const;
+    uint32_t GetVertexCount() const { return GetParticleCount() + (m_HasEmitter ? 1 : 0); }
+    // 依次导出Evaluate输出中位于indices处的粒子(Pool为槽位，其余为ExportVertices的顺序)，不含发射器
+    // 用于只上传剔除后可见的粒子
+    void ExportVertices(const uint32_t* indices, uint32_t count, ParticleVertex* vertices) const;
+    // 以32字节的量化格式导出，顺序与ExportVertices相同，存活时间均换算为实际值
+    uint32_t ExportPacked(PackedParticle* particles, uint32_t maxCount) const;
+    // 上限取最长的有限寿命(Boom的壳取发射间隔)的两倍，覆盖消亡前最后一帧及发射器的累计时间
+    // 下限为-(发射间隔 + 绘制滞后)，覆盖延迟发射的壳与滞后时刚出生的粒子，随SetRenderLag变化
+    PackedParticleConstants GetPackedConstants() const;
+    // 不含发射器的粒子数
+    uint32_t GetParticleCount() const;
+
+    // SoA形式的粒子数据(不含发射器)
+    // BirthRing模式下为环形缓冲区，Age通道存放出生时间，需配合GetRingHead/GetParticleCount使用
+    // Pool模式下全部容量都是槽位，空闲槽位的类型为PoolFreeSlot，Age通道同样存放出生时间
+    const ParticleStorage& GetParticles() const { return m_Particles; }
+    uint32_t GetRingHead() const { return m_RingHead; }
+    // Compact模式下最近一次Update的存活标记，按更新前的顺序，存活的粒子保持先后顺序排在当前存储的最前面
+    // 返回更新前的粒子数，其他模式下或Reset/SetVertices之后返回0
+    uint32_t GetSurvivors(const uint8_t** alive) const
+    {
+        *alive = m_Alive.data();
+        return m_SurvivorSourceCount;
+    }
+    static constexpr uint8_t PoolFreeSlot = 0xFF;
+
+    // 与着色器一致的外观参数
+    ParticleAppearanceTable GetAppearance() const;
+    // 全部粒子(含公告板)的保守包围盒，由参数解析求出，只在参数改变时重新计算
+    // 参数改变前产生的粒子全部消亡之前仍包含旧的范围，粒子与发射器都不存在时为空
+    ParticleBounds GetBounds() const;
+    // 不调用Update(流输出路径)时推进包围盒使用的时钟
+    // 此时粒子不在CPU端，影响现有粒子的参数改变后在其可能存活的时间内不再给出有限的范围
+    void AdvanceBounds(float dt)
+    {
+        m_ExternalParticles = true;
+        m_Bounds.Advance(dt);
+    }
+
+    // 绘制落后于模拟的时长：以固定步长模拟时，导出与Evaluate都以存活时间减去lag作为绘制时的状态，不影响模拟本身
+    // 轨迹是存活时间的闭式函数，这样得到的即两步之间的插值位置；最近一步出生的粒子存活时间为负，与Boom中延迟出现的壳相同
+    void SetRenderLag(float seconds) { m_RenderLag = std::max(seconds, 0.0f); }
+    float GetRenderLag() const { return m_RenderLag; }
+
+    // 计算所有粒子(不含发射器)当前的世界坐标、透明度与半尺寸，供CPU端剔除/排序使用
+    // Pool模式下输出按槽位排列，空闲槽位的结果无意义
+    void Evaluate(ParticleEvalBuffer& buffer) const;
+
+    // 发射器表：系统自身的发射器之外任意数目的发射器，共用参数、发射模式与粒子存储
+    // 每帧先统计全部发射器的发射数，再按前缀和成批写入，一次更新、一次绘制
+    // 规则与系统自身的发射器相同(Boom的每个发射器同样只发射一轮壳)，不随ExportVertices导出，Reset时回到初始状态
+    // 同一帧内各发射器的粒子不按出生先后排列，添加发射器时BirthRing退回Compact
+    uint32_t AddEmitter(const ParticleEmitterDesc& desc);
+    void ClearEmitters();
+    // 修改位置、方向、间隔与启用状态，包围盒在下一次Update时更新
+    ParticleEmitterTable& GetEmitters() { return m_EmitterTable; }
+    const ParticleEmitterTable& GetEmitters() const { return m_EmitterTable; }
+    // 位于原点、方向为+y的单个发射器在当前参数下其粒子(含后代与公告板)可能到达的范围
+    ParticleBounds GetEmitterExtent() const;
+
+    // 子发射器，FireSmoke在Init时默认添加产生烟雾的一个
+    // 事件由各块写入自己的缓冲区，再按块的顺序统一换算为新粒子，结果与线程数无关
+    static constexpr uint32_t MaxSubEmitters = 8;
+    void AddSubEmitter(const SubEmitterDesc& desc);
+    void ClearSubEmitters();
+    const std::vector<SubEmitterDesc>& GetSubEmitters() const { return m_SubEmitters; }
+    // 所有子发射器每帧合计产生的粒子数上限
+    void SetSubEmitterBudget(uint32_t budget) { m_SubEmitterBudget = budget; }
+    // 自Reset或添加以来第index个子发射器产生的粒子总数
+    uint64_t GetSubEmitterSpawnTotal(uint32_t index) const { return m_SubEmitterTotals[index]; }
+
+    // PT_PARTICLE/PT_SMOKE的数目，由模拟在产生与消亡时增量维护，无需遍历粒子
+    // 可直接作为SetParticleCount的输入
+    std::pair<uint32_t, uint32_t> CountParticles() const;
+
+private:
+    // 随机数的用途，作为计数器的stream分量
+    enum RandomStream : uint32_t
+    {
+        RS_Velocity,
+        RS_Accel,
+        RS_Age,
+        RS_SubEmit,
+    };
+    // 发射器产生的随机数使用的id，不与粒子下标冲突
+    static constexpr uint32_t EmitterRandomId = 0xFFFFFFFFu;
+    // 发射器表的批次使用的id，index为粒子在批次中的位置；第e个发射器的壳以其下方的id区分
+    static constexpr uint32_t EmitterTableRandomId = 0xFFFFFFFEu;
+    static uint32_t GetTableShellRandomId(uint32_t emitter) { return EmitterTableRandomId - 1 - emitter; }
+
+    // 对应HLSL中的RandVec3/RandUnitVec3，以(id, 帧号, 用途, 序号)为计数器
+    // 粒子的id为它在本帧中的下标
+    Float3 RandVec3(uint32_t id, RandomStream stream, uint32_t index = 0) const;
+    Float3 RandUnitVec3(uint32_t id, RandomStream stream, uint32_t index = 0) const;
+
+    // 对应各特效SO_GS中PT_EMITTER的分支，由特效的生成策略实现
+    void UpdateEmitters();
+    // Accumulated模式：只计算本帧发射的数目，粒子由生成策略的EmitBatch直接写入存储
+    // 第k个粒子出生于第k + 1个发射间隔，paused时不积攒发射量
+    void UpdateEmitterAccumulated(bool paused);
+    // 发射器(含发射器表)自重置起以m_TimeStep推进frames帧后的累计时间，与逐帧累加的结果相同
+    // Accumulated模式下为近似，PerFrame模式下按发射周期逐帧累加
+    float GetSkippedEmitterAge(uint64_t frames, float interval) const;
+    // 不模拟粒子，直接把时钟、帧号与发射器的状态设为重置后经过frames帧时的值
+    void SkipFrames(uint32_t frames, float dt);
+    // 只执行接下来frames帧的发射，按出生的帧换算出最后一帧的存活时间，写出仍存活的粒子
+    // 仅用于寿命统一且没有子发射器的特效
+    void EmitWindow(uint32_t frames);
+
+    // 发射器表：按发射模式统计启用的发射器本帧发射的数目，发射的写入m_TableEmitters/m_TableOffsets等
+    void CountTableEmission(bool paused);
+
+    // BirthRing模式：移除环尾过期的粒子并在环头追加新粒子，不写入其余粒子
+    void UpdateBirthRing();
+    // 当前时刻，与Age通道中的出生时间相对同一起点
+    float GetClockNow() const { return static_cast<float>(m_Clock - m_ClockEpoch); }
+    // 导出与Evaluate使用的存活时间：Compact为存活时间减去m_RenderLag，其余模式由出生时间换算
+    ParticleAgeMapping GetRenderAges() const
+    {
+        if (m_StorageMode == ParticleStorageMode::Compact)
+            return { 1.0f, -m_RenderLag };
+        return ParticleAgeMapping::FromBirthTime(GetClockNow() - m_RenderLag);
+    }
+    // 时间过大时将所有出生时间整体前移以保持float精度，返回新的当前时刻
+    float RebaseClock();
+    void PushRing(const ParticleVertex& v);
+
+    // Pool模式下槽位上挂起的计时器，每个槽位同一时间只有一个
+    enum PoolTimer : uint8_t
+    {
+        PTM_Expire,         // 超过寿命后释放槽位
+        PTM_AgeEvent,       // 存活时间越过子发射器的触发比例
+        PTM_ShellBurst,     // 壳到达爆炸点后每帧散开粒子
+    };
+    // 时间轮每秒的时间片数，需小于帧间隔以便按帧重复的计时器每帧触发
+    static constexpr double PoolTickRate = 1024.0;
+
+    void ResetPool();
+    void UpdatePool();
+    // 从空闲链表取出槽位，容量已满时与流输出一样丢弃
+    void PushPool(const ParticleVertex& v);
+    void FreePoolSlot(uint32_t slot);
+    // 根据槽位的类型与状态调度下一个计时器
+    void SchedulePoolTimer(uint32_t slot);
+    void HandlePoolTimer(uint32_t slot, float now);
+    // 槽位释放前产生Death事件
+    void RaisePoolDeathEvents(uint32_t slot, float age);
+    // 寿命或发射间隔改变后重新调度所有计时器
+    void RebuildPoolTimers();
+    // 出生时间加上时长对应的时间片，提前一个时间片以免因舍入而晚一帧
+    uint64_t GetDeadlineTick(float birth, float duration) const;
+
+    // Boom的多级发射(发射器→壳→粒子)以请求表示：各级先统计数目，
+    // 由前缀和为每个块预留写入位置，再由各块并行地成批展开
+    struct SpawnRequest
+    {
+        Float3 origin;
+        uint32_t randomId;          // 随机数的id，index从firstIndex开始依次递增
+        uint32_t firstIndex;
+        uint32_t count;
+        uint8_t type;               // PT_SHELL：发射器发射的壳，PT_PARTICLE：壳散开的粒子
+    };
+
+    // 更新[begin, end)内的粒子，写入存活标记，新粒子放入该块自己的列表
+    // 不同的块之间不共享可写数据，可并行执行
+    void UpdateChunk(uint32_t chunkIndex, uint32_t begin, uint32_t end);
+    // 各类型粒子按存活时间消亡的寿命，Boom的壳不按存活时间消亡
+    float GetLifetime(uint32_t type) const;
+
+    // 子发射器的事件，记录触发时粒子的数据
+    struct ParticleEvent
+    {
+        ParticleVertex source;
+        float age;                  // 触发时刻粒子的存活时间
+        float elapsed;              // 触发后到本帧结束经过的时间
+        uint32_t subEmitter;
+    };
+    // 检查块内粒子是否触发子发射器的事件，写入该块的事件缓冲区
+    void RaiseChunkEvents(uint32_t chunkIndex, uint32_t begin, uint32_t end);
+    void RaiseEvent(std::vector<ParticleEvent>& events, uint32_t subEmitter, const ParticleVertex& source, float eventAge, float age);
+    // 重置本帧的预算，之后按固定顺序对各缓冲区调用ConsolidateEvents
+    void BeginEventConsolidation();
+    // 按预算与概率将事件换算为新粒子，追加到spawned
+    void ConsolidateEvents(const std::vector<ParticleEvent>& events, std::vector<ParticleVertex>& spawned);
+
+    // 将块内存活的粒子按段复制到target的偏移处，并写入该块的新粒子
+    // 超出容量的新粒子与流输出一样被丢弃
+    void ScatterChunk(uint32_t chunkIndex, uint32_t begin, uint32_t end, ParticleStorage& target);
+    void StoreSpawned(const std::vector<ParticleVertex>& spawned, uint32_t offset, ParticleStorage& target);
+    // 从offset起依次展开请求，直接按通道写入，返回写入的粒子数
+    uint32_t FillSpawnRequests(const std::vector<SpawnRequest>& requests, uint32_t offset, ParticleStorage& target) const;
+    static uint32_t CountSpawnRequests(const std::vector<SpawnRequest>& requests);
+    // 重新统计各类型的粒子数，仅在整体替换粒子后使用
+    void RecountTypes();
+    // 参数、发射器或子发射器改变后重新求出包围盒，affectsLive表示改变同样影响现有粒子的轨迹或后代
+    void RefreshBounds(bool affectsLive);
+
+private:
+    // 各特效的更新规则由ParticleSystem的策略组合在编译期生成
+    template<class SpawnPolicy, class LifePolicy, class AppearancePolicy>
+    friend class ParticleSystem;
+    friend struct ParticleSystemKernels;
+
+    ParticleEffectType m_EffectType = ParticleEffectType::Fire;
+    const ParticleSystemKernels* m_pKernels = nullptr;
+    uint32_t m_MaxParticles = 0;
+
+    float m_GameTime = 0.0f;
+    float m_TimeStep = 0.0f;
+    float m_RenderLag = 0.0f;
+    float m_Age = 0.0f;
+    uint32_t m_FrameIndex = 0;                  // 自重置以来的帧数，作为随机数计数器的一部分
+
+    ParticleSimParams m_Params;
+    EmissionMode m_EmissionMode = EmissionMode::PerFrame;
+    ParticleStorageMode m_StorageMode = ParticleStorageMode::Compact;
+
+    ParticleRandom m_Random;
+
+    ParticleVertex m_Emitter = {};              // 发射器单独存放，不参与逐粒子更新
+    bool m_HasEmitter = true;
+    ParticleStorage m_Particles;                // 除发射器以外的粒子
+    ParticleStorage m_Scratch;                  // 压缩的目标，与m_Particles交替使用
+    AlignedVector<uint8_t> m_Alive;             // 本帧的存活标记
+    uint32_t m_SurvivorSourceCount = 0;         // m_Alive对应的更新前粒子数
+    uint32_t m_TypeCounts[4] = {};              // 各类型的粒子数(BirthRing模式除外)
+
+    // 每个块的存活数与压缩后的写入位置
+    struct ChunkCompaction
+    {
+        uint32_t aliveCount;
+        uint32_t aliveOffset;
+        uint32_t spawnOffset;
+        uint32_t diedCounts[4];     // 本帧消亡的粒子数，按类型
+    };
+    std::vector<ChunkCompaction> m_Chunks;
+
+    // 本帧新产生的粒子，压缩时按块的顺序写在存活粒子之后
+    // 列表在帧之间保留容量，稳定后不再分配内存
+    std::vector<std::vector<ParticleVertex>> m_ChunkSpawned;
+    std::vector<std::vector<SpawnRequest>> m_ChunkRequests;
+    std::vector<ParticleVertex> m_EmitterSpawned;
+    std::vector<SpawnRequest> m_EmitterRequests;
+
+    // 子发射器与各块的事件缓冲区
+    std::vector<SubEmitterDesc> m_SubEmitters;
+    uint32_t m_SubEmitterBudget = UINT32_MAX;
+    std::vector<std::vector<ParticleEvent>> m_ChunkEvents;
+    uint32_t m_SubEmitterSpawned[MaxSubEmitters] = {};     // 本帧各子发射器已产生的粒子数
+    uint64_t m_SubEmitterTotals[MaxSubEmitters] = {};      // 各子发射器累计产生的粒子数
+    uint32_t m_FrameSubEmitted = 0;                         // 本帧所有子发射器已产生的粒子数
+    uint32_t m_SubEmittedTypes[4] = {};                     // 本帧子发射器按类型产生的粒子数
+    uint32_t m_EventOrdinal = 0;                            // 本帧已处理的事件数，作为随机数的id
+    uint32_t m_EmitBatchCount = 0;              // Accumulated模式下本帧发射的粒子数
+    float m_EmitBatchAge = 0.0f;                // 发射前发射器的累计时间
+
+    // 发射器表与本帧的批次：按段排列，第i段为发射器m_TableEmitters[i]，粒子位于[m_TableOffsets[i], m_TableOffsets[i + 1])
+    ParticleEmitterTable m_EmitterTable;
+    std::vector<uint32_t> m_TableEmitters;
+    std::vector<uint32_t> m_TableOffsets;
+    std::vector<float> m_TableBatchAges;        // 各段发射前的累计时间
+    std::vector<float> m_TableBatchSpacings;    // 各段粒子出生的间隔
+    uint32_t m_TableBatchCount = 0;
+
+    // BirthRing模式下的环形缓冲区，[m_RingHead, m_RingHead + m_RingCount)按出生先后排列
+    uint32_t m_RingHead = 0;
+    uint32_t m_RingCount = 0;
+
+    // BirthRing/Pool模式共用的时钟
+    double m_Clock = 0.0;                       // 自重置以来的时间，使用double避免长时间运行后的误差
+    double m_ClockEpoch = 0.0;                  // 出生时间的起点，定期前移以保持float精度
+
+    // Pool模式：空闲槽位栈、按到期时间分桶的计时器与各类型的粒子数
+    std::vector<uint32_t> m_FreeSlots;
+    std::vector<uint8_t> m_PoolTimers;
+    TimingWheel m_Wheel;
+    std::vector<ParticleVertex> m_PoolSpawned;
+    std::vector<SpawnRequest> m_PoolRequests;
+    std::vector<ParticleEvent> m_PoolEvents;
+    std::vector<uint8_t> m_PoolFiredEvents;     // 各槽位已触发的AgeThreshold子发射器，按位记录
+
+    ParticleBoundsTracker m_Bounds;
+    bool m_ExternalParticles = false;           // 最近由AdvanceBounds推进，粒子由流输出模拟
+    uint32_t m_BoundsTableVersion = 0;          // 包围盒对应的发射器表版本
+};
+
+#endif
@@ -0,0 +1,141 @@
+//***************************************************************************************
+// ParticleSimTypes.h
+//
+// CPU粒子模拟使用的基础类型，不依赖Windows/DirectX头文件
+// Basic types for the CPU particle simulation, free of Windows/DirectX headers.
+//***************************************************************************************
+
+#pragma once
+
+#ifndef PARTICLE_SIM_TYPES_H
+#define PARTICLE_SIM_TYPES_H
+
+#include <cstdint>
+#include <cmath>
+
+//
+// 简单向量类型，内存布局与DirectX::XMFLOAT2/XMFLOAT3相同
+//
+
+struct Float2
+{
+    float x, y;
+};
+
+struct Float3
+{
+    float x, y, z;
+};
+
+inline Float3 operator+(const Float3& a, const Float3& b) { return { a.x + b.x, a.y + b.y, a.z + b.z }; }
+inline Float3 operator-(const Float3& a, const Float3& b) { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+inline Float3 operator*(const Float3& a, const Float3& b) { return { a.x * b.x, a.y * b.y, a.z * b.z }; }
+inline Float3 operator*(const Float3& a, float s) { return { a.x * s, a.y * s, a.z * s }; }
+inline Float3 operator*(float s, const Float3& a) { return { a.x * s, a.y * s, a.z * s }; }
+
+inline float Dot(const Float3& a, const Float3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+
+// 与HLSL的normalize一致，但零向量原样返回
+inline Float3 Normalize(const Float3& v)
+{
+    float lenSq = Dot(v, v);
+    if (lenSq <= 0.0f)
+        return v;
+    return v * (1.0f / std::sqrt(lenSq));
+}
+
+// 与HLSL的smoothstep一致
+inline float SmoothStep(float minValue, float maxValue, float x)
+{
+    float t = (x - minValue) / (maxValue - minValue);
+    t = t < 0.0f ? 0.0f : (t > 1.0f ? 1.0f : t);
+    return t * t * (3.0f - 2.0f * t);
+}
+
+//
+// 粒子类型，与Particle.hlsl中的PT_*定义一致
+//
+
+enum ParticleVertexType : uint32_t
+{
+    PT_EMITTER = 0,
+    PT_PARTICLE = 1,
+    PT_SHELL = 2,
+    PT_SMOKE = 3,
+};
+
+// 与ParticleEffect::VertexParticle及Particle.hlsl中的VertexParticle布局相同
+struct ParticleVertex
+{
+    Float3 initialPos;
+    Float3 initialVel;
+    Float3 accel;
+    Float2 size;
+    float age;
+    uint32_t type;
+    uint32_t emitCount;
+};
+
+static_assert(sizeof(ParticleVertex) == 56, "ParticleVertex must match the stream output layout");
+
+// 对应Shaders目录下的五种特效
+enum class ParticleEffectType
+{
+    Fire = 0,
+    Smoke,
+    FireSmoke,
+    Boom,
+    Fountain,
+};
+
+// 发射器产生粒子的方式
+enum class EmissionMode
+{
+    PerFrame,       // 与SO_GS相同：每帧至多发射一个粒子，发射后累计时间清零
+    Accumulated,    // 按累计时间每帧发射N个粒子，每个粒子按帧内的出生时刻设置存活时间
+};
+
+// CPU模拟的粒子存储方式
+enum class ParticleStorageMode
+{
+    Compact,        // 每帧更新存活时间并压缩存活的粒子
+    BirthRing,      // 仅用于寿命相同的特效：按出生先后存放出生时间，过期的粒子从环尾整段移除
+    Pool,           // 用于FireSmoke/Boom：槽位固定的粒子池，由时间轮按到期时间处理消亡与发射
+};
+
+// 子发射器的触发事件
+enum class ParticleEventType : uint8_t
+{
+    AgeThreshold,   // 存活时间越过寿命的一定比例，每个粒子只触发一次
+    Death,          // 粒子消亡
+    Collision,      // 粒子向下穿过水平面(仅Compact模式)
+};
+
+// 子发射器：某类粒子产生事件时按概率产生新粒子，受每帧与存活总数的预算限制
+// spawnType为PT_SMOKE时产生与FireSmoke相同的烟雾，否则产生与Boom散开粒子相同的火花
+struct SubEmitterDesc
+{
+    ParticleEventType trigger = ParticleEventType::Death;
+    uint8_t sourceType = PT_PARTICLE;       // 产生事件的粒子类型
+    uint8_t spawnType = PT_SMOKE;           // 产生的粒子类型
+    float ageFraction = 1.0f;               // AgeThreshold：触发时刻占寿命的比例
+    float planeY = 0.0f;                    // Collision：水平面的高度
+    float chance = 1.0f;                    // 每个事件产生粒子的概率
+    uint32_t spawnCount = 1;                // 每个事件产生的粒子数
+    uint32_t frameBudget = UINT32_MAX;      // 该子发射器每帧最多产生的粒子数
+    uint32_t liveBudget = UINT32_MAX;       // spawnType的粒子数达到该值后不再产生
+};
+
+// 与ParticleManager/ParticleEffect中同名的设置项一一对应
+struct ParticleSimParams
+{
+    Float3 emitPos = {};
+    Float3 emitDir = {};
+    Float3 accel = {};
+    float emitInterval = 0.0f;
+    float aliveTime = 0.0f;
+    uint32_t defaultParticleCount = 0;     // g_DefaultParticleCount
+    uint32_t smokeParticleCount = 0;       // g_SmokeParticleCount
+};
+
+#endif
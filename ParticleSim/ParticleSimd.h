@@ -0,0 +1,139 @@
+//***************************************************************************************
+// ParticleSimd.h
+//
+// 宽度无关的SIMD浮点封装(标量/SSE2/AVX2)，内核按模板参数选择宽度
+// Width-generic SIMD float wrappers (scalar/SSE2/AVX2); kernels pick the width as a
+// template parameter.
+//***************************************************************************************
+
+#pragma once
+
+#ifndef PARTICLE_SIMD_H
+#define PARTICLE_SIMD_H
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PARTICLE_SIMD_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#if defined(__AVX2__)
+#define PARTICLE_SIMD_AVX2 1
+#include <immintrin.h>
+#endif
+
+//
+// 标量实现，作为参考路径以及不支持SIMD时的回退
+//
+
+struct SimdFloat1
+{
+    static constexpr int Width = 1;
+    float v;
+
+    static SimdFloat1 Load(const float* p) { return { *p }; }
+    static SimdFloat1 Set1(float x) { return { x }; }
+    void Store(float* p) const { *p = v; }
+
+    friend SimdFloat1 operator+(SimdFloat1 a, SimdFloat1 b) { return { a.v + b.v }; }
+    friend SimdFloat1 operator-(SimdFloat1 a, SimdFloat1 b) { return { a.v - b.v }; }
+    friend SimdFloat1 operator*(SimdFloat1 a, SimdFloat1 b) { return { a.v * b.v }; }
+    friend SimdFloat1 Min(SimdFloat1 a, SimdFloat1 b) { return { a.v < b.v ? a.v : b.v }; }
+    friend SimdFloat1 Max(SimdFloat1 a, SimdFloat1 b) { return { a.v > b.v ? a.v : b.v }; }
+    // 掩码为全1位时选a
+    friend SimdFloat1 Select(SimdFloat1 mask, SimdFloat1 a, SimdFloat1 b)
+    {
+        uint32_t bits;
+        std::memcpy(&bits, &mask.v, sizeof(bits));
+        return bits ? a : b;
+    }
+    friend SimdFloat1 CmpLessEqual(SimdFloat1 a, SimdFloat1 b) { return MaskFromBool(a.v <= b.v); }
+    friend SimdFloat1 CmpGreater(SimdFloat1 a, SimdFloat1 b) { return MaskFromBool(a.v > b.v); }
+    // 每条通道的掩码按位组成整数
+    friend int MoveMask(SimdFloat1 mask)
+    {
+        uint32_t bits;
+        std::memcpy(&bits, &mask.v, sizeof(bits));
+        return bits ? 1 : 0;
+    }
+
+    static SimdFloat1 MaskFromBool(bool b)
+    {
+        uint32_t bits = b ? 0xFFFFFFFFu : 0u;
+        SimdFloat1 r;
+        std::memcpy(&r.v, &bits, sizeof(bits));
+        return r;
+    }
+};
+
+#if defined(PARTICLE_SIMD_SSE2)
+
+struct SimdFloat4
+{
+    static constexpr int Width = 4;
+    __m128 v;
+
+    static SimdFloat4 Load(const float* p) { return { _mm_loadu_ps(p) }; }
+    static SimdFloat4 Set1(float x) { return { _mm_set1_ps(x) }; }
+    void Store(float* p) const { _mm_storeu_ps(p, v); }
+
+    friend SimdFloat4 operator+(SimdFloat4 a, SimdFloat4 b) { return { _mm_add_ps(a.v, b.v) }; }
+    friend SimdFloat4 operator-(SimdFloat4 a, SimdFloat4 b) { return { _mm_sub_ps(a.v, b.v) }; }
+    friend SimdFloat4 operator*(SimdFloat4 a, SimdFloat4 b) { return { _mm_mul_ps(a.v, b.v) }; }
+    friend SimdFloat4 Min(SimdFloat4 a, SimdFloat4 b) { return { _mm_min_ps(a.v, b.v) }; }
+    friend SimdFloat4 Max(SimdFloat4 a, SimdFloat4 b) { return { _mm_max_ps(a.v, b.v) }; }
+    friend SimdFloat4 Select(SimdFloat4 mask, SimdFloat4 a, SimdFloat4 b)
+    {
+        return { _mm_or_ps(_mm_and_ps(mask.v, a.v), _mm_andnot_ps(mask.v, b.v)) };
+    }
+    friend SimdFloat4 CmpLessEqual(SimdFloat4 a, SimdFloat4 b) { return { _mm_cmple_ps(a.v, b.v) }; }
+    friend SimdFloat4 CmpGreater(SimdFloat4 a, SimdFloat4 b) { return { _mm_cmpgt_ps(a.v, b.v) }; }
+    friend int MoveMask(SimdFloat4 mask) { return _mm_movemask_ps(mask.v); }
+};
+
+#endif
+
+#if defined(PARTICLE_SIMD_AVX2)
+
+struct SimdFloat8
+{
+    static constexpr int Width = 8;
+    __m256 v;
+
+    static SimdFloat8 Load(const float* p) { return { _mm256_loadu_ps(p) }; }
+    static SimdFloat8 Set1(float x) { return { _mm256_set1_ps(x) }; }
+    void Store(float* p) const { _mm256_storeu_ps(p, v); }
+
+    friend SimdFloat8 operator+(SimdFloat8 a, SimdFloat8 b) { return { _mm256_add_ps(a.v, b.v) }; }
+    friend SimdFloat8 operator-(SimdFloat8 a, SimdFloat8 b) { return { _mm256_sub_ps(a.v, b.v) }; }
+    friend SimdFloat8 operator*(SimdFloat8 a, SimdFloat8 b) { return { _mm256_mul_ps(a.v, b.v) }; }
+    friend SimdFloat8 Min(SimdFloat8 a, SimdFloat8 b) { return { _mm256_min_ps(a.v, b.v) }; }
+    friend SimdFloat8 Max(SimdFloat8 a, SimdFloat8 b) { return { _mm256_max_ps(a.v, b.v) }; }
+    friend SimdFloat8 Select(SimdFloat8 mask, SimdFloat8 a, SimdFloat8 b) { return { _mm256_blendv_ps(b.v, a.v, mask.v) }; }
+    friend SimdFloat8 CmpLessEqual(SimdFloat8 a, SimdFloat8 b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_LE_OQ) }; }
+    friend SimdFloat8 CmpGreater(SimdFloat8 a, SimdFloat8 b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ) }; }
+    friend int MoveMask(SimdFloat8 mask) { return _mm256_movemask_ps(mask.v); }
+};
+
+#endif
+
+// 当前编译目标下最宽的实现
+#if defined(PARTICLE_SIMD_AVX2)
+using SimdFloat = SimdFloat8;
+#elif defined(PARTICLE_SIMD_SSE2)
+using SimdFloat = SimdFloat4;
+#else
+using SimdFloat = SimdFloat1;
+#endif
+
+// 与HLSL的smoothstep(0, range, x)一致，invRange = 1 / range
+template<class V>
+inline V SmoothStep01(V x, V invRange)
+{
+    V t = Min(Max(x * invRange, V::Set1(0.0f)), V::Set1(1.0f));
+    return t * t * (V::Set1(3.0f) - V::Set1(2.0f) * t);
+}
+
+#endif
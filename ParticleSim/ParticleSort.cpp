@@ -0,0 +1,403 @@
+#include "ParticleSort.h"
+#include "ParticleCull.h"
+#include "ParticleSimCPU.h"
+#include "ParticleSimd.h"
+#include "JobSystem.h"
+#include <algorithm>
+
+namespace
+{
+    // depths[i] = Dot(axis, pos[i]) + offset
+    void ComputeViewDepths(const float* posX, const float* posY, const float* posZ, uint32_t count,
+        const ParticleDepthPlane& plane, float* depths)
+    {
+        const SimdFloat axisX = SimdFloat::Set1(plane.axis.x);
+        const SimdFloat axisY = SimdFloat::Set1(plane.axis.y);
+        const SimdFloat axisZ = SimdFloat::Set1(plane.axis.z);
+        const SimdFloat offset = SimdFloat::Set1(plane.offset);
+        uint32_t i = 0;
+        for (; i + SimdFloat::Width <= count; i += SimdFloat::Width)
+        {
+            SimdFloat depth = axisX * SimdFloat::Load(posX + i) + axisY * SimdFloat::Load(posY + i) +
+                axisZ * SimdFloat::Load(posZ + i) + offset;
+            depth.Store(depths + i);
+        }
+        for (; i < count; ++i)
+            depths[i] = plane.axis.x * posX[i] + plane.axis.y * posY[i] + plane.axis.z * posZ[i] + plane.offset;
+    }
+
+    uint32_t GetBlockCount(uint32_t count, JobSystem* jobs)
+    {
+        const uint32_t threads = jobs ? jobs->GetThreadCount() : 1;
+        return std::max(1u, std::min(threads, count / ParticleDepthSorter::MinBlockSize));
+    }
+}
+
+void ParticleDepthSorter::Reserve(uint32_t count)
+{
+    if (m_Keys.size() >= count)
+        return;
+    m_Keys.resize(count);
+    m_KeysTemp.resize(count);
+    m_Indices.resize(count);
+    m_IndicesTemp.resize(count);
+}
+
+void ParticleDepthSorter::Sort(const ParticleSimCPU& sim, const ParticleDepthPlane& plane, JobSystem* jobs)
+{
+    SortDepths(m_Depths.data(), ComputeDepths(sim, plane, jobs), jobs);
+}
+
+void ParticleDepthSorter::Sort(const ParticleFrustumCuller& culler, const ParticleDepthPlane& plane, JobSystem* jobs)
+{
+    // 可见粒子在求值结果中不连续，按下标取出位置
+    const ParticleEvalBuffer& eval = culler.GetEval();
+    const uint32_t* evalIndices = culler.GetEvalIndices();
+    const uint32_t count = culler.GetVisibleCount();
+    if (m_Depths.size() < count)
+        m_Depths.resize(count);
+    JobSystem::ForEachBlock(jobs, GetBlockCount(count, jobs), count, [&](uint32_t, uint32_t begin, uint32_t end) {
+        const float* posX = eval.GetPosX();
+        const float* posY = eval.GetPosY();
+        const float* posZ = eval.GetPosZ();
+        for (uint32_t k = begin; k < end; ++k)
+        {
+            const uint32_t i = evalIndices[k];
+            m_Depths[k] = plane.axis.x * posX[i] + plane.axis.y * posY[i] + plane.axis.z * posZ[i] + plane.offset;
+        }
+    });
+    SortDepths(m_Depths.data(), count, jobs);
+    // 此后的顺序不再对应上一次SortCoherent
+    m_PrevSim = nullptr;
+}
+
+uint32_t ParticleDepthSorter::ComputeDepths(const ParticleSimCPU& sim, const ParticleDepthPlane& plane, JobSystem* jobs)
+{
+    sim.Evaluate(m_Eval);
+
+    // Pool模式下的输出按槽位排列，先算出全部槽位的深度
+    const bool pool = sim.GetStorageMode() == ParticleStorageMode::Pool;
+    const uint32_t evaluated = pool ? sim.GetMaxParticles() : sim.GetParticleCount();
+    if (m_Depths.size() < evaluated)
+        m_Depths.resize(evaluated);
+    JobSystem::ForEachBlock(jobs, GetBlockCount(evaluated, jobs), evaluated, [&](uint32_t, uint32_t begin, uint32_t end) {
+        ComputeViewDepths(m_Eval.GetPosX() + begin, m_Eval.GetPosY() + begin, m_Eval.GetPosZ() + begin,
+            end - begin, plane, m_Depths.data() + begin);
+    });
+    if (!pool)
+        return evaluated;
+
+    // 去掉空闲槽位，与ExportVertices的顺序一致
+    const uint8_t* types = sim.GetParticles().GetTypes();
+    m_Slots.resize(evaluated);
+    m_SlotIndices.resize(evaluated);
+    uint32_t count = 0;
+    for (uint32_t slot = 0; slot < evaluated; ++slot)
+    {
+        if (types[slot] == ParticleSimCPU::PoolFreeSlot)
+        {
+            m_SlotIndices[slot] = UINT32_MAX;
+            continue;
+        }
+        m_Slots[count] = slot;
+        m_SlotIndices[slot] = count;
+        m_Depths[count++] = m_Depths[slot];
+    }
+    return count;
+}
+
+void ParticleDepthSorter::SortCoherent(const ParticleSimCPU& sim, const ParticleDepthPlane& plane, JobSystem* jobs)
+{
+    const uint32_t count = ComputeDepths(sim, plane, jobs);
+    Reserve(count);
+    m_Count = count;
+    m_PassCount = 0;
+    m_Stats = {};
+
+    // 最近修复失败时按指数退避跳过若干帧，只在下次尝试的前一帧记录顺序
+    if (m_SkipFrames > 0)
+    {
+        --m_SkipFrames;
+        m_Stats.fallback = true;
+        SortDepths(m_Depths.data(), count, jobs);
+        if (m_SkipFrames == 0)
+            SavePreviousOrder(sim);
+        else
+            m_PrevSim = nullptr;
+        return;
+    }
+
+    const uint32_t carried = CarryPreviousOrder(sim, count);
+    const uint32_t inserted = count - carried;
+    m_Stats.carried = carried;
+    m_Stats.inserted = inserted;
+
+    // 新粒子占多数时(如第一帧)沿用的意义不大
+    const uint64_t budget = static_cast<uint64_t>(m_ShiftBudget * count);
+    if (inserted > count / 2 || !RepairOrder(carried, budget))
+    {
+        // 有可沿用的顺序却仍失败时才退避
+        if (carried > 0)
+        {
+            m_Backoff = std::min(std::max(2 * m_Backoff, 1u), MaxBackoffFrames);
+            m_SkipFrames = m_Backoff;
+        }
+        m_Stats.fallback = true;
+        SortDepths(m_Depths.data(), count, jobs);
+        if (m_SkipFrames == 0)
+            SavePreviousOrder(sim);
+        else
+            m_PrevSim = nullptr;
+        return;
+    }
+    m_Backoff = 0;
+
+    if (inserted > 0)
+    {
+        // 新粒子按(键, 下标)排序后与修复好的顺序归并，键相同时沿用的粒子在前
+        m_NewKeys.clear();
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            if (!m_Carried[i])
+                m_NewKeys.emplace_back(DepthToKey(m_Depths[i]), i);
+        }
+        std::sort(m_NewKeys.begin(), m_NewKeys.end());
+
+        uint32_t a = 0, b = 0;
+        for (uint32_t k = 0; k < count; ++k)
+        {
+            if (b == inserted || (a < carried && m_Keys[a] <= m_NewKeys[b].first))
+            {
+                m_KeysTemp[k] = m_Keys[a];
+                m_IndicesTemp[k] = m_Indices[a++];
+            }
+            else
+            {
+                m_KeysTemp[k] = m_NewKeys[b].first;
+                m_IndicesTemp[k] = m_NewKeys[b++].second;
+            }
+        }
+        std::swap(m_Keys, m_KeysTemp);
+        std::swap(m_Indices, m_IndicesTemp);
+    }
+    SavePreviousOrder(sim);
+}
+
+uint32_t ParticleDepthSorter::CarryPreviousOrder(const ParticleSimCPU& sim, uint32_t count)
+{
+    m_Carried.assign(count, 0);
+    const ParticleStorageMode mode = sim.GetStorageMode();
+    if (m_PrevSim != &sim || m_PrevMode != mode)
+        return 0;
+
+    // 各模式下把上一帧的标识换算为当前的下标，已消亡的粒子为UINT32_MAX
+    // 槽位或环中的位置在粒子消亡后可能被新粒子占用，此时沿用的只是一个近似的位置，由修复保证结果正确
+    const uint32_t maxParticles = sim.GetMaxParticles();
+    const uint32_t head = sim.GetRingHead();
+    // 环中过期的粒子从环尾整段移除，环头移动的距离即为过期数，其后的粒子依次存活
+    const uint32_t expired = (head + maxParticles - m_PrevRingHead) % std::max(maxParticles, 1u);
+    const uint32_t previousCount = static_cast<uint32_t>(m_PrevIds.size());
+    const uint32_t survivors = std::min(count, previousCount - std::min(expired, previousCount));
+    if (mode == ParticleStorageMode::Compact)
+    {
+        // 固定步长模拟时两次排序之间可能没有更新，粒子原样不动
+        if (sim.GetFrameIndex() == m_PrevFrame)
+        {
+            if (previousCount != count)
+                return 0;
+            m_Remap.resize(count);
+            for (uint32_t i = 0; i < count; ++i)
+                m_Remap[i] = i;
+        }
+        else
+        {
+            // 存活的粒子保持先后顺序排在最前，之间更新了多次时存活标记只对应最后一次
+            const uint8_t* alive = nullptr;
+            const uint32_t sourceCount = sim.GetSurvivors(&alive);
+            if (sim.GetFrameIndex() != m_PrevFrame + 1 || sourceCount != m_PrevIds.size())
+                return 0;
+            m_Remap.resize(sourceCount);
+            uint32_t rank = 0;
+            for (uint32_t i = 0; i < sourceCount; ++i)
+                m_Remap[i] = alive[i] ? rank++ : UINT32_MAX;
+        }
+    }
+    auto remap = [&](uint32_t id) -> uint32_t {
+        switch (mode)
+        {
+        case ParticleStorageMode::Pool: return m_SlotIndices[id];
+        case ParticleStorageMode::BirthRing:
+        {
+            uint32_t index = id >= head ? id - head : id + maxParticles - head;
+            return index < survivors ? index : UINT32_MAX;
+        }
+        default: return m_Remap[id];
+        }
+    };
+
+    uint32_t carried = 0;
+    for (uint32_t id : m_PrevIds)
+    {
+        const uint32_t index = remap(id);
+        if (index == UINT32_MAX)
+            continue;
+        m_Carried[index] = 1;
+        m_Keys[carried] = DepthToKey(m_Depths[index]);
+        m_Indices[carried++] = index;
+    }
+    return carried;
+}
+
+bool ParticleDepthSorter::RepairOrder(uint32_t carried, uint64_t budget)
+{
+    uint32_t* keys = m_Keys.data();
+    uint32_t* indices = m_Indices.data();
+
+    // 每处下降至少需要移动一个粒子，下降过多时修复不会比重新排序快，直接放弃
+    uint32_t descents = 0;
+    for (uint32_t j = 1; j < carried; ++j)
+        descents += keys[j - 1] > keys[j];
+    if (descents > carried / MaxDescentRatio)
+        return false;
+
+    for (uint32_t j = 1; j < carried; ++j)
+    {
+        const uint32_t key = keys[j];
+        if (keys[j - 1] <= key)
+            continue;
+
+        const uint32_t index = indices[j];
+        uint32_t k = j;
+        while (k > 0 && keys[k - 1] > key)
+        {
+            keys[k] = keys[k - 1];
+            indices[k] = indices[k - 1];
+            --k;
+        }
+        keys[k] = key;
+        indices[k] = index;
+        ++m_Stats.moved;
+        m_Stats.shifts += j - k;
+        if (m_Stats.shifts > budget)
+            return false;
+    }
+    return true;
+}
+
+void ParticleDepthSorter::SavePreviousOrder(const ParticleSimCPU& sim)
+{
+    const ParticleStorageMode mode = sim.GetStorageMode();
+    const uint32_t maxParticles = sim.GetMaxParticles();
+    const uint32_t head = sim.GetRingHead();
+    m_PrevSim = &sim;
+    m_PrevMode = mode;
+    m_PrevRingHead = head;
+    m_PrevFrame = sim.GetFrameIndex();
+    m_PrevIds.resize(m_Count);
+    for (uint32_t k = 0; k < m_Count; ++k)
+    {
+        const uint32_t index = m_Indices[k];
+        switch (mode)
+        {
+        case ParticleStorageMode::Pool: m_PrevIds[k] = m_Slots[index]; break;
+        case ParticleStorageMode::BirthRing: m_PrevIds[k] = (head + index) % maxParticles; break;
+        default: m_PrevIds[k] = index; break;
+        }
+    }
+}
+
+void ParticleDepthSorter::SortDepths(const float* depths, uint32_t count, JobSystem* jobs)
+{
+    Reserve(count);
+    m_Count = count;
+    m_PassCount = 0;
+    if (count == 0)
+        return;
+
+    const uint32_t blockCount = GetBlockCount(count, jobs);
+    m_Histograms.assign(blockCount * RadixPasses * RadixSize, 0);
+    auto histogram = [this](uint32_t block, uint32_t pass) {
+        return m_Histograms.data() + (block * RadixPasses + pass) * RadixSize;
+    };
+
+    // 生成键与初始下标，同时统计各趟的直方图
+    // 各趟的总数与顺序无关，可据此跳过所有键在该位上相同的趟
+    JobSystem::ForEachBlock(jobs, blockCount, count, [&](uint32_t b, uint32_t begin, uint32_t end) {
+        uint32_t* counts[RadixPasses];
+        for (uint32_t pass = 0; pass < RadixPasses; ++pass)
+            counts[pass] = histogram(b, pass);
+        for (uint32_t i = begin; i < end; ++i)
+        {
+            const uint32_t key = DepthToKey(depths[i]);
+            m_Keys[i] = key;
+            m_Indices[i] = i;
+            for (uint32_t pass = 0; pass < RadixPasses; ++pass)
+                ++counts[pass][(key >> (pass * RadixBits)) & (RadixSize - 1)];
+        }
+    });
+
+    uint32_t* keys = m_Keys.data();
+    uint32_t* indices = m_Indices.data();
+    uint32_t* keysOut = m_KeysTemp.data();
+    uint32_t* indicesOut = m_IndicesTemp.data();
+    bool permuted = false;
+    for (uint32_t pass = 0; pass < RadixPasses; ++pass)
+    {
+        const uint32_t shift = pass * RadixBits;
+        bool trivial = false;
+        for (uint32_t digit = 0; digit < RadixSize && !trivial; ++digit)
+        {
+            uint32_t total = 0;
+            for (uint32_t b = 0; b < blockCount; ++b)
+                total += histogram(b, pass)[digit];
+            trivial = total == count;
+        }
+        if (trivial)
+            continue;
+
+        // 之前的趟改变了顺序，各块的计数需按当前顺序重新统计
+        if (permuted)
+        {
+            JobSystem::ForEachBlock(jobs, blockCount, count, [&](uint32_t b, uint32_t begin, uint32_t end) {
+                uint32_t* counts = histogram(b, pass);
+                std::fill_n(counts, RadixSize, 0u);
+                for (uint32_t i = begin; i < end; ++i)
+                    ++counts[(keys[i] >> shift) & (RadixSize - 1)];
+            });
+        }
+
+        // 各块各基数的起始位置：先按基数，同一基数内按块的顺序，保证排序稳定
+        uint32_t offset = 0;
+        for (uint32_t digit = 0; digit < RadixSize; ++digit)
+        {
+            for (uint32_t b = 0; b < blockCount; ++b)
+            {
+                uint32_t& slot = histogram(b, pass)[digit];
+                const uint32_t n = slot;
+                slot = offset;
+                offset += n;
+            }
+        }
+
+        JobSystem::ForEachBlock(jobs, blockCount, count, [&](uint32_t b, uint32_t begin, uint32_t end) {
+            uint32_t* offsets = histogram(b, pass);
+            for (uint32_t i = begin; i < end; ++i)
+            {
+                const uint32_t dst = offsets[(keys[i] >> shift) & (RadixSize - 1)]++;
+                keysOut[dst] = keys[i];
+                indicesOut[dst] = indices[i];
+            }
+        });
+        std::swap(keys, keysOut);
+        std::swap(indices, indicesOut);
+        permuted = true;
+        ++m_PassCount;
+    }
+
+    // 结果留在临时数组时交换
+    if (keys != m_Keys.data())
+    {
+        std::swap(m_Keys, m_KeysTemp);
+        std::swap(m_Indices, m_IndicesTemp);
+    }
+}
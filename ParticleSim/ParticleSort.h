@@ -0,0 +1,145 @@
+//***************************************************************************************
+// ParticleSort.h
+//
+// 按视深从远到近排列粒子的并行LSD基数排序，生成Alpha混合所需的绘制顺序
+// Parallel LSD radix sort of particles by view depth, producing the back-to-front draw
+// order that alpha blending needs.
+//***************************************************************************************
+
+#pragma once
+
+#ifndef PARTICLE_SORT_H
+#define PARTICLE_SORT_H
+
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <vector>
+#include "ParticleSimTypes.h"
+#include "ParticleStorage.h"
+#include "ParticleKernels.h"
+
+class JobSystem;
+class ParticleSimCPU;
+class ParticleFrustumCuller;
+
+// 视空间深度 = Dot(axis, posW) + offset
+// 对于行向量约定的视图矩阵V，axis = (V._13, V._23, V._33)，offset = V._43
+struct ParticleDepthPlane
+{
+    Float3 axis = { 0.0f, 0.0f, 1.0f };
+    float offset = 0.0f;
+};
+
+enum class ParticleSortMode
+{
+    Radix,          // 每帧完整的基数排序
+    Coherent,       // 沿用上一帧的顺序并修复，乱序过多时退回基数排序
+};
+
+// 最近一次SortCoherent的统计
+struct ParticleSortStats
+{
+    uint32_t carried = 0;       // 沿用上一帧顺序的粒子数
+    uint32_t inserted = 0;      // 新出现的粒子数，单独排序后归并
+    uint32_t moved = 0;         // 修复时被插入到前面的粒子数
+    uint64_t shifts = 0;        // 插入排序累计移动的距离
+    bool fallback = false;      // 乱序超出预算或无法沿用，改用完整的基数排序
+};
+
+class ParticleDepthSorter
+{
+public:
+    // 每个任务至少处理的元素数，较少时不再拆分
+    static constexpr uint32_t MinBlockSize = 16384;
+    static constexpr uint32_t RadixBits = 8;
+    static constexpr uint32_t RadixSize = 1u << RadixBits;
+    static constexpr uint32_t RadixPasses = 32 / RadixBits;
+    // 沿用的顺序中下降处超过1/MaxDescentRatio时直接退回基数排序
+    static constexpr uint32_t MaxDescentRatio = 8;
+    // 修复连续失败时跳过的帧数依次翻倍，直至该值
+    static constexpr uint32_t MaxBackoffFrames = 16;
+
+    ParticleDepthSorter() = default;
+    ~ParticleDepthSorter() = default;
+    // 不允许拷贝，允许移动
+    ParticleDepthSorter(const ParticleDepthSorter&) = delete;
+    ParticleDepthSorter& operator=(const ParticleDepthSorter&) = delete;
+    ParticleDepthSorter(ParticleDepthSorter&&) = default;
+    ParticleDepthSorter& operator=(ParticleDepthSorter&&) = default;
+
+    // 由闭式轨迹计算sim中全部粒子的视深并排序
+    // 下标对应ExportVertices导出的顺序，不含发射器
+    void Sort(const ParticleSimCPU& sim, const ParticleDepthPlane& plane, JobSystem* jobs = nullptr);
+    // 只对culler最近一次判定可见的粒子排序，复用其求值结果，下标为粒子在culler可见列表中的位置
+    void Sort(const ParticleFrustumCuller& culler, const ParticleDepthPlane& plane, JobSystem* jobs = nullptr);
+    // 按depths从大到小排列[0, count)，深度相同时保持下标顺序
+    // 提供jobs时各趟的直方图统计与分发按块并行
+    void SortDepths(const float* depths, uint32_t count, JobSystem* jobs = nullptr);
+    // 与Sort的结果相同(深度相同的粒子之间顺序可能不同)，利用帧间的连贯性：
+    // 把上一次SortCoherent的顺序换算到当前的粒子上，按当前深度做插入排序修复，新出现的粒子排序后归并
+    // 移动距离之和超过shiftBudget * 粒子数时退回完整的基数排序，连续失败时按指数退避，其间直接做基数排序
+    void SortCoherent(const ParticleSimCPU& sim, const ParticleDepthPlane& plane, JobSystem* jobs = nullptr);
+    void SetShiftBudget(float shiftsPerParticle) { m_ShiftBudget = shiftsPerParticle; }
+    const ParticleSortStats& GetStats() const { return m_Stats; }
+
+    // 绘制顺序，可直接作为索引缓冲区
+    const uint32_t* GetIndices() const { return m_Indices.data(); }
+    uint32_t GetCount() const { return m_Count; }
+    // 排序所用的视深，按ExportVertices的顺序，按culler排序时按其可见列表的顺序
+    const float* GetDepths() const { return m_Depths.data(); }
+    // 上一次排序实际执行的趟数，所有键在某一位上相同时跳过该趟
+    uint32_t GetPassCount() const { return m_PassCount; }
+
+    // 深度越大键越小，按键升序即为从远到近
+    static uint32_t DepthToKey(float depth)
+    {
+        uint32_t bits;
+        std::memcpy(&bits, &depth, sizeof(bits));
+        // 正数翻转符号位，负数翻转全部位，得到随深度递增的无符号整数
+        uint32_t mask = (0u - (bits >> 31)) | 0x80000000u;
+        return ~(bits ^ mask);
+    }
+
+private:
+    void Reserve(uint32_t count);
+    // 按ExportVertices的顺序计算视深，返回粒子数
+    uint32_t ComputeDepths(const ParticleSimCPU& sim, const ParticleDepthPlane& plane, JobSystem* jobs);
+    // 将上一帧顺序中的粒子换算为当前的下标写入m_Keys/m_Indices，返回沿用的粒子数
+    uint32_t CarryPreviousOrder(const ParticleSimCPU& sim, uint32_t count);
+    // 插入排序修复沿用的顺序，超出预算时返回false
+    bool RepairOrder(uint32_t carried, uint64_t budget);
+    // 记录本帧顺序中各粒子的标识，供下一帧沿用
+    void SavePreviousOrder(const ParticleSimCPU& sim);
+
+    uint32_t m_Count = 0;
+    uint32_t m_PassCount = 0;
+    ParticleEvalBuffer m_Eval;
+    AlignedVector<float> m_Depths;
+    AlignedVector<uint32_t> m_Keys;
+    AlignedVector<uint32_t> m_KeysTemp;
+    AlignedVector<uint32_t> m_Indices;
+    AlignedVector<uint32_t> m_IndicesTemp;
+    // [块][基数]的计数，分发前换算为各块的起始位置
+    std::vector<uint32_t> m_Histograms;
+
+    // Pool模式下粒子所在的槽位及各槽位对应的下标(空闲为UINT32_MAX)
+    std::vector<uint32_t> m_Slots;
+    std::vector<uint32_t> m_SlotIndices;
+
+    // 上一帧顺序中的粒子标识：Pool为槽位，BirthRing为环中的位置，Compact为更新前的存储下标
+    const ParticleSimCPU* m_PrevSim = nullptr;
+    ParticleStorageMode m_PrevMode = ParticleStorageMode::Compact;
+    uint32_t m_PrevRingHead = 0;
+    uint32_t m_PrevFrame = 0;                   // 记录顺序时模拟的帧号，Compact的存活标记只对应其后的一次更新
+    std::vector<uint32_t> m_PrevIds;
+    std::vector<uint32_t> m_Remap;
+    std::vector<uint8_t> m_Carried;
+    std::vector<std::pair<uint32_t, uint32_t>> m_NewKeys;
+    float m_ShiftBudget = 4.0f;
+    uint32_t m_Backoff = 0;
+    uint32_t m_SkipFrames = 0;
+    ParticleSortStats m_Stats;
+};
+
+#endif
@@ -0,0 +1,106 @@
+#include "ParticleStateHash.h"
+#include <cstring>
+#include <utility>
+
+namespace
+{
+    constexpr uint64_t Prime1 = 0x9E3779B185EBCA87ull;
+    constexpr uint64_t Prime2 = 0xC2B2AE3D27D4EB4Full;
+
+    uint64_t Rotl(uint64_t x, int r)
+    {
+        return (x << r) | (x >> (64 - r));
+    }
+
+    uint64_t Round(uint64_t state, uint64_t word)
+    {
+        return Rotl(state ^ (word * Prime2), 31) * Prime1;
+    }
+
+    // 最终混合，使每一位输入影响全部输出位
+    uint64_t Avalanche(uint64_t h)
+    {
+        h ^= h >> 33;
+        h *= Prime2;
+        h ^= h >> 29;
+        h *= Prime1;
+        h ^= h >> 32;
+        return h;
+    }
+}
+
+ParticleStateHasher::ParticleStateHasher(uint64_t seed)
+    : m_State(seed ^ Prime1)
+{
+}
+
+void ParticleStateHasher::Add(const void* data, size_t byteSize)
+{
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    size_t i = 0;
+    for (; i + 8 <= byteSize; i += 8)
+    {
+        uint64_t word;
+        std::memcpy(&word, bytes + i, 8);
+        m_State = Round(m_State, word);
+    }
+    // 不足8字节的部分补0，长度在Get中另外混入
+    if (i < byteSize)
+    {
+        uint64_t word = 0;
+        std::memcpy(&word, bytes + i, byteSize - i);
+        m_State = Round(m_State, word);
+    }
+    m_Length += byteSize;
+}
+
+uint64_t ParticleStateHasher::Get() const
+{
+    return Avalanche(Round(m_State, m_Length));
+}
+
+uint64_t ParticleStateHasher::Combine(uint64_t a, uint64_t b)
+{
+    return Avalanche(Round(Round(Prime2, a), b));
+}
+
+void ParticleStateChecker::SetReference(std::vector<ParticleFrameHash> reference)
+{
+    m_Reference = std::move(reference);
+    Clear();
+}
+
+void ParticleStateChecker::Clear()
+{
+    m_Cursor = 0;
+    m_Log.clear();
+    m_Diverged = false;
+    m_FirstDivergentFrame = 0;
+}
+
+bool ParticleStateChecker::Check(uint32_t frame, uint64_t hash)
+{
+    m_Log.push_back({ frame, hash });
+
+    // 帧号通常递增，从上次的位置向后查找，找不到时再从头查找
+    size_t index = m_Cursor;
+    while (index < m_Reference.size() && m_Reference[index].frame != frame)
+        ++index;
+    if (index == m_Reference.size())
+    {
+        for (index = 0; index < m_Cursor && m_Reference[index].frame != frame; ++index)
+            ;
+        if (index == m_Cursor)
+            return true;
+    }
+    m_Cursor = index + 1;
+
+    if (m_Reference[index].hash == hash)
+        return true;
+    if (!m_Diverged)
+    {
+        m_Diverged = true;
+        m_FirstDivergentFrame = frame;
+    }
+    return false;
+}
@@ -0,0 +1,69 @@
+//***************************************************************************************
+// ParticleStateHash.h
+//
+// 模拟状态的64位散列与逐帧比对，用于检查不同线程数、不同运行之间的结果是否逐位相同
+// 64-bit hashes of simulation state and a per-frame checker for detecting divergence
+// between runs or thread counts.
+//***************************************************************************************
+
+#pragma once
+
+#ifndef PARTICLE_STATE_HASH_H
+#define PARTICLE_STATE_HASH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// 按字节内容累积的散列，每次处理8字节，结果只取决于输入的字节序列
+class ParticleStateHasher
+{
+public:
+    explicit ParticleStateHasher(uint64_t seed = 0);
+
+    void Add(const void* data, size_t byteSize);
+    template<class T>
+    void AddValue(const T& value) { Add(&value, sizeof(T)); }
+
+    uint64_t Get() const;
+
+    // 按顺序合并两个散列，交换顺序结果不同
+    static uint64_t Combine(uint64_t a, uint64_t b);
+
+private:
+    uint64_t m_State;
+    uint64_t m_Length = 0;
+};
+
+struct ParticleFrameHash
+{
+    uint32_t frame;
+    uint64_t hash;
+};
+
+// 逐帧记录状态散列，设置参考序列后同时与其中同一帧的值比较，记录第一次不一致的帧
+class ParticleStateChecker
+{
+public:
+    // 为空时只记录；参考中没有的帧不参与比较
+    void SetReference(std::vector<ParticleFrameHash> reference);
+    const std::vector<ParticleFrameHash>& GetReference() const { return m_Reference; }
+    void Clear();
+
+    // 记录一帧的散列，与参考不一致时返回false
+    bool Check(uint32_t frame, uint64_t hash);
+
+    const std::vector<ParticleFrameHash>& GetLog() const { return m_Log; }
+    bool HasDiverged() const { return m_Diverged; }
+    // 第一次不一致的帧号，尚未不一致时无意义
+    uint32_t GetFirstDivergentFrame() const { return m_FirstDivergentFrame; }
+
+private:
+    std::vector<ParticleFrameHash> m_Reference;
+    size_t m_Cursor = 0;                // 参考序列中下一次比较开始查找的位置，帧号递增时无需从头查找
+    std::vector<ParticleFrameHash> m_Log;
+    bool m_Diverged = false;
+    uint32_t m_FirstDivergentFrame = 0;
+};
+
+#endif
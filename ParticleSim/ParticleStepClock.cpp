@@ -0,0 +1,49 @@
+#include "ParticleStepClock.h"
+#include <algorithm>
+#include <cmath>
+
+void ParticleStepClock::Reset()
+{
+    m_Accumulator = 0.0;
+    m_SimTime = 0.0;
+    m_FrameStart = 0.0;
+    m_FrameDelta = 0.0f;
+    m_StepCount = 0;
+    m_DroppedTime = 0.0;
+}
+
+uint32_t ParticleStepClock::Advance(float dt)
+{
+    m_FrameStart = m_SimTime;
+    m_FrameDelta = dt;
+    if (!IsFixed())
+    {
+        m_SimTime += dt;
+        ++m_StepCount;
+        return 1;
+    }
+
+    // 累积量以double保存，长时间运行时余量不丢失精度
+    m_Accumulator += std::max(dt, 0.0f);
+    const double whole = std::floor(m_Accumulator / m_Step);
+    uint32_t steps = static_cast<uint32_t>(std::min(whole, static_cast<double>(m_MaxSteps)));
+    if (whole > steps)
+        m_DroppedTime += (whole - steps) * m_Step;
+    // 丢弃多余的整步，只保留不足一步的余量
+    m_Accumulator -= whole * m_Step;
+    m_SimTime += static_cast<double>(steps) * m_Step;
+    m_StepCount += steps;
+    return steps;
+}
+
+float ParticleStepClock::GetStepTime(uint32_t i) const
+{
+    return static_cast<float>(m_FrameStart + static_cast<double>(i + 1) * GetStepDelta());
+}
+
+float ParticleStepClock::GetAlpha() const
+{
+    if (!IsFixed() || m_StepCount == 0)
+        return 1.0f;
+    return static_cast<float>(std::min(std::max(m_Accumulator / m_Step, 0.0), 1.0));
+}
@@ -0,0 +1,57 @@
+//***************************************************************************************
+// ParticleStepClock.h
+//
+// 固定步长的模拟时钟：把可变的帧间隔累积为整数个模拟步，限制单帧追赶的步数，给出绘制时的插值位置
+// Fixed-step simulation clock that turns variable frame times into whole simulation steps,
+// caps per-frame catch-up and reports the interpolation point for rendering.
+//***************************************************************************************
+
+#pragma once
+
+#ifndef PARTICLE_STEP_CLOCK_H
+#define PARTICLE_STEP_CLOCK_H
+
+#include <cstdint>
+
+class ParticleStepClock
+{
+public:
+    // step不大于0时不使用固定步长：每帧恰好一步，步长即帧间隔
+    void SetStep(float step) { m_Step = step; }
+    float GetStep() const { return m_Step; }
+    bool IsFixed() const { return m_Step > 0.0f; }
+    // 单帧最多推进的步数，卡顿时超出的时间被丢弃而不是之后补上，避免越积越多
+    void SetMaxSteps(uint32_t maxSteps) { m_MaxSteps = maxSteps > 0 ? maxSteps : 1; }
+    uint32_t GetMaxSteps() const { return m_MaxSteps; }
+
+    void Reset();
+    // 累积一帧的时间，返回本帧应推进的步数，之后依次以GetStepTime(i)为各步结束时的模拟时刻
+    uint32_t Advance(float dt);
+
+    // 本帧第i步的步长与结束时的模拟时刻
+    float GetStepDelta() const { return IsFixed() ? m_Step : m_FrameDelta; }
+    float GetStepTime(uint32_t i) const;
+    // 最后一步结束时的模拟时刻
+    double GetSimTime() const { return m_SimTime; }
+
+    // 插值系数：绘制的时刻位于上一步与最后一步之间的比例，尚未模拟过时为1
+    float GetAlpha() const;
+    // 绘制的时刻落后于最后一步的时长，即(1 - alpha) * step
+    float GetRenderLag() const { return (1.0f - GetAlpha()) * GetStepDelta(); }
+
+    // 因超出MaxSteps累计丢弃的时间
+    double GetDroppedTime() const { return m_DroppedTime; }
+
+private:
+    float m_Step = 0.0f;
+    uint32_t m_MaxSteps = 4;
+
+    double m_Accumulator = 0.0;
+    double m_SimTime = 0.0;
+    double m_FrameStart = 0.0;
+    float m_FrameDelta = 0.0f;
+    uint64_t m_StepCount = 0;
+    double m_DroppedTime = 0.0;
+};
+
+#endif
@@ -0,0 +1,196 @@
+#include "ParticleStorage.h"
+#include <cassert>
+#include <cstring>
+
+void ParticleStorage::Reserve(uint32_t capacity)
+{
+    // 向上补齐到缓存行，SIMD处理尾部时可以整块读写
+    constexpr uint32_t floatsPerLine = ParticleCacheLineSize / sizeof(float);
+    uint32_t padded = (capacity + floatsPerLine - 1) / floatsPerLine * floatsPerLine;
+
+    m_Capacity = capacity;
+    m_Size = 0;
+    for (AlignedVector<float>& channel : m_Floats)
+        channel.assign(padded, 0.0f);
+    for (AlignedVector<uint8_t>& channel : m_Bytes)
+        channel.assign(padded, 0);
+    for (AlignedVector<uint32_t>& channel : m_Uints)
+        channel.assign(padded, 0);
+}
+
+void ParticleStorage::Resize(uint32_t newSize)
+{
+    assert(newSize <= m_Capacity);
+    m_Size = newSize;
+}
+
+bool ParticleStorage::Append(const ParticleVertex& v)
+{
+    if (m_Size >= m_Capacity)
+        return false;
+    Store(m_Size++, v);
+    return true;
+}
+
+ParticleVertex ParticleStorage::Load(uint32_t index) const
+{
+    // 按属性声明在编译期展开，每个分量直接从对应通道读取
+    ParticleVertex v;
+    unsigned char* dst = reinterpret_cast<unsigned char*>(&v);
+    ParticleVertexSchema::ForEachAttribute([&](auto i) {
+        constexpr ParticleAttribute a = ParticleVertexSchema::Attributes[i];
+        constexpr uint32_t first = ParticleVertexSchema::GetFirstChannel(i);
+        for (uint32_t c = 0; c < a.componentCount; ++c)
+        {
+            uint32_t bits;
+            if constexpr (a.storage == ParticleAttributeStorage::Float)
+                std::memcpy(&bits, &m_Floats[first + c][index], sizeof(bits));
+            else if constexpr (a.storage == ParticleAttributeStorage::Byte)
+                bits = m_Bytes[first + c][index];
+            else
+                bits = m_Uints[first + c][index];
+            std::memcpy(dst + a.offset + c * sizeof(bits), &bits, sizeof(bits));
+        }
+    });
+    return v;
+}
+
+void ParticleStorage::Store(uint32_t index, const ParticleVertex& v)
+{
+    const unsigned char* src = reinterpret_cast<const unsigned char*>(&v);
+    ParticleVertexSchema::ForEachAttribute([&](auto i) {
+        constexpr ParticleAttribute a = ParticleVertexSchema::Attributes[i];
+        constexpr uint32_t first = ParticleVertexSchema::GetFirstChannel(i);
+        for (uint32_t c = 0; c < a.componentCount; ++c)
+        {
+            uint32_t bits;
+            std::memcpy(&bits, src + a.offset + c * sizeof(bits), sizeof(bits));
+            if constexpr (a.storage == ParticleAttributeStorage::Float)
+                std::memcpy(&m_Floats[first + c][index], &bits, sizeof(bits));
+            else if constexpr (a.storage == ParticleAttributeStorage::Byte)
+                m_Bytes[first + c][index] = static_cast<uint8_t>(bits);
+            else
+                m_Uints[first + c][index] = bits;
+        }
+    });
+}
+
+void ParticleStorage::Move(uint32_t dst, uint32_t src)
+{
+    for (AlignedVector<float>& channel : m_Floats)
+        channel[dst] = channel[src];
+    for (AlignedVector<uint8_t>& channel : m_Bytes)
+        channel[dst] = channel[src];
+    for (AlignedVector<uint32_t>& channel : m_Uints)
+        channel[dst] = channel[src];
+}
+
+void ParticleStorage::CopyFrom(uint32_t dst, const ParticleStorage& other, uint32_t src)
+{
+    for (uint32_t c = 0; c < FloatChannelCount; ++c)
+        m_Floats[c][dst] = other.m_Floats[c][src];
+    for (uint32_t c = 0; c < ByteChannelCount; ++c)
+        m_Bytes[c][dst] = other.m_Bytes[c][src];
+    for (uint32_t c = 0; c < UintChannelCount; ++c)
+        m_Uints[c][dst] = other.m_Uints[c][src];
+}
+
+void ParticleStorage::CopyRange(uint32_t dst, const ParticleStorage& other, uint32_t src, uint32_t count)
+{
+    for (uint32_t c = 0; c < FloatChannelCount; ++c)
+        std::memcpy(m_Floats[c].data() + dst, other.m_Floats[c].data() + src, count * sizeof(float));
+    for (uint32_t c = 0; c < ByteChannelCount; ++c)
+        std::memcpy(m_Bytes[c].data() + dst, other.m_Bytes[c].data() + src, count * sizeof(uint8_t));
+    for (uint32_t c = 0; c < UintChannelCount; ++c)
+        std::memcpy(m_Uints[c].data() + dst, other.m_Uints[c].data() + src, count * sizeof(uint32_t));
+}
+
+void ParticleStorage::Import(const ParticleVertex* vertices, uint32_t count)
+{
+    m_Size = count < m_Capacity ? count : m_Capacity;
+    for (uint32_t i = 0; i < m_Size; ++i)
+        Store(i, vertices[i]);
+}
+
+void ParticleStorage::Export(ParticleVertex* vertices, uint32_t first, uint32_t count) const
+{
+    for (uint32_t i = 0; i < count; ++i)
+        vertices[i] = Load(first + i);
+}
+
+namespace
+{
+    // 序列化数据的头部，之后依次是各属性各分量的数组
+    struct SerializedHeader
+    {
+        uint32_t magic;
+        uint32_t signature;
+        uint32_t count;
+    };
+
+    constexpr uint32_t SerializedMagic = 0x31565350u;     // "PSV1"
+}
+
+void ParticleStorage::Serialize(std::vector<uint8_t>& bytes, uint32_t first, uint32_t count) const
+{
+    assert(first + count <= m_Size);
+    const SerializedHeader header = { SerializedMagic, ParticleVertexSchema::GetSignature(), count };
+    size_t offset = bytes.size();
+    bytes.resize(offset + sizeof(header) + static_cast<size_t>(count) * SerializedParticleSize);
+    std::memcpy(bytes.data() + offset, &header, sizeof(header));
+    offset += sizeof(header);
+
+    auto write = [&bytes, &offset, first, count](const auto& channel) {
+        size_t byteSize = count * sizeof(channel[0]);
+        std::memcpy(bytes.data() + offset, channel.data() + first, byteSize);
+        offset += byteSize;
+    };
+    ParticleVertexSchema::ForEachAttribute([&](auto i) {
+        constexpr ParticleAttribute a = ParticleVertexSchema::Attributes[i];
+        constexpr uint32_t channel = ParticleVertexSchema::GetFirstChannel(i);
+        for (uint32_t c = 0; c < a.componentCount; ++c)
+        {
+            if constexpr (a.storage == ParticleAttributeStorage::Float)
+                write(m_Floats[channel + c]);
+            else if constexpr (a.storage == ParticleAttributeStorage::Byte)
+                write(m_Bytes[channel + c]);
+            else
+                write(m_Uints[channel + c]);
+        }
+    });
+}
+
+bool ParticleStorage::Deserialize(const uint8_t* bytes, size_t byteSize)
+{
+    SerializedHeader header;
+    if (byteSize < sizeof(header))
+        return false;
+    std::memcpy(&header, bytes, sizeof(header));
+    if (header.magic != SerializedMagic || header.signature != ParticleVertexSchema::GetSignature() ||
+        header.count > m_Capacity ||
+        byteSize != sizeof(header) + static_cast<size_t>(header.count) * SerializedParticleSize)
+        return false;
+
+    const uint32_t count = header.count;
+    size_t offset = sizeof(header);
+    auto read = [bytes, &offset, count](auto& channel) {
+        size_t channelBytes = count * sizeof(channel[0]);
+        std::memcpy(channel.data(), bytes + offset, channelBytes);
+        offset += channelBytes;
+    };
+    ParticleVertexSchema::ForEachAttribute([&](auto i) {
+        constexpr ParticleAttribute a = ParticleVertexSchema::Attributes[i];
+        constexpr uint32_t channel = ParticleVertexSchema::GetFirstChannel(i);
+        for (uint32_t c = 0; c < a.componentCount; ++c)
+        {
+            if constexpr (a.storage == ParticleAttributeStorage::Float)
+                read(m_Floats[channel + c]);
+            else if constexpr (a.storage == ParticleAttributeStorage::Byte)
+                read(m_Bytes[channel + c]);
+            else
+                read(m_Uints[channel + c]);
+        }
+    });
+    m_Size = count;
+    return true;
+}
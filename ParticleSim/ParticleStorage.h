@@ -0,0 +1,159 @@
+//***************************************************************************************
+// ParticleStorage.h
+//
+// 结构数组(SoA)形式的粒子存储，每帧变化的热数据与发射时确定的冷数据分开存放
+// Structure-of-arrays particle storage with per-frame (hot) data kept apart from
+// spawn-time (cold) data.
+//***************************************************************************************
+
+#pragma once
+
+#ifndef PARTICLE_STORAGE_H
+#define PARTICLE_STORAGE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <vector>
+#include "ParticleSimTypes.h"
+#include "ParticleSchema.h"
+
+// 按Align字节对齐分配内存的分配器
+template<class T, size_t Align>
+struct AlignedAllocator
+{
+    using value_type = T;
+
+    template<class U>
+    struct rebind { using other = AlignedAllocator<U, Align>; };
+
+    AlignedAllocator() = default;
+    template<class U>
+    AlignedAllocator(const AlignedAllocator<U, Align>&) noexcept {}
+
+    T* allocate(size_t n)
+    {
+        return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(Align)));
+    }
+
+    void deallocate(T* p, size_t) noexcept
+    {
+        ::operator delete(p, std::align_val_t(Align));
+    }
+
+    template<class U>
+    bool operator==(const AlignedAllocator<U, Align>&) const noexcept { return true; }
+    template<class U>
+    bool operator!=(const AlignedAllocator<U, Align>&) const noexcept { return false; }
+};
+
+// 以缓存行对齐
+constexpr size_t ParticleCacheLineSize = 64;
+
+template<class T>
+using AlignedVector = std::vector<T, AlignedAllocator<T, ParticleCacheLineSize>>;
+
+// 按语义查询属性第一个分量的通道编号
+constexpr uint32_t GetSchemaChannel(const char* semantic)
+{
+    return ParticleVertexSchema::GetFirstChannel(static_cast<uint32_t>(ParticleVertexSchema::FindAttribute(semantic)));
+}
+
+constexpr uint32_t GetSchemaComponentCount(const char* semantic)
+{
+    return ParticleVertexSchema::Attributes[ParticleVertexSchema::FindAttribute(semantic)].componentCount;
+}
+
+// 浮点属性通道，编号直接取自ParticleVertexSchema，这里只为代码中按名称访问分量
+enum class ParticleChannel : uint32_t
+{
+    // 冷数据：发射时写入，之后只读
+    PosX = GetSchemaChannel("POSITION"), PosY, PosZ,
+    VelX = GetSchemaChannel("VELOCITY"), VelY, VelZ,
+    AccelX = GetSchemaChannel("ACCEL"), AccelY, AccelZ,
+    SizeX = GetSchemaChannel("SIZE"), SizeY,
+    // 热数据：每帧更新
+    Age = GetSchemaChannel("AGE"),
+    Count = ParticleVertexSchema::GetChannelCount(ParticleAttributeStorage::Float)
+};
+// 按分量命名的常量只在分量数变化时需要改动
+static_assert(GetSchemaComponentCount("POSITION") == 3 && GetSchemaComponentCount("VELOCITY") == 3 &&
+    GetSchemaComponentCount("ACCEL") == 3 && GetSchemaComponentCount("SIZE") == 2 && GetSchemaComponentCount("AGE") == 1,
+    "ParticleChannel component names must follow ParticleVertexSchema");
+
+class ParticleStorage
+{
+public:
+    // 各类通道的数目均由ParticleVertexSchema生成，只为声明的分量分配内存
+    static constexpr uint32_t FloatChannelCount = ParticleVertexSchema::GetChannelCount(ParticleAttributeStorage::Float);
+    static constexpr uint32_t ByteChannelCount = ParticleVertexSchema::GetChannelCount(ParticleAttributeStorage::Byte);
+    static constexpr uint32_t UintChannelCount = ParticleVertexSchema::GetChannelCount(ParticleAttributeStorage::Uint);
+
+    ParticleStorage() = default;
+    ~ParticleStorage() = default;
+    // 不允许拷贝，允许移动
+    ParticleStorage(const ParticleStorage&) = delete;
+    ParticleStorage& operator=(const ParticleStorage&) = delete;
+    ParticleStorage(ParticleStorage&&) = default;
+    ParticleStorage& operator=(ParticleStorage&&) = default;
+
+    // 分配全部容量，之后不再分配内存
+    void Reserve(uint32_t capacity);
+    uint32_t GetCapacity() const { return m_Capacity; }
+    uint32_t GetSize() const { return m_Size; }
+    bool IsFull() const { return m_Size >= m_Capacity; }
+
+    void Clear() { m_Size = 0; }
+    // newSize不能超过容量，新增元素的内容未定义
+    void Resize(uint32_t newSize);
+
+    // 容量已满时返回false
+    bool Append(const ParticleVertex& v);
+
+    ParticleVertex Load(uint32_t index) const;
+    void Store(uint32_t index, const ParticleVertex& v);
+    // 将src处的粒子复制到dst处
+    void Move(uint32_t dst, uint32_t src);
+    // 将另一存储中的粒子复制到本存储的dst处
+    void CopyFrom(uint32_t dst, const ParticleStorage& other, uint32_t src);
+    // 将另一存储中[src, src + count)的粒子整段复制到本存储的dst处
+    void CopyRange(uint32_t dst, const ParticleStorage& other, uint32_t src, uint32_t count);
+
+    // 与ParticleVertex(AoS)布局互相转换
+    void Import(const ParticleVertex* vertices, uint32_t count);
+    void Export(ParticleVertex* vertices, uint32_t first, uint32_t count) const;
+
+    // 将[first, first + count)的粒子按属性声明的顺序追加到bytes，每个分量按存储宽度连续存放
+    void Serialize(std::vector<uint8_t>& bytes, uint32_t first, uint32_t count) const;
+    // 以Serialize的结果替换全部粒子，属性签名或数据大小不符时返回false且不修改存储
+    bool Deserialize(const uint8_t* bytes, size_t byteSize);
+    // 序列化后每个粒子占用的字节数
+    static constexpr uint32_t SerializedParticleSize = FloatChannelCount * 4 + ByteChannelCount + UintChannelCount * 4;
+
+    //
+    // 属性数组
+    //
+
+    float* GetChannel(ParticleChannel channel) { return m_Floats[static_cast<size_t>(channel)].data(); }
+    const float* GetChannel(ParticleChannel channel) const { return m_Floats[static_cast<size_t>(channel)].data(); }
+
+    float* GetAges() { return GetChannel(ParticleChannel::Age); }
+    const float* GetAges() const { return GetChannel(ParticleChannel::Age); }
+    uint8_t* GetTypes() { return m_Bytes[TypeChannel].data(); }
+    const uint8_t* GetTypes() const { return m_Bytes[TypeChannel].data(); }
+    uint32_t* GetEmitCounts() { return m_Uints[EmitCountChannel].data(); }
+    const uint32_t* GetEmitCounts() const { return m_Uints[EmitCountChannel].data(); }
+
+private:
+    static constexpr uint32_t TypeChannel = GetSchemaChannel("TYPE");
+    static constexpr uint32_t EmitCountChannel = GetSchemaChannel("EMIT_COUNT");
+
+    uint32_t m_Capacity = 0;
+    uint32_t m_Size = 0;
+
+    AlignedVector<float> m_Floats[FloatChannelCount];
+    AlignedVector<uint8_t> m_Bytes[ByteChannelCount];       // 热数据，PT_*只需8位
+    AlignedVector<uint32_t> m_Uints[UintChannelCount];      // 仅发射器/壳/火焰粒子会修改
+};
+
+#endif
@@ -0,0 +1,25 @@
+#include "ParticleSystem.h"
+
+const ParticleSystemKernels& GetParticleSystemKernels(ParticleEffectType effectType)
+{
+    switch (effectType)
+    {
+    case ParticleEffectType::Smoke: return SmokeSystem::Kernels;
+    case ParticleEffectType::FireSmoke: return FireSmokeSystem::Kernels;
+    case ParticleEffectType::Boom: return BoomSystem::Kernels;
+    case ParticleEffectType::Fountain: return FountainSystem::Kernels;
+    default: return FireSystem::Kernels;
+    }
+}
+
+ParticleAppearanceTable GetParticleAppearance(ParticleEffectType effectType, const ParticleSimParams& params)
+{
+    return GetParticleSystemKernels(effectType).appearance(params);
+}
+
+ParticleSystemBounds ComputeParticleSystemBounds(ParticleEffectType effectType, const ParticleSimParams& params,
+    const Float3& emitterPos, const ParticleEmitterTable* table, const std::vector<SubEmitterDesc>& subEmitters,
+    const ParticleSpawnRange* live)
+{
+    return GetParticleSystemKernels(effectType).bounds(params, emitterPos, table, subEmitters, live);
+}
@@ -0,0 +1,685 @@
+//***************************************************************************************
+// ParticleSystem.h
+//
+// 由生成、寿命与外观三种策略组合成的特效，每种特效在编译期展开为不含类型分支的更新循环
+// Effects composed of spawn, lifetime and appearance policies; each effect compiles
+// into its own update loops without runtime effect branches.
+//***************************************************************************************
+
+#pragma once
+
+#ifndef PARTICLE_SYSTEM_H
+#define PARTICLE_SYSTEM_H
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include "ParticleSimCPU.h"
+
+// 对应FountainRandomTex：将[-1, 1)的均匀随机数映射为绕+y轴半角30度圆锥内的单位方向
+inline Float3 ConeDirection(const Float3& u)
+{
+    // 与GameApp生成FountainRandomTex的方式相同，归一化后半径r不再起作用
+    constexpr float Pi = 3.14159265f;
+    const float cosConeAngle = std::cos(Pi / 6.0f);
+    float phi = Pi * (u.x + 1.0f);
+    float cosTheta = cosConeAngle + (1.0f - cosConeAngle) * 0.5f * (u.y + 1.0f);
+    float sinTheta = std::sqrt(1.0f - cosTheta * cosTheta);
+    return { sinTheta * std::cos(phi), cosTheta, sinTheta * std::sin(phi) };
+}
+
+// ConeDirection各分量的范围
+inline ParticleBounds ConeDirectionBounds()
+{
+    constexpr float Pi = 3.14159265f;
+    const float sinConeAngle = std::sin(Pi / 6.0f);
+    return ParticleBounds::Range({ -sinConeAngle, std::cos(Pi / 6.0f), -sinConeAngle }, { sinConeAngle, 1.0f, sinConeAngle });
+}
+
+// [-1, 1]^3
+inline ParticleBounds UnitCubeBounds()
+{
+    return ParticleBounds::Range({ -1.0f, -1.0f, -1.0f }, { 1.0f, 1.0f, 1.0f });
+}
+
+//
+// 生成策略：发射器产生的粒子，对应SO_GS中PT_EMITTER的分支
+// Transform将[-1, 1)的随机向量变换为粒子的速度(RandomAccel时为加速度)，TransformBounds为其结果的范围
+//
+
+// Fire：xz方向减半的随机方向
+struct FlameSpawn
+{
+    static constexpr bool Shells = false;
+    static constexpr bool RandomAccel = false;
+    static constexpr float Size = 3.0f;
+    // g_DefaultParticleCount超过该值时暂停发射
+    static constexpr uint32_t PauseAbove = UINT32_MAX;
+
+    static Float3 Transform(const Float3& u)
+    {
+        Float3 r = Normalize(u);
+        r.x *= 0.5f;
+        r.z *= 0.5f;
+        return 4.0f * r;
+    }
+    static ParticleBounds TransformBounds() { return ParticleBounds::Range({ -2.0f, -4.0f, -2.0f }, { 2.0f, 4.0f, 2.0f }); }
+};
+
+// FireSmoke：与Fire相同，但粒子过多时暂停
+struct SmokingFlameSpawn : FlameSpawn
+{
+    static constexpr uint32_t PauseAbove = 300;
+};
+
+// Fountain：圆锥内的方向
+struct FountainSpawn
+{
+    static constexpr bool Shells = false;
+    static constexpr bool RandomAccel = false;
+    static constexpr float Size = 1.0f;
+    static constexpr uint32_t PauseAbove = UINT32_MAX;
+
+    static Float3 Transform(const Float3& u) { return 4.0f * (1.5f * ConeDirection(u)); }
+    static ParticleBounds TransformBounds() { return ScaleBounds(ConeDirectionBounds(), 6.0f); }
+};
+
+// Smoke：随机量作为加速度的缩放，初速度为0
+struct SmokeSpawn
+{
+    static constexpr bool Shells = false;
+    static constexpr bool RandomAccel = true;
+    static constexpr float Size = 3.0f;
+    static constexpr uint32_t PauseAbove = UINT32_MAX;
+
+    static Float3 Transform(const Float3& u) { return ConeDirection(u); }
+    static ParticleBounds TransformBounds() { return ConeDirectionBounds(); }
+};
+
+// Boom：发射器每帧发射8个壳，共发射32个后移除，与发射方式无关
+// 壳由FillSpawnRequests成批写入，加速度为[-1, 1)的随机向量乘以AccelScale
+struct ShellSpawn
+{
+    static constexpr bool Shells = true;
+    static constexpr bool RandomAccel = false;
+    static constexpr float Size = 2.5f;
+    static constexpr uint32_t PauseAbove = UINT32_MAX;
+    static constexpr uint32_t ShellsPerFrame = 8;
+    static constexpr uint32_t ShellCount = 32;
+    static constexpr float AccelScale = 50.0f;
+
+    static Float3 Transform(const Float3& u) { return u; }
+    static ParticleBounds TransformBounds() { return UnitCubeBounds(); }
+};
+
+//
+// 寿命策略：粒子按存活时间消亡的规则，对应SO_GS中其余类型的分支
+//
+
+// Fire/Fountain/Smoke：所有粒子寿命相同，只读取存活时间
+struct UniformLife
+{
+    static constexpr bool Uniform = true;
+    static constexpr bool ShellBursts = false;
+
+    static float Lifetime(uint32_t, const ParticleSimParams& params) { return params.aliveTime; }
+};
+
+// FireSmoke：烟雾的寿命是火焰的3倍
+struct SmokeTrailLife
+{
+    static constexpr bool Uniform = false;
+    static constexpr bool ShellBursts = false;
+
+    static float Lifetime(uint32_t type, const ParticleSimParams& params)
+    {
+        return type == PT_SMOKE ? params.aliveTime * 3.0f : params.aliveTime;
+    }
+};
+
+// Boom：壳不按存活时间消亡，到达爆炸点后每帧散开16个粒子，共发射超过128个后移除
+// 散开的粒子加速度为[-1, 1)的随机向量乘以AccelScale
+struct ShellBurstLife
+{
+    static constexpr bool Uniform = false;
+    static constexpr bool ShellBursts = true;
+    static constexpr uint32_t ParticlesPerBurst = 16;
+    static constexpr uint32_t MaxBurstParticles = 128;
+    static constexpr float AccelScale = 25.0f;
+
+    static float Lifetime(uint32_t type, const ParticleSimParams& params)
+    {
+        return type == PT_SHELL ? FLT_MAX : params.aliveTime;
+    }
+};
+
+//
+// 外观策略：与各特效着色器一致的位置、透明度与尺寸参数，写入PT_PARTICLE的加速度缩放之后的其余部分
+//
+
+struct FireAppearance
+{
+    static void Apply(ParticleAppearanceTable& table, const ParticleSimParams&)
+    {
+        table.types[PT_PARTICLE].sizeAgeSlope = -0.2f;
+    }
+};
+
+struct FountainAppearance
+{
+    static void Apply(ParticleAppearanceTable& table, const ParticleSimParams&)
+    {
+        table.types[PT_PARTICLE].opacityRange = 2.0f;
+    }
+};
+
+struct SmokeAppearance
+{
+    static void Apply(ParticleAppearanceTable& table, const ParticleSimParams&)
+    {
+        // 粒子accel为g_AccelW的逐分量缩放，透明度恒定
+        ParticleAppearance& particle = table.types[PT_PARTICLE];
+        particle.perParticleAccel = true;
+        particle.opacityBase = 0.5f;
+        particle.opacityRange = 0.0f;
+        particle.sizeScale = 0.0f;
+        particle.sizeAgeSlope = 0.25f;
+        particle.sizeBias = 0.1f;
+    }
+};
+
+struct BoomAppearance
+{
+    static void Apply(ParticleAppearanceTable& table, const ParticleSimParams& params)
+    {
+        // 粒子与壳都只使用自身的accel，壳停在爆炸点
+        ParticleAppearance& particle = table.types[PT_PARTICLE];
+        particle.accelScale = { 1.0f, 1.0f, 1.0f };
+        particle.perParticleAccel = true;
+        particle.opacityRange = 0.5f;
+        ParticleAppearance& shell = table.types[PT_SHELL];
+        shell = particle;
+        shell.maxTime = params.emitInterval;
+    }
+};
+
+struct FireSmokeAppearance
+{
+    static void Apply(ParticleAppearanceTable& table, const ParticleSimParams& params)
+    {
+        ParticleAppearance& particle = table.types[PT_PARTICLE];
+        particle.opacityMin = 0.1f;
+        particle.sizeAgeSlope = -0.2f;
+        ParticleAppearance& smoke = table.types[PT_SMOKE];
+        smoke.accelScale = params.accel * 0.2f;
+        smoke.opacityBase = 0.6f;
+        smoke.opacityRange = 20.0f;
+        smoke.opacityMin = 0.1f;
+        smoke.sizeScale = 0.0f;
+        smoke.sizeAgeSlope = 0.25f;
+        smoke.sizeBias = 1.0f;
+    }
+};
+
+// ParticleSimCPU按特效类型在Init时选定的函数表，每帧每块只经过一次间接调用
+struct ParticleSystemKernels
+{
+    // 更新[begin, end)内粒子的存活标记，壳散开的粒子以请求的形式追加到requests
+    void (*updateLifetimes)(ParticleSimCPU& sim, uint32_t begin, uint32_t end,
+        std::vector<ParticleSimCPU::SpawnRequest>& requests);
+    void (*updateEmitter)(ParticleSimCPU& sim);
+    // 将本帧批次中[first, first + count)的粒子以SoA形式写到target的offset处
+    void (*emitBatch)(const ParticleSimCPU& sim, ParticleStorage& target, uint32_t offset, uint32_t first, uint32_t count);
+    // 发射器表：统计本帧各发射器发射的数目(壳为请求)，再将批次中[first, first + count)的粒子写到target的offset处
+    void (*updateEmitterTable)(ParticleSimCPU& sim);
+    void (*emitTable)(const ParticleSimCPU& sim, ParticleStorage& target, uint32_t offset, uint32_t first, uint32_t count);
+    // 发射器与发射器表自重置起经过frames帧后的状态(帧间隔为m_TimeStep)
+    void (*skipEmitters)(ParticleSimCPU& sim, uint64_t frames);
+    float (*lifetime)(uint32_t type, const ParticleSimParams& params);
+    ParticleAppearanceTable (*appearance)(const ParticleSimParams& params);
+    ParticleSystemBounds (*bounds)(const ParticleSimParams& params, const Float3& emitterPos,
+        const ParticleEmitterTable* table, const std::vector<SubEmitterDesc>& subEmitters, const ParticleSpawnRange* live);
+    bool uniformLifetime;       // 可使用BirthRing存储
+};
+
+// 特效的全部规则由三个策略在编译期确定，不保存状态
+template<class SpawnPolicy, class LifePolicy, class AppearancePolicy>
+class ParticleSystem
+{
+public:
+    using Spawn = SpawnPolicy;
+    using Life = LifePolicy;
+    using Appearance = AppearancePolicy;
+    using SpawnRequest = ParticleSimCPU::SpawnRequest;
+
+    static const ParticleSystemKernels Kernels;
+
+    static void UpdateLifetimes(ParticleSimCPU& sim, uint32_t begin, uint32_t end, std::vector<SpawnRequest>& requests)
+    {
+        const ParticleSimParams& params = sim.m_Params;
+        const float* ages = sim.m_Particles.GetAges();
+        const uint8_t* types = sim.m_Particles.GetTypes();
+        uint8_t* alive = sim.m_Alive.data();
+
+        if constexpr (Life::ShellBursts)
+        {
+            const float interval = params.emitInterval;
+            uint32_t* emitCounts = sim.m_Particles.GetEmitCounts();
+            for (uint32_t i = begin; i < end; ++i)
+            {
+                if (types[i] != PT_SHELL)
+                {
+                    alive[i] = ages[i] <= params.aliveTime;
+                    continue;
+                }
+                if (ages[i] <= interval)
+                {
+                    alive[i] = 1;
+                    continue;
+                }
+
+                // 这里只记录请求，粒子在压缩时成批写入
+                ParticleVertex shell = sim.m_Particles.Load(i);
+                float t = interval;
+                Float3 posW = 0.5f * t * t * shell.accel * params.accel + t * shell.initialVel + shell.initialPos;
+                requests.push_back({ posW, i, 0, Life::ParticlesPerBurst, PT_PARTICLE });
+                emitCounts[i] += Life::ParticlesPerBurst;
+                alive[i] = emitCounts[i] <= Life::MaxBurstParticles;
+            }
+        }
+        else if constexpr (Life::Uniform)
+        {
+            // 只读取热数据
+            const float aliveTime = params.aliveTime;
+            for (uint32_t i = begin; i < end; ++i)
+                alive[i] = ages[i] <= aliveTime;
+        }
+        else
+        {
+            for (uint32_t i = begin; i < end; ++i)
+                alive[i] = ages[i] <= Life::Lifetime(types[i], params);
+        }
+    }
+
+    static void UpdateEmitter(ParticleSimCPU& sim)
+    {
+        ParticleVertex& v = sim.m_Emitter;
+        if constexpr (Spawn::Shells)
+        {
+            // 以壳的序号为index生成随机数
+            v.age += sim.m_TimeStep;
+            sim.m_EmitterRequests.push_back({ v.initialPos, ParticleSimCPU::EmitterRandomId, v.emitCount,
+                Spawn::ShellsPerFrame, PT_SHELL });
+            v.emitCount += Spawn::ShellsPerFrame;
+            sim.m_HasEmitter = v.emitCount < Spawn::ShellCount;
+        }
+        else
+        {
+            const bool paused = sim.m_Params.defaultParticleCount > Spawn::PauseAbove;
+            if (sim.m_EmissionMode == EmissionMode::Accumulated)
+            {
+                sim.UpdateEmitterAccumulated(paused);
+                return;
+            }
+
+            // 是否到时间发射新的粒子，暂停期间累计时间照常增加
+            v.age += sim.m_TimeStep;
+            if (v.age <= sim.m_Params.emitInterval || paused)
+                return;
+
+            ParticleVertex p{};
+            p.initialPos = sim.m_Params.emitPos;
+            p.type = PT_PARTICLE;
+            p.size = { Spawn::Size, Spawn::Size };
+            Float3 r = Spawn::Transform(sim.RandVec3(ParticleSimCPU::EmitterRandomId, RandomStream));
+            if constexpr (Spawn::RandomAccel)
+                p.accel = r;
+            else
+                p.initialVel = r;
+            sim.m_EmitterSpawned.push_back(p);
+
+            // 重置时间准备下一次发射
+            v.age = 0.0f;
+        }
+    }
+
+    static void EmitBatch(const ParticleSimCPU& sim, ParticleStorage& target, uint32_t offset, uint32_t first, uint32_t count)
+    {
+        float* posX = target.GetChannel(ParticleChannel::PosX) + offset;
+        float* posY = target.GetChannel(ParticleChannel::PosY) + offset;
+        float* posZ = target.GetChannel(ParticleChannel::PosZ) + offset;
+        float* velX = target.GetChannel(ParticleChannel::VelX) + offset;
+        float* velY = target.GetChannel(ParticleChannel::VelY) + offset;
+        float* velZ = target.GetChannel(ParticleChannel::VelZ) + offset;
+        float* accelX = target.GetChannel(ParticleChannel::AccelX) + offset;
+        float* accelY = target.GetChannel(ParticleChannel::AccelY) + offset;
+        float* accelZ = target.GetChannel(ParticleChannel::AccelZ) + offset;
+        float* sizeX = target.GetChannel(ParticleChannel::SizeX) + offset;
+        float* sizeY = target.GetChannel(ParticleChannel::SizeY) + offset;
+        float* ages = target.GetAges() + offset;
+        uint8_t* types = target.GetTypes() + offset;
+        uint32_t* emitCounts = target.GetEmitCounts() + offset;
+
+        // 随机数直接批量生成到速度或加速度通道，再原地变换
+        float* randX = Spawn::RandomAccel ? accelX : velX;
+        float* randY = Spawn::RandomAccel ? accelY : velY;
+        float* randZ = Spawn::RandomAccel ? accelZ : velZ;
+        float* zeroX = Spawn::RandomAccel ? velX : accelX;
+        float* zeroY = Spawn::RandomAccel ? velY : accelY;
+        float* zeroZ = Spawn::RandomAccel ? velZ : accelZ;
+        sim.m_Random.UniformVec3Bulk(ParticleSimCPU::EmitterRandomId, sim.m_FrameIndex, RandomStream, first, count,
+            randX, randY, randZ);
+
+        const Float3 emitPos = sim.m_Params.emitPos;
+        const float interval = sim.m_Params.emitInterval;
+        const float batchAge = sim.m_EmitBatchAge;
+        for (uint32_t k = 0; k < count; ++k)
+        {
+            Float3 r = Spawn::Transform({ randX[k], randY[k], randZ[k] });
+            randX[k] = r.x;
+            randY[k] = r.y;
+            randZ[k] = r.z;
+            zeroX[k] = zeroY[k] = zeroZ[k] = 0.0f;
+
+            posX[k] = emitPos.x;
+            posY[k] = emitPos.y;
+            posZ[k] = emitPos.z;
+            sizeX[k] = sizeY[k] = Spawn::Size;
+            // 出生后经过的时间，位置由闭式轨迹自然前推
+            ages[k] = std::max(batchAge - static_cast<float>(first + k + 1) * interval, 0.0f);
+            types[k] = PT_PARTICLE;
+            emitCounts[k] = 0;
+        }
+    }
+
+    static void UpdateEmitterTable(ParticleSimCPU& sim)
+    {
+        ParticleEmitterTable& table = sim.m_EmitterTable;
+        if constexpr (Spawn::Shells)
+        {
+            // 与系统自身的发射器相同，每帧发射ShellsPerFrame个壳直至ShellCount个，随机数以发射器的序号区分
+            // 壳不补发，重新启用的发射器从停用时的进度继续
+            uint32_t* emitCounts = table.GetEmitCounts();
+            float* catchUps = table.GetCatchUp();
+            for (uint32_t e : table.GetEnabledList())
+            {
+                catchUps[e] = 0.0f;
+                if (emitCounts[e] >= Spawn::ShellCount)
+                    continue;
+                const Float3 pos = { table.GetPosX()[e], table.GetPosY()[e], table.GetPosZ()[e] };
+                sim.m_EmitterRequests.push_back({ pos, ParticleSimCPU::GetTableShellRandomId(e), emitCounts[e],
+                    Spawn::ShellsPerFrame, PT_SHELL });
+                emitCounts[e] += Spawn::ShellsPerFrame;
+            }
+        }
+        else
+        {
+            sim.CountTableEmission(sim.m_Params.defaultParticleCount > Spawn::PauseAbove);
+        }
+    }
+
+    static void EmitTable(const ParticleSimCPU& sim, ParticleStorage& target, uint32_t offset, uint32_t first, uint32_t count)
+    {
+        if constexpr (!Spawn::Shells)
+        {
+            float* posX = target.GetChannel(ParticleChannel::PosX) + offset;
+            float* posY = target.GetChannel(ParticleChannel::PosY) + offset;
+            float* posZ = target.GetChannel(ParticleChannel::PosZ) + offset;
+            float* velX = target.GetChannel(ParticleChannel::VelX) + offset;
+            float* velY = target.GetChannel(ParticleChannel::VelY) + offset;
+            float* velZ = target.GetChannel(ParticleChannel::VelZ) + offset;
+            float* accelX = target.GetChannel(ParticleChannel::AccelX) + offset;
+            float* accelY = target.GetChannel(ParticleChannel::AccelY) + offset;
+            float* accelZ = target.GetChannel(ParticleChannel::AccelZ) + offset;
+            float* sizeX = target.GetChannel(ParticleChannel::SizeX) + offset;
+            float* sizeY = target.GetChannel(ParticleChannel::SizeY) + offset;
+            float* ages = target.GetAges() + offset;
+            uint8_t* types = target.GetTypes() + offset;
+            uint32_t* emitCounts = target.GetEmitCounts() + offset;
+
+            // 整个批次的随机数一次生成，index为粒子在批次中的位置
+            float* randX = Spawn::RandomAccel ? accelX : velX;
+            float* randY = Spawn::RandomAccel ? accelY : velY;
+            float* randZ = Spawn::RandomAccel ? accelZ : velZ;
+            float* zeroX = Spawn::RandomAccel ? velX : accelX;
+            float* zeroY = Spawn::RandomAccel ? velY : accelY;
+            float* zeroZ = Spawn::RandomAccel ? velZ : accelZ;
+            sim.m_Random.UniformVec3Bulk(ParticleSimCPU::EmitterTableRandomId, sim.m_FrameIndex, RandomStream, first, count,
+                randX, randY, randZ);
+
+            // 各发射器的粒子在批次中连续排列，逐段写入
+            const ParticleEmitterTable& table = sim.m_EmitterTable;
+            const uint32_t* offsets = sim.m_TableOffsets.data();
+            const uint32_t segmentCount = static_cast<uint32_t>(sim.m_TableEmitters.size());
+            uint32_t segment = static_cast<uint32_t>(std::upper_bound(offsets, offsets + segmentCount + 1, first) - offsets) - 1;
+            for (uint32_t k = 0; k < count; ++segment)
+            {
+                const uint32_t end = std::min(offsets[segment + 1] - first, count);
+                if (k >= end)
+                    continue;
+                const uint32_t e = sim.m_TableEmitters[segment];
+                const Float3 emitPos = { table.GetPosX()[e], table.GetPosY()[e], table.GetPosZ()[e] };
+                const ParticleEmitterBasis basis = ParticleEmitterBasis::FromDirection(
+                    { table.GetDirX()[e], table.GetDirY()[e], table.GetDirZ()[e] });
+                const float spacing = sim.m_TableBatchSpacings[segment];
+                const float batchAge = sim.m_TableBatchAges[segment];
+                const uint32_t emitterFirst = offsets[segment];
+                for (; k < end; ++k)
+                {
+                    Float3 r = basis.Apply(Spawn::Transform({ randX[k], randY[k], randZ[k] }));
+                    randX[k] = r.x;
+                    randY[k] = r.y;
+                    randZ[k] = r.z;
+                    zeroX[k] = zeroY[k] = zeroZ[k] = 0.0f;
+
+                    posX[k] = emitPos.x;
+                    posY[k] = emitPos.y;
+                    posZ[k] = emitPos.z;
+                    sizeX[k] = sizeY[k] = Spawn::Size;
+                    ages[k] = std::max(batchAge - static_cast<float>(first + k - emitterFirst + 1) * spacing, 0.0f);
+                    types[k] = PT_PARTICLE;
+                    emitCounts[k] = 0;
+                }
+            }
+        }
+    }
+
+    static void SkipEmitters(ParticleSimCPU& sim, uint64_t frames)
+    {
+        ParticleVertex& v = sim.m_Emitter;
+        ParticleEmitterTable& table = sim.m_EmitterTable;
+        if constexpr (Spawn::Shells)
+        {
+            // 每帧发射ShellsPerFrame个壳，达到ShellCount后发射器移除
+            constexpr uint64_t EmitFrames = (Spawn::ShellCount + Spawn::ShellsPerFrame - 1) / Spawn::ShellsPerFrame;
+            const uint32_t emitted = static_cast<uint32_t>(std::min(frames, EmitFrames)) * Spawn::ShellsPerFrame;
+            v.age = static_cast<float>(static_cast<double>(frames) * sim.m_TimeStep);
+            v.emitCount = emitted;
+            sim.m_HasEmitter = emitted < Spawn::ShellCount;
+            for (uint32_t e : table.GetEnabledList())
+                table.GetEmitCounts()[e] = emitted;
+        }
+        else
+        {
+            const float interval = sim.m_Params.emitInterval;
+            v.age = sim.GetSkippedEmitterAge(frames, interval);
+            const float* intervals = table.GetIntervals();
+            for (uint32_t e : table.GetEnabledList())
+                table.GetAges()[e] = sim.GetSkippedEmitterAge(frames, intervals[e] > 0.0f ? intervals[e] : interval);
+        }
+    }
+
+    static float GetLifetime(uint32_t type, const ParticleSimParams& params)
+    {
+        return Life::Lifetime(type, params);
+    }
+
+    static ParticleAppearanceTable GetAppearance(const ParticleSimParams& params)
+    {
+        ParticleAppearanceTable table;
+        table.types[PT_PARTICLE].accelScale = params.accel;
+        Appearance::Apply(table, params);
+        return table;
+    }
+
+    // 由参数求出整个系统的保守包围盒，不访问粒子
+    // 各类粒子的出生范围依次为发射器、发射器表(可为空)、壳的散开、已存在的粒子(live，按类型，可为空)与子发射器，
+    // 子发射器的出生位置取来源类型的轨迹范围
+    static ParticleSystemBounds ComputeBounds(const ParticleSimParams& params, const Float3& emitterPos,
+        const ParticleEmitterTable* table, const std::vector<SubEmitterDesc>& subEmitters, const ParticleSpawnRange* live)
+    {
+        const ParticleAppearanceTable appearance = GetAppearance(params);
+        ParticleSpawnRange ranges[3 + 4 + ParticleSimCPU::MaxSubEmitters];
+        uint32_t baseCount = 0;
+
+        ParticleSpawnRange& emitted = ranges[baseCount++];
+        emitted.minSize = emitted.maxSize = Spawn::Size;
+        if constexpr (Spawn::Shells)
+        {
+            emitted.type = PT_SHELL;
+            emitted.origin = ParticleBounds::Point(emitterPos);
+            emitted.accel = ScaleBounds(Spawn::TransformBounds(), Spawn::AccelScale);
+        }
+        else
+        {
+            emitted.origin = ParticleBounds::Point(params.emitPos);
+            if constexpr (Spawn::RandomAccel)
+                emitted.accel = Spawn::TransformBounds();
+            else
+                emitted.velocity = Spawn::TransformBounds();
+        }
+        const uint32_t emitterRanges = table && !table->GetPositionBounds().IsEmpty() ? 2 : 1;
+        if (emitterRanges == 2)
+        {
+            // 发射器表中的发射器只有位置与方向不同，壳的加速度不随方向旋转
+            ParticleSpawnRange& tabled = ranges[baseCount++];
+            tabled = emitted;
+            tabled.origin = table->GetPositionBounds();
+            if (!Spawn::Shells && table->HasRotation())
+            {
+                tabled.velocity = AnyRotationBounds(tabled.velocity);
+                tabled.accel = AnyRotationBounds(tabled.accel);
+            }
+        }
+        if constexpr (Life::ShellBursts)
+        {
+            // 与UpdateLifetimes相同，爆炸点按壳的accel乘以g_AccelW计算
+            ParticleSpawnRange& burst = ranges[baseCount++];
+            for (uint32_t r = 0; r < emitterRanges; ++r)
+            {
+                burst.origin.Merge(SweepTrajectory(ranges[r].origin, ranges[r].velocity,
+                    ScaleBounds(ranges[r].accel, params.accel), params.emitInterval));
+            }
+            if (live)
+            {
+                const ParticleSpawnRange& shells = live[PT_SHELL];
+                burst.origin.Merge(SweepTrajectory(shells.origin, shells.velocity,
+                    ScaleBounds(shells.accel, params.accel), params.emitInterval));
+            }
+            burst.accel = ScaleBounds(UnitCubeBounds(), Life::AccelScale);
+            burst.minSize = burst.maxSize = Spawn::Size;
+        }
+        for (uint32_t type = 0; live && type < 4; ++type)
+        {
+            if (type != PT_EMITTER && !live[type].origin.IsEmpty())
+                ranges[baseCount++] = live[type];
+        }
+
+        // 子发射器可以级联，逐轮以上一轮的结果作为来源，无环时至多MaxSubEmitters轮后不再变化
+        ParticleBounds paths[4];
+        const uint32_t subCount = static_cast<uint32_t>(std::min<size_t>(subEmitters.size(), ParticleSimCPU::MaxSubEmitters));
+        bool converged = false;
+        for (uint32_t pass = 0; pass <= ParticleSimCPU::MaxSubEmitters && !converged; ++pass)
+        {
+            for (ParticleBounds& path : paths)
+                path = {};
+            const uint32_t rangeCount = baseCount + (pass > 0 ? subCount : 0);
+            for (uint32_t r = 0; r < rangeCount; ++r)
+            {
+                const uint32_t type = ranges[r].type & 3;
+                paths[type].Merge(SweepSpawnRange(ranges[r], appearance.types[type], Life::Lifetime(type, params), false));
+            }
+
+            // 与ConsolidateEvents产生的粒子相同
+            converged = pass > 0 || subCount == 0;
+            for (uint32_t s = 0; s < subCount; ++s)
+            {
+                const SubEmitterDesc& desc = subEmitters[s];
+                ParticleSpawnRange range;
+                range.type = desc.spawnType & 3;
+                range.origin = paths[desc.sourceType & 3];
+                if (range.type == PT_SMOKE)
+                {
+                    range.velocity = ParticleBounds::Range({ -0.5f, -1.0f, -0.5f }, { 0.5f, 1.0f, 0.5f });
+                    range.minSize = range.maxSize = 3.0f;
+                }
+                else
+                {
+                    range.accel = ScaleBounds(UnitCubeBounds(), ShellBurstLife::AccelScale);
+                    range.minSize = range.maxSize = ShellSpawn::Size;
+                }
+                ParticleSpawnRange& previous = ranges[baseCount + s];
+                converged = converged && previous.origin == range.origin;
+                previous = range;
+            }
+        }
+
+        ParticleSystemBounds result;
+        float maxLifetime = 0.0f;
+        for (uint32_t r = 0; r < baseCount + subCount; ++r)
+        {
+            const uint32_t type = ranges[r].type & 3;
+            const float lifetime = Life::Lifetime(type, params);
+            result.bounds.Merge(SweepSpawnRange(ranges[r], appearance.types[type], lifetime, true));
+            // 壳在爆炸点停留，由散开的次数而非存活时间决定何时消亡
+            maxLifetime = std::max(maxLifetime, lifetime < FLT_MAX ? lifetime : params.emitInterval);
+        }
+        // 子发射器成环且不断扩大，无法给出有限的范围
+        if (!converged)
+            result.bounds = ParticleBounds::Infinite();
+        // 每一级散开或子发射器产生的粒子至多在来源消亡时出生
+        const uint32_t generations = 1 + subCount + (Life::ShellBursts ? 1 : 0);
+        result.maxAge = maxLifetime * generations;
+        if constexpr (Life::ShellBursts)
+            result.trailingFrames = Life::MaxBurstParticles / Life::ParticlesPerBurst + 1;
+        return result;
+    }
+
+private:
+    static constexpr ParticleSimCPU::RandomStream RandomStream =
+        Spawn::RandomAccel ? ParticleSimCPU::RS_Accel : ParticleSimCPU::RS_Velocity;
+};
+
+template<class SpawnPolicy, class LifePolicy, class AppearancePolicy>
+const ParticleSystemKernels ParticleSystem<SpawnPolicy, LifePolicy, AppearancePolicy>::Kernels = {
+    &ParticleSystem::UpdateLifetimes,
+    &ParticleSystem::UpdateEmitter,
+    &ParticleSystem::EmitBatch,
+    &ParticleSystem::UpdateEmitterTable,
+    &ParticleSystem::EmitTable,
+    &ParticleSystem::SkipEmitters,
+    &ParticleSystem::GetLifetime,
+    &ParticleSystem::GetAppearance,
+    &ParticleSystem::ComputeBounds,
+    LifePolicy::Uniform,
+};
+
+// 五种特效对应的策略组合
+using FireSystem = ParticleSystem<FlameSpawn, UniformLife, FireAppearance>;
+using SmokeSystem = ParticleSystem<SmokeSpawn, UniformLife, SmokeAppearance>;
+using FireSmokeSystem = ParticleSystem<SmokingFlameSpawn, SmokeTrailLife, FireSmokeAppearance>;
+using BoomSystem = ParticleSystem<ShellSpawn, ShellBurstLife, BoomAppearance>;
+using FountainSystem = ParticleSystem<FountainSpawn, UniformLife, FountainAppearance>;
+
+const ParticleSystemKernels& GetParticleSystemKernels(ParticleEffectType effectType);
+
+// 根据特效类型与当前参数得到与着色器一致的外观参数
+ParticleAppearanceTable GetParticleAppearance(ParticleEffectType effectType, const ParticleSimParams& params);
+
+// 根据特效类型与当前参数得到全部粒子(含公告板)的保守包围盒，emitterPos为发射器顶点的位置
+// table为额外的发射器(可为空)，live不为空时为按类型统计的已存在粒子的范围，结果同时包含它们及其后代
+ParticleSystemBounds ComputeParticleSystemBounds(ParticleEffectType effectType, const ParticleSimParams& params,
+    const Float3& emitterPos, const ParticleEmitterTable* table, const std::vector<SubEmitterDesc>& subEmitters,
+    const ParticleSpawnRange* live = nullptr);
+
+#endif
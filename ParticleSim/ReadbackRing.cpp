@@ -0,0 +1,74 @@
+#include "ReadbackRing.h"
+#include <utility>
+
+void ReadbackRing::Init(ReadbackBackend* backend, uint32_t slotCount)
+{
+    m_pBackend = backend;
+    m_SlotCount = slotCount;
+    m_IssuedCount = 0;
+    m_CompletedCount = 0;
+    m_DroppedCount = 0;
+    Reset();
+}
+
+void ReadbackRing::Reset()
+{
+    m_Pending.clear();
+    // 逆序放入，先使用0号槽位
+    m_FreeSlots.resize(m_SlotCount);
+    for (uint32_t i = 0; i < m_SlotCount; ++i)
+        m_FreeSlots[i] = m_SlotCount - 1 - i;
+}
+
+uint32_t ReadbackRing::Begin(uint64_t tag)
+{
+    if (m_FreeSlots.empty())
+    {
+        ++m_DroppedCount;
+        return InvalidSlot;
+    }
+
+    uint32_t slot = m_FreeSlots.back();
+    m_FreeSlots.pop_back();
+    m_Pending.push_back({ slot, tag, false });
+    m_pBackend->Begin(slot);
+    return slot;
+}
+
+void ReadbackRing::End(uint32_t slot)
+{
+    if (slot == InvalidSlot)
+        return;
+
+    // 进行中的回读至多只有最后发起的一个
+    Pending& pending = m_Pending.back();
+    pending.ended = true;
+    m_pBackend->End(slot);
+    ++m_IssuedCount;
+}
+
+SimulatedReadbackBackend::SimulatedReadbackBackend(uint32_t slotCount, uint32_t latencyFrames, SourceFunc source)
+    : m_Slots(slotCount), m_LatencyFrames(latencyFrames), m_Source(std::move(source))
+{
+}
+
+void SimulatedReadbackBackend::End(uint32_t slot)
+{
+    // 相当于GPU上的CopyResource，数据取自发起时刻
+    Slot& s = m_Slots[slot];
+    m_Source(s.bytes);
+    s.readyFrame = m_Frame + m_LatencyFrames;
+}
+
+bool SimulatedReadbackBackend::IsReady(uint32_t slot)
+{
+    return m_Frame >= m_Slots[slot].readyFrame;
+}
+
+bool SimulatedReadbackBackend::Map(uint32_t slot, ReadbackView& view)
+{
+    const Slot& s = m_Slots[slot];
+    view.data = s.bytes.data();
+    view.byteSize = static_cast<uint32_t>(s.bytes.size());
+    return true;
+}
@@ -0,0 +1,143 @@
+//***************************************************************************************
+// ReadbackRing.h
+//
+// 延迟若干帧的异步回读环：发起复制后立即返回，之后每帧轮询已完成的结果，从不阻塞等待
+// Asynchronous readback ring with a few frames of latency: copies are issued without
+// waiting and finished results are polled on later frames, never blocking.
+//***************************************************************************************
+
+#pragma once
+
+#ifndef READBACK_RING_H
+#define READBACK_RING_H
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <vector>
+
+// 一次回读得到的数据，仅在回调期间有效
+struct ReadbackView
+{
+    const void* data = nullptr;
+    uint32_t byteSize = 0;
+};
+
+// 回读的具体实现，每个槽位对应一份暂存资源(以及可能的查询)
+// 与图形API无关，D3D11下由暂存缓冲区与查询实现，也可以用模拟延迟的实现替代
+class ReadbackBackend
+{
+public:
+    virtual ~ReadbackBackend() = default;
+
+    // 开始在槽位上记录(如开始查询)，与End成对调用
+    virtual void Begin(uint32_t /*slot*/) {}
+    // 结束记录并发起到暂存资源的复制，不等待其完成
+    virtual void End(uint32_t slot) = 0;
+    // 非阻塞地判断槽位的结果是否已可读取
+    virtual bool IsReady(uint32_t slot) = 0;
+    // 映射已就绪的槽位，失败时返回false
+    virtual bool Map(uint32_t slot, ReadbackView& view) = 0;
+    virtual void Unmap(uint32_t slot) = 0;
+};
+
+// 与GpuTimer缓存未完成查询的方式相同，但结果按槽位循环使用暂存资源
+// 槽位用尽时放弃本次回读而不是等待，结果总是按发起的顺序交付
+class ReadbackRing
+{
+public:
+    static constexpr uint32_t InvalidSlot = 0xFFFFFFFFu;
+
+    // slotCount即同时等待的回读数上限，决定可容忍的最大延迟帧数
+    void Init(ReadbackBackend* backend, uint32_t slotCount);
+    // 放弃所有未完成的回读
+    void Reset();
+
+    // 取出一个空闲槽位并开始回读，tag随结果一起交付(如帧号)
+    // 没有空闲槽位时返回InvalidSlot，调用方跳过本次回读
+    uint32_t Begin(uint64_t tag);
+    void End(uint32_t slot);
+
+    // 按发起顺序交付所有已完成的回读，对每个结果调用func(tag, view)，返回交付的个数
+    // 遇到第一个未完成的回读即停止
+    template<class Func>
+    uint32_t Poll(Func&& func)
+    {
+        uint32_t delivered = 0;
+        while (!m_Pending.empty())
+        {
+            const Pending pending = m_Pending.front();
+            if (!pending.ended || !m_pBackend->IsReady(pending.slot))
+                break;
+
+            ReadbackView view;
+            if (m_pBackend->Map(pending.slot, view))
+            {
+                func(pending.tag, view);
+                m_pBackend->Unmap(pending.slot);
+            }
+            m_Pending.pop_front();
+            m_FreeSlots.push_back(pending.slot);
+            ++m_CompletedCount;
+            ++delivered;
+        }
+        return delivered;
+    }
+
+    uint32_t GetSlotCount() const { return m_SlotCount; }
+    uint32_t GetPendingCount() const { return static_cast<uint32_t>(m_Pending.size()); }
+    uint64_t GetIssuedCount() const { return m_IssuedCount; }
+    uint64_t GetCompletedCount() const { return m_CompletedCount; }
+    // 因槽位用尽而跳过的回读数
+    uint64_t GetDroppedCount() const { return m_DroppedCount; }
+
+private:
+    struct Pending
+    {
+        uint32_t slot;
+        uint64_t tag;
+        bool ended;
+    };
+
+    ReadbackBackend* m_pBackend = nullptr;
+    uint32_t m_SlotCount = 0;
+    std::deque<Pending> m_Pending;      // 按发起顺序排列的未完成回读
+    std::vector<uint32_t> m_FreeSlots;
+
+    uint64_t m_IssuedCount = 0;
+    uint64_t m_CompletedCount = 0;
+    uint64_t m_DroppedCount = 0;
+};
+
+// 模拟的回读：End时立即从source复制一份数据，经过latencyFrames帧后才视为完成
+// 用于在没有GPU的环境下测试回读环的行为与开销
+class SimulatedReadbackBackend : public ReadbackBackend
+{
+public:
+    // 将本次要回读的数据写入bytes
+    using SourceFunc = std::function<void(std::vector<uint8_t>& bytes)>;
+
+    SimulatedReadbackBackend(uint32_t slotCount, uint32_t latencyFrames, SourceFunc source);
+
+    // 每帧调用一次，推进模拟的GPU进度
+    void AdvanceFrame() { ++m_Frame; }
+
+    void End(uint32_t slot) override;
+    bool IsReady(uint32_t slot) override;
+    bool Map(uint32_t slot, ReadbackView& view) override;
+    void Unmap(uint32_t /*slot*/) override {}
+
+private:
+    struct Slot
+    {
+        std::vector<uint8_t> bytes;
+        uint64_t readyFrame = 0;
+    };
+
+    std::vector<Slot> m_Slots;
+    uint32_t m_LatencyFrames;
+    uint64_t m_Frame = 0;
+    SourceFunc m_Source;
+};
+
+#endif
@@ -0,0 +1,68 @@
+#include "TimingWheel.h"
+#include <algorithm>
+
+void TimingWheel::Init(uint32_t nodeCount)
+{
+    m_Next.assign(nodeCount, InvalidNode);
+    m_NodeTick.assign(nodeCount, 0);
+    Clear();
+}
+
+void TimingWheel::Clear(uint64_t currentTick)
+{
+    m_Tick = currentTick;
+    for (auto& level : m_Heads)
+        std::fill(std::begin(level), std::end(level), InvalidNode);
+}
+
+void TimingWheel::Schedule(uint32_t node, uint64_t tick)
+{
+    tick = std::min(std::max(tick, m_Tick), m_Tick + MaxDelta);
+    m_NodeTick[node] = tick;
+
+    // 放入与当前时间片高位相同的最低一层
+    uint32_t level = 0;
+    while (level + 1 < LevelCount && (tick >> (SlotBits * (level + 1))) != (m_Tick >> (SlotBits * (level + 1))))
+        ++level;
+    uint32_t slot = static_cast<uint32_t>((tick >> (SlotBits * level)) & (SlotCount - 1));
+
+    m_Next[node] = m_Heads[level][slot];
+    m_Heads[level][slot] = node;
+}
+
+void TimingWheel::DetachBucket(uint32_t level, uint32_t slot, uint32_t*& tail)
+{
+    uint32_t head = m_Heads[level][slot];
+    if (head == InvalidNode)
+        return;
+    m_Heads[level][slot] = InvalidNode;
+
+    *tail = head;
+    uint32_t node = head;
+    while (m_Next[node] != InvalidNode)
+        node = m_Next[node];
+    tail = &m_Next[node];
+}
+
+void TimingWheel::Cascade()
+{
+    if ((m_Tick & (SlotCount - 1)) != 0)
+        return;
+
+    // 从最高的越界层开始向下分配，高层的节点可能落入随后要分配的低层桶
+    uint32_t top = 1;
+    while (top + 1 < LevelCount && ((m_Tick >> (SlotBits * top)) & (SlotCount - 1)) == 0)
+        ++top;
+    for (uint32_t level = top; level >= 1; --level)
+    {
+        uint32_t slot = static_cast<uint32_t>((m_Tick >> (SlotBits * level)) & (SlotCount - 1));
+        uint32_t node = m_Heads[level][slot];
+        m_Heads[level][slot] = InvalidNode;
+        while (node != InvalidNode)
+        {
+            uint32_t next = m_Next[node];
+            Schedule(node, m_NodeTick[node]);
+            node = next;
+        }
+    }
+}
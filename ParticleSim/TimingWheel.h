@@ -0,0 +1,73 @@
+//***************************************************************************************
+// TimingWheel.h
+//
+// 分层时间轮，按到期的时间片将节点分桶，推进时只访问到期的节点
+// Hierarchical timing wheel bucketing nodes by expiry tick so that advancing only
+// touches the nodes that are due.
+//***************************************************************************************
+
+#pragma once
+
+#ifndef TIMING_WHEEL_H
+#define TIMING_WHEEL_H
+
+#include <cstdint>
+#include <vector>
+
+// 节点为[0, nodeCount)的整数(如粒子池的槽位)，链表指针存放在轮内，不需要额外分配
+// 每个节点同一时间至多位于一个桶中
+class TimingWheel
+{
+public:
+    static constexpr uint32_t SlotBits = 6;
+    static constexpr uint32_t SlotCount = 1u << SlotBits;
+    static constexpr uint32_t LevelCount = 5;
+    static constexpr uint32_t InvalidNode = 0xFFFFFFFFu;
+    // 超出该范围的到期时间被截断，到期时由调用方重新判断
+    static constexpr uint64_t MaxDelta = (1ull << (SlotBits * LevelCount)) - 1;
+
+    void Init(uint32_t nodeCount);
+    // 清空所有节点并将当前时间片设为currentTick
+    void Clear(uint64_t currentTick = 0);
+
+    uint64_t GetCurrentTick() const { return m_Tick; }
+
+    // 早于当前时间片的到期时间按当前时间片处理
+    void Schedule(uint32_t node, uint64_t tick);
+
+    // 推进到nowTick，按时间片顺序对所有到期(tick <= nowTick)的节点调用func(node)
+    // 节点在回调前已经移出，回调中可以重新调度；调度到nowTick的节点在下一次推进时再次到期
+    template<class Func>
+    void Advance(uint64_t nowTick, Func&& func)
+    {
+        uint32_t due = InvalidNode;
+        uint32_t* dueTail = &due;
+        while (m_Tick < nowTick)
+        {
+            DetachBucket(0, static_cast<uint32_t>(m_Tick & (SlotCount - 1)), dueTail);
+            ++m_Tick;
+            Cascade();
+        }
+        DetachBucket(0, static_cast<uint32_t>(m_Tick & (SlotCount - 1)), dueTail);
+
+        for (uint32_t node = due; node != InvalidNode;)
+        {
+            uint32_t next = m_Next[node];
+            func(node);
+            node = next;
+        }
+    }
+
+private:
+    // 将桶中的链表接到*tail之后，并移动tail到新的末尾
+    void DetachBucket(uint32_t level, uint32_t slot, uint32_t*& tail);
+    // 当前时间片跨过高层桶的边界时，将该桶中的节点分配到更低的层
+    void Cascade();
+
+    uint64_t m_Tick = 0;
+    uint32_t m_Heads[LevelCount][SlotCount] = {};
+    std::vector<uint32_t> m_Next;
+    std::vector<uint64_t> m_NodeTick;
+};
+
+#endif
@@ -118,6 +118,64 @@ void GameApp::UpdateScene(float dt)
             m_FireSmoke.Reset();
         }        
 
+        static bool cpu_simulation = false;
+        if (ImGui::Checkbox("CPU Simulation", &cpu_simulation))
+        {
+            for (ParticleManager* particle : { &m_Fire, &m_Boom, &m_Fountain, &m_Smoke, &m_FireSmoke })
+            {
+                particle->SetCpuSimulationEnabled(cpu_simulation);
+                particle->Reset();
+            }
+        }
+
+        // 发射频率不再受帧率限制，例如喷泉的0.0015s间隔
+        static bool accumulated_emission = false;
+        if (cpu_simulation && ImGui::Checkbox("Rate-Accurate Emission", &accumulated_emission))
+        {
+            for (ParticleManager* particle : { &m_Fire, &m_Boom, &m_Fountain, &m_Smoke, &m_FireSmoke })
+                particle->SetCpuEmissionMode(accumulated_emission ? EmissionMode::Accumulated : EmissionMode::PerFrame);
+        }
+
+        // 火焰、喷泉、烟雾只记录出生时间，更新时不再逐粒子写入
+        static bool birth_ring = false;
+        if (cpu_simulation && ImGui::Checkbox("Birth-Time Ring Storage", &birth_ring))
+        {
+            for (ParticleManager* particle : { &m_Fire, &m_Fountain, &m_Smoke })
+                particle->SetCpuStorageMode(birth_ring ? ParticleStorageMode::BirthRing : ParticleStorageMode::Compact);
+        }
+
+        // 烟火、爆炸使用固定槽位的粒子池，每帧只处理到期的粒子
+        static bool timing_wheel_pool = false;
+        if (cpu_simulation && ImGui::Checkbox("Timing-Wheel Pool Storage", &timing_wheel_pool))
+        {
+            for (ParticleManager* particle : { &m_Boom, &m_FireSmoke })
+                particle->SetCpuStorageMode(timing_wheel_pool ? ParticleStorageMode::Pool : ParticleStorageMode::Compact);
+        }
+
+        // 烟雾的混合与绘制顺序有关，按视深从远到近绘制
+        static bool depth_sort = false;
+        if (cpu_simulation && ImGui::Checkbox("Back-to-Front Sorting", &depth_sort))
+        {
+            for (ParticleManager* particle : { &m_Smoke, &m_FireSmoke })
+                particle->SetCpuDepthSortEnabled(depth_sort);
+        }
+
+        // 沿用上一帧的顺序并修复，乱序过多时退回完整排序
+        static bool coherent_sort = false;
+        if (cpu_simulation && depth_sort && ImGui::Checkbox("Frame-Coherent Sorting", &coherent_sort))
+        {
+            for (ParticleManager* particle : { &m_Smoke, &m_FireSmoke })
+                particle->SetCpuDepthSortMode(coherent_sort ? ParticleSortMode::Coherent : ParticleSortMode::Radix);
+        }
+
+        // 视锥体外的粒子不参与排序与上传
+        static bool frustum_cull = false;
+        if (cpu_simulation && ImGui::Checkbox("Frustum Culling", &frustum_cull))
+        {
+            for (ParticleManager* particle : { &m_Fire, &m_Boom, &m_Fountain, &m_Smoke, &m_FireSmoke })
+                particle->SetCpuFrustumCullingEnabled(frustum_cull);
+        }
+
         std::pair<uint32_t, uint32_t> particleCount = m_FireSmoke.GetParticleCount();
 
         ImGui::Text("Fire Particle Count: %d", particleCount.first);
@@ -186,11 +244,15 @@ void GameApp::UpdateScene(float dt)
     // ******************
     // 粒子系统
     //
-    m_Fire.Update(dt, m_Timer.TotalTime());
-    m_Boom.Update(dt, m_Timer.TotalTime());
-    m_Fountain.Update(dt, m_Timer.TotalTime());
-    m_Smoke.Update(dt, m_Timer.TotalTime());
-    m_FireSmoke.Update(dt, m_Timer.TotalTime());
+    // 各粒子系统相互独立，CPU模拟时在任务系统中并行更新
+    ParticleManager* particles[] = { &m_Fire, &m_Boom, &m_Fountain, &m_Smoke, &m_FireSmoke };
+    float totalTime = m_Timer.TotalTime();
+    for (ParticleManager* particle : particles)
+        particle->SetView(m_pCamera->GetViewMatrixXM(), m_pCamera->GetProjMatrixXM());
+    m_JobSystem.ParallelFor(ARRAYSIZE(particles), 1, [&](uint32_t begin, uint32_t end) {
+        for (uint32_t i = begin; i < end; ++i)
+            particles[i]->Update(dt, totalTime, &m_JobSystem);
+    });
 
     m_FireEffect.SetViewMatrix(m_pCamera->GetViewMatrixXM());
     m_FireEffect.SetEyePos(m_pCamera->GetPosition());
@@ -323,6 +385,7 @@ bool GameApp::InitResource()
     HR(m_pd3dDevice->CreateShaderResourceView(pRandomTex.Get(), nullptr, pRandomTexSRV.ReleaseAndGetAddressOf()));
     m_TextureManager.AddTexture("FireRandomTex", pRandomTexSRV.Get());
     m_Fire.InitResource(m_pd3dDevice.Get(), 10000);
+    m_Fire.InitCpuSimulation(m_pd3dDevice.Get(), ParticleEffectType::Fire, randEngine());
     m_Fire.SetTextureInput(m_TextureManager.GetTexture("..\\Texture\\boom.dds"));
     m_Fire.SetTextureRandom(m_TextureManager.GetTexture("FireRandomTex"));
     m_Fire.SetTextureAsh(m_TextureManager.GetTexture("..\\Texture\\ash0.dds"));
@@ -372,6 +435,7 @@ bool GameApp::InitResource()
     m_TextureManager.AddTexture("FountainRandomTex", pRandomTexSRV.Get());
 
     m_Boom.InitResource(m_pd3dDevice.Get(), 200000);
+    m_Boom.InitCpuSimulation(m_pd3dDevice.Get(), ParticleEffectType::Boom, randEngine());
     m_Boom.SetTextureInput(m_TextureManager.GetTexture("..\\Texture\\boom.dds"));
     m_Boom.SetTextureRandom(m_TextureManager.GetTexture("BoomRandomTex"));
     m_Boom.SetTextureAsh(m_TextureManager.GetTexture("..\\Texture\\ash0.dds"));
@@ -385,6 +449,7 @@ bool GameApp::InitResource()
 
 
     m_Fountain.InitResource(m_pd3dDevice.Get(), 10000);
+    m_Fountain.InitCpuSimulation(m_pd3dDevice.Get(), ParticleEffectType::Fountain, randEngine());
     m_Fountain.SetTextureInput(m_TextureManager.GetTexture("..\\Texture\\raindrop0.dds"));
     m_Fountain.SetTextureRandom(m_TextureManager.GetTexture("FountainRandomTex"));
     m_Fountain.SetEmitPos(XMFLOAT3(0.0f, 0.0f, 0.0f));
@@ -400,6 +465,7 @@ bool GameApp::InitResource()
     m_TextureManager.AddTexture("SmokeRandomTex", pRandomTexSRV.Get());
 
     m_Smoke.InitResource(m_pd3dDevice.Get(), 1000);
+    m_Smoke.InitCpuSimulation(m_pd3dDevice.Get(), ParticleEffectType::Smoke, randEngine());
     m_Smoke.SetTextureInput(m_TextureManager.GetTexture("..\\Texture\\smoke_01.dds"));
     m_Smoke.SetTextureRandom(m_TextureManager.GetTexture("FountainRandomTex"));
     m_Smoke.SetEmitPos(XMFLOAT3(0.0f, -1.0f, 0.0f));
@@ -415,6 +481,7 @@ bool GameApp::InitResource()
     m_TextureManager.AddTexture("FireSmokeRandomTex", pRandomTexSRV.Get());
 
     m_FireSmoke.InitResource(m_pd3dDevice.Get(), 1000);
+    m_FireSmoke.InitCpuSimulation(m_pd3dDevice.Get(), ParticleEffectType::FireSmoke, randEngine());
     m_FireSmoke.SetTextureInput(m_TextureManager.GetTexture("..\\Texture\\boom.dds"));
     m_FireSmoke.SetTextureRandom(m_TextureManager.GetTexture("FireSmokeRandomTex"));
     m_FireSmoke.SetTextureAsh(m_TextureManager.GetTexture("..\\Texture\\smoke_01.dds"));
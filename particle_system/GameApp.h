@@ -45,6 +45,7 @@ private:
     ParticleManager m_Fountain;                                         // 喷泉粒子系统
     ParticleManager m_Smoke;                                            // 烟雾粒子系统
     ParticleManager m_FireSmoke;                                        // 火焰烟雾粒子系统
+    JobSystem m_JobSystem;                                              // CPU粒子模拟使用的任务系统
 
     ParticleEffect m_FireEffect;                                        // 火焰特效
     ParticleEffect m_BoomEffect;                                        // 爆炸特效
@@ -5,6 +5,8 @@
 #include <DXTrace.h>
 #include <Vertex.h>
 #include <TextureManager.h>
+#include <ParticleSchema.h>
+#include <array>
 #include <filesystem>
 #include "LightHelper.h"
 
@@ -12,6 +14,46 @@ using namespace DirectX;
 
 # pragma warning(disable: 26812)
 
+//
+// 由ParticleVertexSchema生成的输入布局与流输出声明
+//
+
+static_assert(sizeof(ParticleEffect::VertexParticle) == ParticleVertexSchema::Stride, "VertexParticle must match ParticleVertexSchema");
+
+static DXGI_FORMAT GetAttributeFormat(const ParticleAttribute& attribute)
+{
+    static const DXGI_FORMAT floatFormats[] = {
+        DXGI_FORMAT_R32_FLOAT, DXGI_FORMAT_R32G32_FLOAT, DXGI_FORMAT_R32G32B32_FLOAT, DXGI_FORMAT_R32G32B32A32_FLOAT
+    };
+    static const DXGI_FORMAT uintFormats[] = {
+        DXGI_FORMAT_R32_UINT, DXGI_FORMAT_R32G32_UINT, DXGI_FORMAT_R32G32B32_UINT, DXGI_FORMAT_R32G32B32A32_UINT
+    };
+    const DXGI_FORMAT* formats = attribute.format == ParticleAttributeFormat::Float ? floatFormats : uintFormats;
+    return formats[attribute.componentCount - 1];
+}
+
+static std::array<D3D11_INPUT_ELEMENT_DESC, ParticleVertexSchema::AttributeCount> MakeParticleInputLayout()
+{
+    std::array<D3D11_INPUT_ELEMENT_DESC, ParticleVertexSchema::AttributeCount> layout{};
+    for (uint32_t i = 0; i < ParticleVertexSchema::AttributeCount; ++i)
+    {
+        const ParticleAttribute& a = ParticleVertexSchema::Attributes[i];
+        layout[i] = { a.semantic, 0, GetAttributeFormat(a), 0, a.offset, D3D11_INPUT_PER_VERTEX_DATA, 0 };
+    }
+    return layout;
+}
+
+static std::array<D3D11_SO_DECLARATION_ENTRY, ParticleVertexSchema::AttributeCount> MakeParticleStreamOutput()
+{
+    std::array<D3D11_SO_DECLARATION_ENTRY, ParticleVertexSchema::AttributeCount> entries{};
+    for (uint32_t i = 0; i < ParticleVertexSchema::AttributeCount; ++i)
+    {
+        const ParticleAttribute& a = ParticleVertexSchema::Attributes[i];
+        entries[i] = { 0, a.semantic, 0, 0, static_cast<BYTE>(a.componentCount), 0 };
+    }
+    return entries;
+}
+
 //
 // ParticleEffect::Impl 需要先于BasicEffect的定义
 //
@@ -74,25 +116,8 @@ bool ParticleEffect::InitAll(ID3D11Device* device, std::wstring_view filename)
 
     pImpl->m_pEffectHelper = std::make_unique<EffectHelper>();
 
-    const D3D11_INPUT_ELEMENT_DESC inputLayouts[] = {
-        {"POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0},
-        {"VELOCITY", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0},
-        {"ACCEL", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0},
-        {"SIZE", 0, DXGI_FORMAT_R32G32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0},
-        {"AGE", 0, DXGI_FORMAT_R32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0},
-        {"TYPE", 0, DXGI_FORMAT_R32_UINT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0},
-        {"EMIT_COUNT", 0, DXGI_FORMAT_R32_UINT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0},
-    };
-
-    const D3D11_SO_DECLARATION_ENTRY outputLayout[] = {
-        {0, "POSITION", 0, 0, 3, 0},
-        {0, "VELOCITY", 0, 0, 3, 0},
-        {0, "ACCEL", 0, 0, 3, 0},
-        {0, "SIZE", 0, 0, 2, 0},
-        {0, "AGE", 0, 0, 1, 0},
-        {0, "TYPE", 0, 0, 1, 0},
-        {0, "EMIT_COUNT", 0, 0, 1, 0},
-    };
+    const auto inputLayouts = MakeParticleInputLayout();
+    const auto outputLayout = MakeParticleStreamOutput();
 
     fs::path cacheDir = "Shaders\\Cache";
     bool overWrite = true;
@@ -110,7 +135,7 @@ bool ParticleEffect::InitAll(ID3D11Device* device, std::wstring_view filename)
     HR(pImpl->m_pEffectHelper->CreateShaderFromFile((stem.string() + "_SO_VS"), filename,
         device, "SO_VS", "vs_5_0", nullptr, blob.GetAddressOf()));
     // 创建顶点布局
-    HR(device->CreateInputLayout(inputLayouts, ARRAYSIZE(inputLayouts),
+    HR(device->CreateInputLayout(inputLayouts.data(), static_cast<UINT>(inputLayouts.size()),
         blob->GetBufferPointer(), blob->GetBufferSize(), pImpl->m_pVertexParticleLayout.GetAddressOf()));
 
     HR(pImpl->m_pEffectHelper->CreateShaderFromFile((stem.string() + "_VS"), filename,
@@ -134,7 +159,7 @@ bool ParticleEffect::InitAll(ID3D11Device* device, std::wstring_view filename)
     Microsoft::WRL::ComPtr<ID3D11GeometryShader> pGS;
     uint32_t strides[] = { sizeof(VertexParticle) };
     HR(device->CreateGeometryShaderWithStreamOutput(blob->GetBufferPointer(), blob->GetBufferSize(),
-        outputLayout, ARRAYSIZE(outputLayout), strides, 1, D3D11_SO_NO_RASTERIZED_STREAM,
+        outputLayout.data(), static_cast<UINT>(outputLayout.size()), strides, 1, D3D11_SO_NO_RASTERIZED_STREAM,
         nullptr, pGS.GetAddressOf()));
     HR(pImpl->m_pEffectHelper->AddGeometryShaderWithStreamOutput((stem.string() + "_SO_GS"), device, pGS.Get(), blob.Get()));
 
@@ -188,25 +213,8 @@ bool ParticleEffect::InitAllWithSmoke(ID3D11Device* device, std::wstring_view fi
 
     pImpl->m_pEffectHelper = std::make_unique<EffectHelper>();
 
-    const D3D11_INPUT_ELEMENT_DESC inputLayouts[] = {
-        {"POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0},
-        {"VELOCITY", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0},
-        {"ACCEL", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0},
-        {"SIZE", 0, DXGI_FORMAT_R32G32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0},
-        {"AGE", 0, DXGI_FORMAT_R32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0},
-        {"TYPE", 0, DXGI_FORMAT_R32_UINT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0},
-        {"EMIT_COUNT", 0, DXGI_FORMAT_R32_UINT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0},
-    };
-
-    const D3D11_SO_DECLARATION_ENTRY outputLayout[] = {
-        {0, "POSITION", 0, 0, 3, 0},
-        {0, "VELOCITY", 0, 0, 3, 0},
-        {0, "ACCEL", 0, 0, 3, 0},
-        {0, "SIZE", 0, 0, 2, 0},
-        {0, "AGE", 0, 0, 1, 0},
-        {0, "TYPE", 0, 0, 1, 0},
-        {0, "EMIT_COUNT", 0, 0, 1, 0},
-    };
+    const auto inputLayouts = MakeParticleInputLayout();
+    const auto outputLayout = MakeParticleStreamOutput();
 
     fs::path cacheDir = "Shaders\\Cache";
     bool overWrite = true;
@@ -224,7 +232,7 @@ bool ParticleEffect::InitAllWithSmoke(ID3D11Device* device, std::wstring_view fi
     HR(pImpl->m_pEffectHelper->CreateShaderFromFile((stem.string() + "_SO_VS"), filename,
         device, "SO_VS", "vs_5_0", nullptr, blob.GetAddressOf()));
     // 创建顶点布局
-    HR(device->CreateInputLayout(inputLayouts, ARRAYSIZE(inputLayouts),
+    HR(device->CreateInputLayout(inputLayouts.data(), static_cast<UINT>(inputLayouts.size()),
         blob->GetBufferPointer(), blob->GetBufferSize(), pImpl->m_pVertexParticleLayout.GetAddressOf()));
 
     HR(pImpl->m_pEffectHelper->CreateShaderFromFile((stem.string() + "_VS"), filename,
@@ -251,7 +259,7 @@ bool ParticleEffect::InitAllWithSmoke(ID3D11Device* device, std::wstring_view fi
     Microsoft::WRL::ComPtr<ID3D11GeometryShader> pGS;
     uint32_t strides[] = { sizeof(VertexParticle) };
     HR(device->CreateGeometryShaderWithStreamOutput(blob->GetBufferPointer(), blob->GetBufferSize(),
-        outputLayout, ARRAYSIZE(outputLayout), strides, 1, D3D11_SO_NO_RASTERIZED_STREAM,
+        outputLayout.data(), static_cast<UINT>(outputLayout.size()), strides, 1, D3D11_SO_NO_RASTERIZED_STREAM,
         nullptr, pGS.GetAddressOf()));
     HR(pImpl->m_pEffectHelper->AddGeometryShaderWithStreamOutput((stem.string() + "_SO_GS"), device, pGS.Get(), blob.Get()));
 
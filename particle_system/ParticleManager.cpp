@@ -1,8 +1,21 @@
 #include "ParticleManager.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
 #include <Vertex.h>
 #include <XUtil.h>
 #include <DXTrace.h>
 
+// CPU模拟直接以流输出的顶点格式工作
+static_assert(sizeof(ParticleVertex) == sizeof(ParticleEffect::VertexParticle), "Vertex layout mismatch");
+static_assert(offsetof(ParticleVertex, size) == offsetof(ParticleEffect::VertexParticle, size), "Vertex layout mismatch");
+static_assert(offsetof(ParticleVertex, emitCount) == offsetof(ParticleEffect::VertexParticle, emitCount), "Vertex layout mismatch");
+
+static Float3 ToFloat3(const DirectX::XMFLOAT3& v)
+{
+    return { v.x, v.y, v.z };
+}
+
 float ParticleManager::GetAge() const
 {
     return m_Age;
@@ -11,26 +24,36 @@ float ParticleManager::GetAge() const
 void ParticleManager::SetEmitPos(const DirectX::XMFLOAT3& emitPos)
 {
     m_EmitPos = emitPos;
+    if (m_pCpuSim)
+        m_pCpuSim->SetEmitPos(ToFloat3(emitPos));
 }
 
 void ParticleManager::SetEmitDir(const DirectX::XMFLOAT3& emitDir)
 {
     m_EmitDir = emitDir;
+    if (m_pCpuSim)
+        m_pCpuSim->SetEmitDir(ToFloat3(emitDir));
 }
 
 void ParticleManager::SetEmitInterval(float t)
 {
     m_EmitInterval = t;
+    if (m_pCpuSim)
+        m_pCpuSim->SetEmitInterval(t);
 }
 
 void ParticleManager::SetAliveTime(float t)
 {
     m_AliveTime = t;
+    if (m_pCpuSim)
+        m_pCpuSim->SetAliveTime(t);
 }
 
 void ParticleManager::SetAcceleration(const DirectX::XMFLOAT3& accel)
 {
     m_Accel = accel;
+    if (m_pCpuSim)
+        m_pCpuSim->SetAcceleration(ToFloat3(accel));
 }
 
 
@@ -38,6 +61,8 @@ void ParticleManager::SetParticleCount(uint32_t const defaultParticle, uint32_t
 {
     m_DefaultParticleCount = defaultParticle;
     m_SmokeParticleCount = smokeParticle;
+    if (m_pCpuSim)
+        m_pCpuSim->SetParticleCount(defaultParticle, smokeParticle);
 }
 
 void ParticleManager::InitResource(ID3D11Device* device, uint32_t maxParticles)
@@ -89,19 +114,10 @@ void ParticleManager::InitResource(ID3D11Device* device, uint32_t maxParticles)
     initData.pSysMem = indices;
     HR(device->CreateBuffer(&ibd, &initData, m_pIndexBuffer.GetAddressOf()));
 
-    ZeroMemory(&bufferDesc, sizeof(bufferDesc));
-    bufferDesc.Usage = D3D11_USAGE_STAGING;
-    bufferDesc.ByteWidth = sizeof(ParticleEffect::VertexParticle) * m_MaxParticles;
-    bufferDesc.BindFlags = 0;
-    bufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
-    HR(device->CreateBuffer(&bufferDesc, nullptr, &m_pStagingBuffer));
-
-    // 使用查询对象获取顶点个数
-    D3D11_QUERY_DESC queryDesc;
-    queryDesc.Query = D3D11_QUERY_SO_STATISTICS;
-    queryDesc.MiscFlags = 0;
-
-    device->CreateQuery(&queryDesc, pQuery.GetAddressOf());
+    // 每个回读槽位一个暂存缓冲区与SO统计查询
+    m_pReadbackBackend = std::make_unique<StreamOutReadback>();
+    m_pReadbackBackend->Init(device, ReadbackSlotCount, sizeof(ParticleEffect::VertexParticle), m_MaxParticles);
+    m_Readback.Init(m_pReadbackBackend.get(), ReadbackSlotCount);
 
 }
 
@@ -119,18 +135,255 @@ void ParticleManager::SetTextureAsh(ID3D11ShaderResourceView* textureAsh) {
     m_pTextureAshSRV = textureAsh;
 }
 
+void ParticleManager::InitCpuSimulation(ID3D11Device* device, ParticleEffectType effectType, uint64_t seed)
+{
+    m_pCpuSim = std::make_unique<ParticleSimCPU>();
+    m_pCpuSim->Init(effectType, m_MaxParticles, seed);
+    m_pCpuSim->SetEmitPos(ToFloat3(m_EmitPos));
+    m_pCpuSim->SetEmitDir(ToFloat3(m_EmitDir));
+    m_pCpuSim->SetAcceleration(ToFloat3(m_Accel));
+    m_pCpuSim->SetEmitInterval(m_EmitInterval);
+    m_pCpuSim->SetAliveTime(m_AliveTime);
+    m_pCpuSim->SetParticleCount(m_DefaultParticleCount, m_SmokeParticleCount);
+
+    // 每帧由CPU整体写入
+    CD3D11_BUFFER_DESC bufferDesc(sizeof(ParticleEffect::VertexParticle) * m_MaxParticles,
+        D3D11_BIND_VERTEX_BUFFER, D3D11_USAGE_DYNAMIC, D3D11_CPU_ACCESS_WRITE);
+    HR(device->CreateBuffer(&bufferDesc, nullptr, m_pCpuDrawVB.ReleaseAndGetAddressOf()));
+
+    CD3D11_BUFFER_DESC indexDesc(sizeof(uint32_t) * m_MaxParticles,
+        D3D11_BIND_INDEX_BUFFER, D3D11_USAGE_DYNAMIC, D3D11_CPU_ACCESS_WRITE);
+    HR(device->CreateBuffer(&indexDesc, nullptr, m_pCpuDrawIB.ReleaseAndGetAddressOf()));
+}
+
+void ParticleManager::SetCpuSimulationEnabled(bool enabled)
+{
+    m_CpuSimEnabled = enabled && m_pCpuSim;
+}
+
+bool ParticleManager::IsCpuSimulationEnabled() const
+{
+    return m_CpuSimEnabled;
+}
+
+void ParticleManager::SetCpuEmissionMode(EmissionMode mode)
+{
+    if (m_pCpuSim)
+        m_pCpuSim->SetEmissionMode(mode);
+}
+
+void ParticleManager::SetCpuStorageMode(ParticleStorageMode mode)
+{
+    if (m_pCpuSim)
+        m_pCpuSim->SetStorageMode(mode);
+}
+
+void ParticleManager::AddCpuSubEmitter(const SubEmitterDesc& desc)
+{
+    if (m_pCpuSim)
+        m_pCpuSim->AddSubEmitter(desc);
+}
+
+void ParticleManager::ClearCpuSubEmitters()
+{
+    if (m_pCpuSim)
+        m_pCpuSim->ClearSubEmitters();
+}
+
+uint32_t ParticleManager::AddCpuEmitter(const ParticleEmitterDesc& desc)
+{
+    return m_pCpuSim ? m_pCpuSim->AddEmitter(desc) : 0;
+}
+
+void ParticleManager::SetCpuEmitterPos(uint32_t index, const DirectX::XMFLOAT3& pos)
+{
+    if (m_pCpuSim)
+        m_pCpuSim->GetEmitters().SetPosition(index, ToFloat3(pos));
+}
+
+void ParticleManager::SetCpuEmitterEnabled(uint32_t index, bool enabled)
+{
+    if (m_pCpuSim)
+        m_pCpuSim->GetEmitters().SetEnabled(index, enabled);
+}
+
+void ParticleManager::ClearCpuEmitters()
+{
+    if (m_pCpuSim)
+        m_pCpuSim->ClearEmitters();
+    m_CpuEmitterGridEnabled = false;
+}
+
+void ParticleManager::BuildCpuEmitterGrid(float cellSize, float activateDistance, float deactivateDistance)
+{
+    if (!m_pCpuSim)
+        return;
+    m_CpuEmitterGrid.Build(*m_pCpuSim, cellSize);
+    m_CpuActivation.activateDistance = activateDistance;
+    m_CpuActivation.deactivateDistance = deactivateDistance;
+    m_CpuEmitterGridEnabled = true;
+}
+
+void ParticleManager::SetCpuFixedStep(float step, uint32_t maxSteps)
+{
+    m_CpuStepClock.SetStep(step);
+    m_CpuStepClock.SetMaxSteps(maxSteps);
+    m_CpuStepClock.Reset();
+    if (m_pCpuSim)
+        m_pCpuSim->SetRenderLag(0.0f);
+}
+
+void ParticleManager::SetCpuStateHashEnabled(bool enabled)
+{
+    m_CpuStateHash = enabled;
+}
+
+void ParticleManager::SetCpuSubEmitterBudget(uint32_t budget)
+{
+    if (m_pCpuSim)
+        m_pCpuSim->SetSubEmitterBudget(budget);
+}
+
+void ParticleManager::SetCpuDepthSortEnabled(bool enabled)
+{
+    m_CpuDepthSort = enabled;
+}
+
+void ParticleManager::SetCpuDepthSortMode(ParticleSortMode mode)
+{
+    m_CpuSortMode = mode;
+}
+
+void ParticleManager::SetCpuFrustumCullingEnabled(bool enabled)
+{
+    m_CpuFrustumCull = enabled;
+}
+
+void ParticleManager::SetView(DirectX::FXMMATRIX view, DirectX::CXMMATRIX proj)
+{
+    // 行向量约定下视空间z = posW · 第三列
+    DirectX::XMFLOAT4X4 viewMatrix;
+    DirectX::XMStoreFloat4x4(&viewMatrix, view);
+    m_CpuDepthPlane.axis = { viewMatrix._13, viewMatrix._23, viewMatrix._33 };
+    m_CpuDepthPlane.offset = viewMatrix._43;
+
+    DirectX::XMFLOAT4X4 viewProj;
+    DirectX::XMStoreFloat4x4(&viewProj, view * proj);
+    m_ViewFrustum = ParticleFrustum::FromViewProj(viewProj.m);
+
+    // 相机位置为视图矩阵逆矩阵的平移部分
+    DirectX::XMFLOAT3 eye;
+    DirectX::XMStoreFloat3(&eye, DirectX::XMMatrixInverse(nullptr, view).r[3]);
+    m_CpuActivation.eye = ToFloat3(eye);
+}
+
+bool ParticleManager::GetBoundingBox(DirectX::BoundingBox& box) const
+{
+    const ParticleBounds bounds = m_pCpuSim ? m_pCpuSim->GetBounds() : ParticleBounds::Infinite();
+    if (bounds.IsEmpty())
+        return false;
+    // 分别缩放以免无穷大的包围盒求差时溢出
+    box.Center = { 0.5f * bounds.min.x + 0.5f * bounds.max.x, 0.5f * bounds.min.y + 0.5f * bounds.max.y,
+        0.5f * bounds.min.z + 0.5f * bounds.max.z };
+    box.Extents = { 0.5f * bounds.max.x - 0.5f * bounds.min.x, 0.5f * bounds.max.y - 0.5f * bounds.min.y,
+        0.5f * bounds.max.z - 0.5f * bounds.min.z };
+    return true;
+}
+
+bool ParticleManager::IsOffscreen() const
+{
+    return m_Offscreen;
+}
+
 void ParticleManager::Reset()
 {
     m_FirstRun = true;
     m_Age = 0.0f;
+    // 重置前发起的回读已不对应当前的粒子
+    m_Readback.Reset();
+    if (m_pCpuSim)
+    {
+        m_pCpuSim->Reset();
+        m_pCpuSim->SetRenderLag(0.0f);
+    }
+    m_CpuStepClock.Reset();
+    m_CpuStateChecker.Clear();
+}
+
+void ParticleManager::SeekCpuSimulation(float time, float dt, JobSystem* jobs)
+{
+    if (!m_pCpuSim)
+        return;
+    m_Readback.Reset();
+    m_pCpuSim->SeekTo(time, dt, jobs);
+    m_Age = m_pCpuSim->GetAge();
+    std::pair<uint32_t, uint32_t> counts = m_pCpuSim->CountParticles();
+    SetParticleCount(counts.first, counts.second);
+}
+
+void ParticleManager::PrewarmCpuSimulation(float seconds, float dt, JobSystem* jobs)
+{
+    if (m_pCpuSim)
+        SeekCpuSimulation(m_pCpuSim->GetAge() + seconds, dt, jobs);
 }
 
-void ParticleManager::Update(float dt, float gameTime)
+void ParticleManager::Update(float dt, float gameTime, JobSystem* jobs)
 {
     m_GameTime = gameTime;
     m_TimeStep = dt;
 
     m_Age += dt;
+
+    if (!m_CpuSimEnabled)
+    {
+        // 流输出路径在Draw中模拟，这里只推进包围盒
+        if (m_pCpuSim)
+            m_pCpuSim->AdvanceBounds(dt);
+        m_Offscreen = m_pCpuSim && !m_ViewFrustum.Intersects(m_pCpuSim->GetBounds());
+    }
+    else
+    {
+        // 不使用固定步长时每帧一步，步长与时刻即本帧的dt与gameTime
+        const uint32_t steps = m_CpuStepClock.Advance(dt);
+        const bool fixed = m_CpuStepClock.IsFixed();
+        const float step = m_CpuStepClock.GetStepDelta();
+        for (uint32_t i = 0; i < steps; ++i)
+        {
+            if (m_CpuEmitterGridEnabled)
+            {
+                // 管理器可移动，视锥体的地址在使用时再取
+                m_CpuActivation.frustum = &m_ViewFrustum;
+                m_CpuEmitterGrid.Update(*m_pCpuSim, m_CpuActivation, step);
+            }
+            m_pCpuSim->Update(step, fixed ? m_CpuStepClock.GetStepTime(i) : gameTime, jobs);
+            // 粒子数由模拟增量维护，更新后即可作为下一步发射上限的输入，无需回读
+            std::pair<uint32_t, uint32_t> counts = m_pCpuSim->CountParticles();
+            SetParticleCount(counts.first, counts.second);
+            if (m_CpuStateHash)
+                m_CpuStateChecker.Check(m_pCpuSim->GetFrameIndex(), m_pCpuSim->ComputeStateHash(jobs));
+        }
+        // 没有推进的帧仍按新的插值位置剔除、排序与上传
+        m_pCpuSim->SetRenderLag(m_CpuStepClock.GetRenderLag());
+
+        // 整个系统不可见时不必逐粒子剔除与排序
+        m_Offscreen = !m_ViewFrustum.Intersects(m_pCpuSim->GetBounds());
+        if (m_Offscreen)
+            return;
+        if (m_CpuFrustumCull)
+        {
+            m_CpuCuller.Cull(*m_pCpuSim, m_ViewFrustum, jobs);
+            if (m_CpuDepthSort)
+                m_CpuSorter.Sort(m_CpuCuller, m_CpuDepthPlane, jobs);
+        }
+        else if (m_CpuDepthSort && m_CpuSortMode == ParticleSortMode::Coherent)
+        {
+            m_CpuSorter.SortCoherent(*m_pCpuSim, m_CpuDepthPlane, jobs);
+        }
+        else if (m_CpuDepthSort)
+        {
+            m_CpuSorter.Sort(*m_pCpuSim, m_CpuDepthPlane, jobs);
+        }
+    }
 }
 
 void ParticleManager::Draw(ID3D11DeviceContext* deviceContext, ParticleEffect& effect)
@@ -150,33 +403,37 @@ void ParticleManager::Draw(ID3D11DeviceContext* deviceContext, ParticleEffect& e
     effect.SetTextureAsh(m_pTextureAshSRV.Get());
 
 
-    // ******************
-    // 流输出
-    //
-    // 如果是第一次运行，使用初始顶点缓冲区
-    // 否则，使用存有当前所有粒子的顶点缓冲区
-    effect.RenderToVertexBuffer(deviceContext,
-        m_FirstRun ? m_pInitVB.Get() : m_pDrawVB.Get(),
-        m_pStreamOutVB.Get(),
-        m_FirstRun);
-    // 后续转为DrawAuto
-    m_FirstRun = 0;
-
-
-    // 进行顶点缓冲区的Ping-Pong交换
-    m_pDrawVB.Swap(m_pStreamOutVB);
+    if (m_CpuSimEnabled)
+    {
+        // CPU已完成模拟，直接上传
+        if (!m_Offscreen)
+            UploadCpuParticles(deviceContext);
+    }
+    else
+    {
+        // ******************
+        // 流输出
+        //
+        // 如果是第一次运行，使用初始顶点缓冲区
+        // 否则，使用存有当前所有粒子的顶点缓冲区
+        effect.RenderToVertexBuffer(deviceContext,
+            m_FirstRun ? m_pInitVB.Get() : m_pDrawVB.Get(),
+            m_pStreamOutVB.Get(),
+            m_FirstRun);
+        // 后续转为DrawAuto
+        m_FirstRun = 0;
+
+
+        // 进行顶点缓冲区的Ping-Pong交换
+        m_pDrawVB.Swap(m_pStreamOutVB);
+    }
 
     // ******************
     // 使用流输出顶点绘制粒子
     //
     deviceContext->ClearRenderTargetView(pRTVs[0], reinterpret_cast<float*>(&m_BgColor));
     deviceContext->OMSetRenderTargets(1, pRTVs, nullptr);
-    auto inputData = effect.SetRenderDefault();
-    deviceContext->IASetPrimitiveTopology(inputData.topology);
-    deviceContext->IASetInputLayout(inputData.pInputLayout);
-    deviceContext->IASetVertexBuffers(0, 1, m_pDrawVB.GetAddressOf(), &inputData.stride, &inputData.offset);
-    effect.Apply(deviceContext);
-    deviceContext->DrawAuto();
+    DrawParticles(deviceContext, effect.SetRenderDefault(), effect);
 }
 
 void ParticleManager::DrawWithSmoke(ID3D11DeviceContext* deviceContext, ParticleEffect& effect)
@@ -198,60 +455,50 @@ void ParticleManager::DrawWithSmoke(ID3D11DeviceContext* deviceContext, Particle
     effect.SetTextureSmokeParticle(nullptr);
 
 
-    deviceContext->Begin(pQuery.Get());
-
-    // ******************
-    // 流输出
-    //
-    // 如果是第一次运行，使用初始顶点缓冲区
-    // 否则，使用存有当前所有粒子的顶点缓冲区
-    effect.RenderToVertexBuffer(deviceContext,
-        m_FirstRun ? m_pInitVB.Get() : m_pDrawVB.Get(),
-        m_pStreamOutVB.Get(),
-        m_FirstRun);
-    // 后续转为DrawAuto
-    m_FirstRun = 0;
-
-    deviceContext->End(pQuery.Get());
-
-    D3D11_QUERY_DATA_SO_STATISTICS soStats;
-    while (deviceContext->GetData(pQuery.Get(), &soStats, sizeof(soStats), 0) != S_OK) {
-        ;
+    if (m_CpuSimEnabled)
+    {
+        // 粒子数目已在Update中得到
+        if (!m_Offscreen)
+            UploadCpuParticles(deviceContext);
     }
-
-    uint64_t numPrimitiveWritten = soStats.NumPrimitivesWritten;
-
-
-    // 进行顶点缓冲区的Ping-Pong交换
-    m_pDrawVB.Swap(m_pStreamOutVB);
-
-    deviceContext->CopyResource(m_pStagingBuffer.Get(), m_pDrawVB.Get());
-
-    // 获取粒子个数
-    D3D11_MAPPED_SUBRESOURCE mappedResoure;
-    deviceContext->Map(m_pStagingBuffer.Get(), 0, D3D11_MAP_READ, 0, &mappedResoure);
-
-    ParticleEffect::VertexParticle *pData = (ParticleEffect::VertexParticle*)mappedResoure.pData;
-
-// FIXME:临时使用
-#define PT_EMITTER 0
-#define PT_PARTICLE 1
-#define PT_SHELL 2
-#define PT_SMOKE 3
-    uint32_t defaultParticle = 0;
-    uint32_t smokeParticle = 0;
-    for (int i = 0; i < numPrimitiveWritten; ++i) {
-        if (pData->type == PT_PARTICLE) {
-            defaultParticle++;
-        } else if (pData->type == PT_SMOKE) {
-            smokeParticle++;
-        }
-        pData++;
+    else
+    {
+        // 槽位用尽(GPU落后太多)时本帧不回读，不等待
+        uint32_t slot = m_Readback.Begin(m_ReadbackFrame++);
+
+        // ******************
+        // 流输出
+        //
+        // 如果是第一次运行，使用初始顶点缓冲区
+        // 否则，使用存有当前所有粒子的顶点缓冲区
+        effect.RenderToVertexBuffer(deviceContext,
+            m_FirstRun ? m_pInitVB.Get() : m_pDrawVB.Get(),
+            m_pStreamOutVB.Get(),
+            m_FirstRun);
+        // 后续转为DrawAuto
+        m_FirstRun = 0;
+
+        // 进行顶点缓冲区的Ping-Pong交换
+        m_pDrawVB.Swap(m_pStreamOutVB);
+
+        m_pReadbackBackend->SetSource(m_pDrawVB.Get());
+        m_Readback.End(slot);
+
+        // 获取粒子个数：使用已完成的回读中最新的一个，发射上限因此落后几帧
+        m_Readback.Poll([this](uint64_t, const ReadbackView& view) {
+            const ParticleEffect::VertexParticle* pData = static_cast<const ParticleEffect::VertexParticle*>(view.data);
+            const uint32_t vertexCount = view.byteSize / sizeof(ParticleEffect::VertexParticle);
+
+            uint32_t defaultParticle = 0;
+            uint32_t smokeParticle = 0;
+            for (uint32_t i = 0; i < vertexCount; ++i)
+            {
+                defaultParticle += pData[i].type == PT_PARTICLE;
+                smokeParticle += pData[i].type == PT_SMOKE;
+            }
+            SetParticleCount(defaultParticle, smokeParticle);
+        });
     }
-    
-    deviceContext->Unmap(m_pStagingBuffer.Get(), 0);
-
-    SetParticleCount(defaultParticle, smokeParticle);
 
     // ******************
     // 使用流输出顶点绘制粒子
@@ -259,30 +506,19 @@ void ParticleManager::DrawWithSmoke(ID3D11DeviceContext* deviceContext, Particle
 
     deviceContext->ClearRenderTargetView(pRTVs[0], reinterpret_cast<float*>(&m_BgColor));
     deviceContext->OMSetRenderTargets(1, pRTVs, nullptr);
-    auto inputData = effect.SetRenderSmoke();
-    deviceContext->IASetPrimitiveTopology(inputData.topology);
-    deviceContext->IASetInputLayout(inputData.pInputLayout);
-    deviceContext->IASetVertexBuffers(0, 1, m_pDrawVB.GetAddressOf(), &inputData.stride, &inputData.offset);
-    effect.Apply(deviceContext);
-    deviceContext->DrawAuto();
-
+    DrawParticles(deviceContext, effect.SetRenderSmoke(), effect);
 
     pRTVs[0] = pDefaultParticleTexture->GetRenderTarget();
     deviceContext->ClearRenderTargetView(pRTVs[0], reinterpret_cast<float*>(&m_BgColor));
     deviceContext->OMSetRenderTargets(1, pRTVs, nullptr);
-    inputData = effect.SetRenderDefault();
-    deviceContext->IASetPrimitiveTopology(inputData.topology);
-    deviceContext->IASetInputLayout(inputData.pInputLayout);
-    deviceContext->IASetVertexBuffers(0, 1, m_pDrawVB.GetAddressOf(), &inputData.stride, &inputData.offset);
-    effect.Apply(deviceContext);
-    deviceContext->DrawAuto();
+    DrawParticles(deviceContext, effect.SetRenderDefault(), effect);
 
     effect.SetTextureDefaultParticle(pDefaultParticleTexture->GetShaderResource());
     effect.SetTextureSmokeParticle(pSmokeParticleTexture->GetShaderResource());
     pRTVs[0] = pCurrBackBuffer;
     deviceContext->ClearRenderTargetView(pRTVs[0], reinterpret_cast<float*>(&m_BgColor));
     deviceContext->OMSetRenderTargets(1, pRTVs, nullptr);
-    inputData = effect.SetRenderToBackBuffer();
+    auto inputData = effect.SetRenderToBackBuffer();
     deviceContext->IASetPrimitiveTopology(inputData.topology);
     deviceContext->IASetInputLayout(inputData.pInputLayout);
     deviceContext->IASetIndexBuffer(m_pIndexBuffer.Get(), DXGI_FORMAT_R32_UINT, 0);
@@ -291,6 +527,66 @@ void ParticleManager::DrawWithSmoke(ID3D11DeviceContext* deviceContext, Particle
     deviceContext->DrawIndexed(6, 0, 0);
 }
 
+void ParticleManager::DrawParticles(ID3D11DeviceContext* deviceContext, const ParticleEffect::InputData& inputData, ParticleEffect& effect)
+{
+    // 渲染目标已清空，整个系统不可见时不产生任何图元
+    if (m_Offscreen)
+        return;
+    deviceContext->IASetPrimitiveTopology(inputData.topology);
+    deviceContext->IASetInputLayout(inputData.pInputLayout);
+    if (m_CpuSimEnabled)
+    {
+        deviceContext->IASetVertexBuffers(0, 1, m_pCpuDrawVB.GetAddressOf(), &inputData.stride, &inputData.offset);
+        effect.Apply(deviceContext);
+        if (m_CpuDepthSort)
+        {
+            // 只绘制排好序的粒子，发射器不产生图元
+            deviceContext->IASetIndexBuffer(m_pCpuDrawIB.Get(), DXGI_FORMAT_R32_UINT, 0);
+            deviceContext->DrawIndexed(m_CpuIndexCount, 0, 0);
+        }
+        else
+        {
+            deviceContext->Draw(m_CpuVertexCount, 0);
+        }
+    }
+    else
+    {
+        deviceContext->IASetVertexBuffers(0, 1, m_pDrawVB.GetAddressOf(), &inputData.stride, &inputData.offset);
+        effect.Apply(deviceContext);
+        deviceContext->DrawAuto();
+    }
+}
+
+void ParticleManager::UploadCpuParticles(ID3D11DeviceContext* deviceContext)
+{
+    // SoA数据直接打包写入映射的缓冲区
+    D3D11_MAPPED_SUBRESOURCE mappedData;
+    HR(deviceContext->Map(m_pCpuDrawVB.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedData));
+    if (m_CpuFrustumCull)
+    {
+        // 只写入可见的粒子，发射器不产生图元，无需写入
+        // 排序的下标为粒子在可见列表中的位置，即缓冲区中的位置
+        m_CpuVertexCount = std::min(m_CpuCuller.GetVisibleCount(), m_MaxParticles);
+        m_pCpuSim->ExportVertices(m_CpuCuller.GetEvalIndices(), m_CpuVertexCount,
+            reinterpret_cast<ParticleVertex*>(mappedData.pData));
+    }
+    else
+    {
+        m_CpuVertexCount = m_pCpuSim->ExportVertices(
+            reinterpret_cast<ParticleVertex*>(mappedData.pData), m_MaxParticles);
+    }
+    deviceContext->Unmap(m_pCpuDrawVB.Get(), 0);
+
+    if (m_CpuDepthSort)
+    {
+        // 下标与写入顶点缓冲区的顺序一致
+        m_CpuIndexCount = std::min(m_CpuSorter.GetCount(), m_CpuVertexCount);
+        HR(deviceContext->Map(m_pCpuDrawIB.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedData));
+        std::memcpy(mappedData.pData, m_CpuSorter.GetIndices(), sizeof(uint32_t) * m_CpuIndexCount);
+        deviceContext->Unmap(m_pCpuDrawIB.Get(), 0);
+    }
+}
+
 std::pair<uint32_t, uint32_t> ParticleManager::GetParticleCount(void)
 {
     return {m_DefaultParticleCount, m_SmokeParticleCount};
@@ -308,6 +604,8 @@ void ParticleManager::SetDebugObjectName(const std::string& name)
     ::SetDebugObjectName(m_pInitVB.Get(), name + ".InitVB");
     ::SetDebugObjectName(m_pStreamOutVB.Get(), name + ".StreamVB");
     ::SetDebugObjectName(m_pDrawVB.Get(), name + ".DrawVB");
+    if (m_pCpuDrawVB)
+        ::SetDebugObjectName(m_pCpuDrawVB.Get(), name + ".CpuDrawVB");
 #else
     UNREFERENCED_PARAMETER(name);
 #endif
@@ -10,9 +10,20 @@
 #define PARTICLE_MANAGER_H
 
 #include <utility>
+#include <memory>
+#include <DirectXCollision.h>
 #include "Effects.h"
 #include "Camera.h"
 #include "Texture2D.h"
+#include <ParticleSimCPU.h>
+#include <ParticleSort.h>
+#include <ParticleCull.h>
+#include <ParticleEmitterGrid.h>
+#include <ParticleStepClock.h>
+#include <ParticleStateHash.h>
+#include <JobSystem.h>
+#include <ReadbackRing.h>
+#include "StreamOutReadback.h"
 
 class ParticleManager
 {
@@ -44,11 +55,61 @@ public:
     void SetTextureRandom(ID3D11ShaderResourceView* randomTexSRV);
     void SetTextureAsh(ID3D11ShaderResourceView* textureAsh);
 
+    // CPU模拟路径：由ParticleSimCPU更新粒子，绘制时上传到动态顶点缓冲区，不再使用流输出
+    // CPU模拟使用计数器随机数而非随机纹理，seed决定其全部随机结果
+    void InitCpuSimulation(ID3D11Device* device, ParticleEffectType effectType, uint64_t seed = 0);
+    void SetCpuSimulationEnabled(bool enabled);
+    bool IsCpuSimulationEnabled() const;
+    // 仅对CPU模拟生效，流输出路径始终每帧至多发射一个粒子
+    void SetCpuEmissionMode(EmissionMode mode);
+    void SetCpuStorageMode(ParticleStorageMode mode);
+    // CPU模拟的子发射器，FireSmoke默认带有产生烟雾的一个
+    void AddCpuSubEmitter(const SubEmitterDesc& desc);
+    void ClearCpuSubEmitters();
+    void SetCpuSubEmitterBudget(uint32_t budget);
+    // CPU模拟的附加发射器：共用本系统的参数与粒子存储，每帧成批发射，返回发射器序号
+    uint32_t AddCpuEmitter(const ParticleEmitterDesc& desc);
+    void SetCpuEmitterPos(uint32_t index, const DirectX::XMFLOAT3& pos);
+    void SetCpuEmitterEnabled(uint32_t index, bool enabled);
+    void ClearCpuEmitters();
+    // 发射器表较大时按相机距离与视锥体只启用附近的发射器(相机取自SetView)，停用的发射器重新启用时补发其间的粒子
+    // 之后由网格决定各发射器的启用状态，增删或移动发射器后需重新调用
+    void BuildCpuEmitterGrid(float cellSize, float activateDistance, float deactivateDistance);
+    // CPU模拟以固定步长step推进，与绘制的帧率无关，单帧至多追赶maxSteps步，step不大于0时恢复每帧一步
+    // 绘制时按剩余的时间在最近两步之间插值，如30Hz模拟、144Hz绘制
+    void SetCpuFixedStep(float step, uint32_t maxSteps = 4);
+    // CPU模拟的结果与任务系统的线程数无关；开启后每一步模拟后记录状态散列，用于离线烘焙与回归比对
+    // 设置参考序列(如另一次运行的GetLog())后逐帧比较，HasDiverged给出第一次不一致的帧，Reset时清空记录
+    void SetCpuStateHashEnabled(bool enabled);
+    ParticleStateChecker& GetCpuStateChecker() { return m_CpuStateChecker; }
+    // CPU模拟时按视深从远到近绘制，用于与绘制顺序有关的混合状态(烟雾等)
+    // 排序在Update中进行，使用最近一次SetView设置的视图矩阵
+    void SetCpuDepthSortEnabled(bool enabled);
+    // Coherent沿用上一帧的顺序并修复，适合粒子与相机移动缓慢的场景
+    void SetCpuDepthSortMode(ParticleSortMode mode);
+    // CPU模拟时剔除视锥体外的粒子，之后的排序与上传只处理可见的粒子
+    // 同时开启排序时总是对可见粒子做完整的基数排序
+    void SetCpuFrustumCullingEnabled(bool enabled);
+    // 设置排序与剔除使用的相机，整个系统的包围盒在视锥体外时跳过其绘制
+    void SetView(DirectX::FXMMATRIX view, DirectX::CXMMATRIX proj);
+
+    // 整个系统(含公告板)的保守包围盒，由参数解析求出，两种模拟路径均可用
+    // 没有粒子时返回false，未初始化CPU模拟时返回无穷大的包围盒
+    bool GetBoundingBox(DirectX::BoundingBox& box) const;
+    // 最近一次Update时整个系统在视锥体外，跳过上传与绘制(流输出路径仍然模拟)
+    bool IsOffscreen() const;
+
     void Reset();
-    void Update(float dt, float gameTime);
+    // CPU模拟时直接重建重置后经过time秒(以dt为帧间隔)时的粒子，用于预热与时间轴跳转，流输出路径不支持
+    void SeekCpuSimulation(float time, float dt, JobSystem* jobs = nullptr);
+    void PrewarmCpuSimulation(float seconds, float dt, JobSystem* jobs = nullptr);
+    // 启用CPU模拟时可传入任务系统按块并行更新
+    void Update(float dt, float gameTime, JobSystem* jobs = nullptr);
     void Draw(ID3D11DeviceContext* deviceContext, ParticleEffect& effect);
     void DrawWithSmoke(ID3D11DeviceContext* deviceContext, ParticleEffect& effect);
 
+    // PT_PARTICLE/PT_SMOKE的数目，CPU模拟时在Update后即为当前值
+    // 流输出路径则来自DrawWithSmoke发起的异步回读，落后若干帧
     std::pair<uint32_t, uint32_t> GetParticleCount(void);
 
     void SetBgColor(DirectX::XMFLOAT4 color);
@@ -60,6 +121,11 @@ public:
 
     ID3D11RenderTargetView *pCurrBackBuffer = nullptr;
 private:
+    // 绑定当前粒子顶点并绘制，SO路径使用DrawAuto，CPU路径使用Draw
+    void DrawParticles(ID3D11DeviceContext* deviceContext, const ParticleEffect::InputData& inputData, ParticleEffect& effect);
+    // 将CPU模拟结果写入m_pCpuDrawVB，排序时同时写入绘制顺序m_pCpuDrawIB
+    // 剔除时只按原顺序写入可见的粒子，排序结果即为其绘制顺序
+    void UploadCpuParticles(ID3D11DeviceContext* deviceContext);
     
     uint32_t m_MaxParticles = 0;
     int m_FirstRun = 1;
@@ -85,13 +151,42 @@ private:
     ComPtr<ID3D11Buffer> m_pStreamOutVB;
     ComPtr<ID3D11Buffer> m_pFullScreenVB;
     ComPtr<ID3D11Buffer> m_pIndexBuffer;
-    ComPtr<ID3D11Buffer> m_pStagingBuffer;
-    ComPtr<ID3D11Query> pQuery;
+
+    // 流输出路径的粒子数回读，结果延迟若干帧交付
+    static constexpr uint32_t ReadbackSlotCount = 3;
+    std::unique_ptr<StreamOutReadback> m_pReadbackBackend;
+    ReadbackRing m_Readback;
+    uint64_t m_ReadbackFrame = 0;
 
     ComPtr<ID3D11ShaderResourceView> m_pTextureInputSRV;
     ComPtr<ID3D11ShaderResourceView> m_pTextureRanfomSRV;
     ComPtr<ID3D11ShaderResourceView> m_pTextureAshSRV;
 
+    std::unique_ptr<ParticleSimCPU> m_pCpuSim;
+    ComPtr<ID3D11Buffer> m_pCpuDrawVB;                                            // CPU模拟结果(动态缓冲区)
+    uint32_t m_CpuVertexCount = 0;
+    bool m_CpuSimEnabled = false;
+
+    ParticleDepthSorter m_CpuSorter;
+    ParticleDepthPlane m_CpuDepthPlane;
+    ComPtr<ID3D11Buffer> m_pCpuDrawIB;                                            // 从远到近的绘制顺序(动态缓冲区)
+    uint32_t m_CpuIndexCount = 0;
+    bool m_CpuDepthSort = false;
+    ParticleSortMode m_CpuSortMode = ParticleSortMode::Radix;
+
+    ParticleFrustumCuller m_CpuCuller;
+    ParticleFrustum m_ViewFrustum;
+    bool m_CpuFrustumCull = false;
+    bool m_Offscreen = false;
+
+    ParticleEmitterGrid m_CpuEmitterGrid;
+    ParticleActivationView m_CpuActivation;
+    bool m_CpuEmitterGridEnabled = false;
+
+    ParticleStepClock m_CpuStepClock;
+    ParticleStateChecker m_CpuStateChecker;
+    bool m_CpuStateHash = false;
+
 };
 
 #endif
@@ -68,6 +68,8 @@ float3 RandVec3(float offset)
 #define PT_SHELL 2
 #define PT_SMOKE 3
 
+// 语义、类型与顺序须与ParticleSim/ParticleSchema.h中的ParticleVertexSchema一致
+// 输入布局与流输出声明均由后者生成，不一致时创建着色器会失败
 struct VertexParticle
 {
     float3 initialPosW : POSITION;
@@ -0,0 +1,84 @@
+#include "StreamOutReadback.h"
+#include <algorithm>
+#include <DXTrace.h>
+
+void StreamOutReadback::Init(ID3D11Device* device, uint32_t slotCount, uint32_t vertexStride, uint32_t maxVertices)
+{
+    device->GetImmediateContext(m_pContext.ReleaseAndGetAddressOf());
+    m_VertexStride = vertexStride;
+    m_MaxVertices = maxVertices;
+    m_Slots.clear();
+    m_Slots.resize(slotCount);
+
+    D3D11_BUFFER_DESC bufferDesc = {};
+    bufferDesc.Usage = D3D11_USAGE_STAGING;
+    bufferDesc.ByteWidth = vertexStride * maxVertices;
+    bufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+
+    // 使用查询对象获取顶点个数
+    D3D11_QUERY_DESC queryDesc = {};
+    queryDesc.Query = D3D11_QUERY_SO_STATISTICS;
+
+    for (Slot& slot : m_Slots)
+    {
+        HR(device->CreateBuffer(&bufferDesc, nullptr, slot.staging.GetAddressOf()));
+        HR(device->CreateQuery(&queryDesc, slot.query.GetAddressOf()));
+    }
+}
+
+void StreamOutReadback::Begin(uint32_t slot)
+{
+    Slot& s = m_Slots[slot];
+    s.queryDone = false;
+    m_pContext->Begin(s.query.Get());
+}
+
+void StreamOutReadback::End(uint32_t slot)
+{
+    Slot& s = m_Slots[slot];
+    m_pContext->End(s.query.Get());
+    m_pContext->CopyResource(s.staging.Get(), m_pSource);
+}
+
+bool StreamOutReadback::IsReady(uint32_t slot)
+{
+    Slot& s = m_Slots[slot];
+    if (!s.queryDone)
+    {
+        D3D11_QUERY_DATA_SO_STATISTICS soStats;
+        if (m_pContext->GetData(s.query.Get(), &soStats, sizeof(soStats), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK)
+            return false;
+        s.vertexCount = soStats.NumPrimitivesWritten;
+        s.queryDone = true;
+    }
+
+    // 查询在复制之前结束，复制是否完成需要单独确认
+    if (!s.mapped)
+    {
+        HRESULT hr = m_pContext->Map(s.staging.Get(), 0, D3D11_MAP_READ, D3D11_MAP_FLAG_DO_NOT_WAIT, &s.mappedData);
+        if (FAILED(hr))
+            return false;
+        s.mapped = true;
+    }
+    return true;
+}
+
+bool StreamOutReadback::Map(uint32_t slot, ReadbackView& view)
+{
+    Slot& s = m_Slots[slot];
+    if (!s.mapped)
+        return false;
+    view.data = s.mappedData.pData;
+    view.byteSize = static_cast<uint32_t>(std::min<uint64_t>(s.vertexCount, m_MaxVertices)) * m_VertexStride;
+    return true;
+}
+
+void StreamOutReadback::Unmap(uint32_t slot)
+{
+    Slot& s = m_Slots[slot];
+    if (s.mapped)
+    {
+        m_pContext->Unmap(s.staging.Get(), 0);
+        s.mapped = false;
+    }
+}
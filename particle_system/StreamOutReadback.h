@@ -0,0 +1,55 @@
+//***************************************************************************************
+// StreamOutReadback.h
+//
+// 流输出结果的异步回读：每个槽位一个SO统计查询与一个暂存缓冲区
+// Asynchronous stream-out readback: one SO statistics query and one staging buffer
+// per slot.
+//***************************************************************************************
+
+#ifndef STREAM_OUT_READBACK_H
+#define STREAM_OUT_READBACK_H
+
+#include <vector>
+#include <wrl/client.h>
+#include "WinMin.h"
+#include <d3d11_1.h>
+#include <ReadbackRing.h>
+
+// Begin/End之间的流输出写入的顶点数由查询得到，End时将源缓冲区复制到暂存缓冲区
+// 判断是否完成与映射都使用不等待的标志，不会阻塞CPU
+class StreamOutReadback : public ReadbackBackend
+{
+public:
+    template<class T>
+    using ComPtr = Microsoft::WRL::ComPtr<T>;
+
+    // 查询与复制都在设备的立即上下文上进行
+    void Init(ID3D11Device* device, uint32_t slotCount, uint32_t vertexStride, uint32_t maxVertices);
+    // 本次要回读的缓冲区，需在End之前设置
+    void SetSource(ID3D11Buffer* buffer) { m_pSource = buffer; }
+
+    void Begin(uint32_t slot) override;
+    void End(uint32_t slot) override;
+    bool IsReady(uint32_t slot) override;
+    bool Map(uint32_t slot, ReadbackView& view) override;
+    void Unmap(uint32_t slot) override;
+
+private:
+    struct Slot
+    {
+        ComPtr<ID3D11Query> query;
+        ComPtr<ID3D11Buffer> staging;
+        uint64_t vertexCount = 0;
+        bool queryDone = false;
+        bool mapped = false;
+        D3D11_MAPPED_SUBRESOURCE mappedData = {};
+    };
+
+    std::vector<Slot> m_Slots;
+    ComPtr<ID3D11DeviceContext> m_pContext;
+    ID3D11Buffer* m_pSource = nullptr;
+    uint32_t m_VertexStride = 0;
+    uint32_t m_MaxVertices = 0;
+};
+
+#endif